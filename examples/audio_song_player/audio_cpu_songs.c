@@ -0,0 +1,12 @@
+#include <stdint.h>
+#include <songplayer/songplayer.h>
+
+// the songs the audio co-processor can play, by number (see firmware/audio_cpu/main.c)
+
+extern const struct packed_song_t song_pacman;
+
+const struct packed_song_t *const audio_cpu_songs[] = {
+  &song_pacman,
+};
+
+const uint32_t audio_cpu_num_songs = sizeof(audio_cpu_songs) / sizeof(audio_cpu_songs[0]);
@@ -18,7 +18,23 @@ extern uint32_t sram;
 
 extern uint32_t _sidata, _sdata, _edata, _sbss, _ebss, _heap_start;
 
-extern const struct song_t song_pacman;
+extern const struct packed_song_t song_pacman;
+
+#ifdef AUDIO_CPU
+// the audio co-processor's program (built by firmware/audio_cpu/audio_cpu.mk), which it runs from flash
+extern const uint8_t audio_cpu_firmware[];
+#endif
+
+#ifdef SEQUENCER
+// the song, and one of its bars as a sound effect, for the audio sequencer (made by tools/songseq)
+extern const struct audio_sequence_t song_pacman_sequence;
+extern const struct audio_sequence_t song_pacman_effect_3;
+#endif
+
+// the song plays from the timer IRQ, unless the co-processor or the sequencer plays it
+#if !defined(AUDIO_CPU) && !defined(SEQUENCER)
+#define SONGPLAYER_IRQ
+#endif
 
 uint32_t counter_frequency = 16000000/50;  /* 50 times per second */
 uint32_t led_state = 0x00000000;
@@ -37,6 +53,19 @@ uint32_t set_timer_counter(uint32_t val); asm (
     "ret\n"
 );
 
+// the timer counts down once per clock, so reading it either side of the
+// song player gives the number of cycles it took (setting it to zero
+// and back again only loses a couple of clocks)
+uint32_t read_timer_counter() {
+  uint32_t count = set_timer_counter(0);
+  set_timer_counter(count);
+  return count;
+}
+
+// cycles spent in songplayer_tick, by the last tick, and the slowest one so far
+volatile uint32_t songplayer_cycles = 0;
+volatile uint32_t songplayer_cycles_max = 0;
+
 void setup_screen() {
   print("Vid init..\n");
 
@@ -98,7 +127,14 @@ void irq_handler(uint32_t irqs, uint32_t* regs)
 
     led_state = led_state ^ 0x01;
     reg_leds = led_state;
+#ifdef SONGPLAYER_IRQ
+    uint32_t start = read_timer_counter();
     songplayer_tick();
+    songplayer_cycles = start - read_timer_counter();
+    if (songplayer_cycles > songplayer_cycles_max) {
+      songplayer_cycles_max = songplayer_cycles;
+    }
+#endif
   }
 
 }
@@ -110,11 +146,23 @@ void main() {
     print("Enabling IRQs..\n");
     set_irq_mask(0x00);
 
+#ifndef AUDIO_CPU
+    // (the co-processor build has no video: see the Makefile)
     print("Setting up screen..\n");
     setup_screen();
-
+#endif
+
+#ifdef AUDIO_CPU
+    print("Starting the audio co-processor..\n");
+    audio_cpu_load(audio_cpu_firmware);
+    audio_cpu_play(0);
+#elif defined(SEQUENCER)
+    print("Starting the audio sequencer..\n");
+    audio_sequencer_play(0, &song_pacman_sequence);
+#else
     print("Initialising song player..\n");
     songplayer_init(&song_pacman);
+#endif
 
     print("Switching to dual IO SPI mode..\n");
 
@@ -160,5 +208,26 @@ void main() {
           }
           sprite_pos++;
         }
+#ifdef SONGPLAYER_IRQ
+        if ((time_waster & 0x3ffff) == 0) {
+          print("songplayer_tick cycles: ");
+          print_hex(songplayer_cycles, 8);
+          print(" max: ");
+          print_hex(songplayer_cycles_max, 8);
+          print(" register writes: ");
+          print_hex(audio_shadow_stats.last_written, 4);
+          print(" saved: ");
+          print_hex(audio_shadow_stats.last_requested - audio_shadow_stats.last_written, 4);
+          print(" (total ");
+          print_hex(audio_shadow_stats.requested - audio_shadow_stats.written, 8);
+          print(")\n");
+        }
+#endif
+#ifdef SEQUENCER
+        // the sound effect plays on the sequencer's other track, over the music
+        if ((time_waster & 0xfffff) == 0) {
+          audio_sequencer_play(1, &song_pacman_effect_3);
+        }
+#endif
     }
 }
@@ -0,0 +1,346 @@
+// converted from song_pacman by tools/songseq - do not edit
+#include <stddef.h>
+#include <audio/audio.h>
+
+// song_pacman: 512 ticks, then a loop of 512 ticks (10.2s)
+// 314 words (1256 bytes of flash), 213 writes
+static const uint32_t song_pacman_sequence_program[] = {
+  SEQ_WRITE(0x018), 0x00000000,   // voice 0 MIX
+  SEQ_WRITE(0x038), 0x00000000,   // voice 1 MIX
+  SEQ_WRITE(0x058), 0x00000000,   // voice 2 MIX
+  SEQ_WRITE(0x078), 0x00000000,   // voice 3 MIX
+  SEQ_WRITE(0x098), 0x00000000,   // voice 4 MIX
+  SEQ_WRITE(0x0b8), 0x00000000,   // voice 5 MIX
+  SEQ_WRITE(0x0d8), 0x00000000,   // voice 6 MIX
+  SEQ_WRITE(0x218), 0x000100ff,   // FILTER
+  SEQ_WAIT(1),
+  SEQ_WRITE(0x000), 0x0000102e,   // voice 0 FREQ
+  SEQ_WRITE(0x004), 0x00000190,   // voice 0 PULSEWIDTH
+  SEQ_WRITE(0x008), 0x08030000,   // voice 0 WAVEPARAMS
+  SEQ_WRITE(0x00c), 0x000000b4,   // voice 0 VOLUME
+  SEQ_WRITE(0x010), 0x00036062,   // voice 0 ENVELOPE
+  SEQ_WRITE(0x014), 0x00000000,   // voice 0 LFO
+  SEQ_WRITE(0x020), 0x00000817,   // voice 1 FREQ
+  SEQ_WRITE(0x024), 0x00000190,   // voice 1 PULSEWIDTH
+  SEQ_WRITE(0x028), 0x08030000,   // voice 1 WAVEPARAMS
+  SEQ_WRITE(0x02c), 0x000000b4,   // voice 1 VOLUME
+  SEQ_WRITE(0x030), 0x00036062,   // voice 1 ENVELOPE
+  SEQ_WRITE(0x034), 0x00000000,   // voice 1 LFO
+  SEQ_WRITE(0x054), 0x00000000,   // voice 2 LFO
+  SEQ_WRITE(0x074), 0x00000000,   // voice 3 LFO
+  SEQ_WRITE(0x094), 0x00000000,   // voice 4 LFO
+  SEQ_WRITE(0x0b4), 0x00000000,   // voice 5 LFO
+  SEQ_WRITE(0x0d4), 0x00000000,   // voice 6 LFO
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x205d),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x183f),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x1463),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_HALF(0x020, 0x0c1f),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x205d),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_HALF(0x020, 0x0817),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x183f),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x102e),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x1463),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x020, 0x0cd8),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x1125),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_HALF(0x020, 0x0892),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x224a),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x19b0),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x159a),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_HALF(0x020, 0x0cd8),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x224a),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_HALF(0x020, 0x0892),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x19b0),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x1125),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x159a),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x020, 0x0c1f),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x102e),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_HALF(0x020, 0x0817),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x205d),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x183f),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x1463),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_HALF(0x020, 0x0c1f),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x205d),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_HALF(0x020, 0x0817),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x183f),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x102e),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x1463),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x020, 0x0c1f),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x159a),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x16e2),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_BYTE(0x020, 0xd8),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x183f),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x19b0),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_HALF(0x020, 0x0e6a),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x1b37),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x1cd5),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x205d),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_HALF(0x020, 0x102e),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(272),
+  // loop
+  SEQ_WRITE_HALF(0x000, 0x102e),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_HALF(0x020, 0x0817),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x205d),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x183f),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x1463),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_HALF(0x020, 0x0c1f),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x205d),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_HALF(0x020, 0x0817),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x183f),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x102e),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x1463),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x020, 0x0cd8),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x1125),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_HALF(0x020, 0x0892),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x224a),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x19b0),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x159a),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_HALF(0x020, 0x0cd8),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x224a),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_HALF(0x020, 0x0892),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x19b0),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x1125),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x159a),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x020, 0x0c1f),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x102e),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_HALF(0x020, 0x0817),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x205d),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x183f),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x1463),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_HALF(0x020, 0x0c1f),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x205d),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_HALF(0x020, 0x0817),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x183f),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x102e),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x1463),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x020, 0x0c1f),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x159a),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x16e2),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_BYTE(0x020, 0xd8),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x183f),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x19b0),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_HALF(0x020, 0x0e6a),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x1b37),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x000, 0x1cd5),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x000, 0x205d),   // voice 0 FREQ
+  SEQ_WRITE_BYTE(0x012, 0x03),   // voice 0 ENVELOPE
+  SEQ_WRITE_HALF(0x020, 0x102e),   // voice 1 FREQ
+  SEQ_WRITE_BYTE(0x032, 0x03),   // voice 1 ENVELOPE
+  SEQ_WAIT(272),
+  SEQ_END,
+};
+
+const struct audio_sequence_t song_pacman_sequence = {
+  .program = song_pacman_sequence_program,
+  .loop = song_pacman_sequence_program + 180
+};
+
+// bar 3 of song_pacman, on voice 7: 65 ticks
+// 40 words (160 bytes of flash), 23 writes
+static const uint32_t song_pacman_effect_3_program[] = {
+  SEQ_WRITE(0x0e0), 0x00001463,   // voice 7 FREQ
+  SEQ_WRITE(0x0e4), 0x00000190,   // voice 7 PULSEWIDTH
+  SEQ_WRITE(0x0e8), 0x08030000,   // voice 7 WAVEPARAMS
+  SEQ_WRITE(0x0ec), 0x000000b4,   // voice 7 VOLUME
+  SEQ_WRITE(0x0f0), 0x00036062,   // voice 7 ENVELOPE
+  SEQ_WRITE(0x0f4), 0x00000000,   // voice 7 LFO
+  SEQ_WRITE(0x0f8), 0x00000000,   // voice 7 MIX
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x0e0, 0x159a),   // voice 7 FREQ
+  SEQ_WRITE_BYTE(0x0f2, 0x03),   // voice 7 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x0e0, 0x16e2),   // voice 7 FREQ
+  SEQ_WRITE_BYTE(0x0f2, 0x03),   // voice 7 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_BYTE(0x0f2, 0x03),   // voice 7 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x0e0, 0x183f),   // voice 7 FREQ
+  SEQ_WRITE_BYTE(0x0f2, 0x03),   // voice 7 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x0e0, 0x19b0),   // voice 7 FREQ
+  SEQ_WRITE_BYTE(0x0f2, 0x03),   // voice 7 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_BYTE(0x0f2, 0x03),   // voice 7 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x0e0, 0x1b37),   // voice 7 FREQ
+  SEQ_WRITE_BYTE(0x0f2, 0x03),   // voice 7 ENVELOPE
+  SEQ_WAIT(4),
+  SEQ_WRITE_HALF(0x0e0, 0x1cd5),   // voice 7 FREQ
+  SEQ_WRITE_BYTE(0x0f2, 0x03),   // voice 7 ENVELOPE
+  SEQ_WAIT(8),
+  SEQ_WRITE_HALF(0x0e0, 0x205d),   // voice 7 FREQ
+  SEQ_WRITE_BYTE(0x0f2, 0x03),   // voice 7 ENVELOPE
+  SEQ_END,
+};
+
+const struct audio_sequence_t song_pacman_effect_3 = {
+  .program = song_pacman_effect_3_program,
+  .loop = NULL
+};
@@ -2,38 +2,6 @@
 #include "songplayer.h"
 #include "audio.h"
 
-const struct envelope_t envelope0 = {
-  .num_points = 16,
-  .points = {
-    0x00, 0xff, 0xff, 0x80, 0x20, 0x10, 0x08, 0x04,
-    0x02, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
-  }
-};
-
-const struct envelope_t envelope1 = {
-  .num_points = 16,
-  .points = {
-    0x10, 0xb0, 0xb4, 0xa0, 0x80, 0x60, 0x40, 0x30,
-    0x20, 0x10, 0x08, 0x04, 0x03, 0x02, 0x01, 0x00
-  }
-};
-
-const struct envelope_t envelope2 = {
-  .num_points = 16,
-  .points = {
-    0x80, 0x60, 0x40, 0x20, 0x10, 0x08, 0x02, 0x02,
-    0x1, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
-  }
-};
-
-const struct envelope_t envelope3 = {
-  .num_points = 16,
-  .points = {
-    0xff, 0xff, 0xc0, 0x80, 0x40, 0x20, 0x10, 0x00,
-    0x0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
-  }
-};
-
 // notes
 // octave   C  C#   D  D#   E   F   F#   G   G#    A   A#   B
 //     -2   1   2   3   4   5   6    7   8    9   10   11  12
@@ -54,14 +22,14 @@ const struct song_t song_petergun = {
   .ticks_per_div = 6,
   .pattern_map = { 0,0,0,0,1,1,0,0,2,1,0,0, 3,3,3,3,4,4,3,3,5,4,3,3 }, // ,3,6,3,6,4,7,3,6,5,7,3,6 },
   .instruments = {
-      {.waveform_select = WAVE_NONE, .envelope = &envelope1, .envelope_enable=1, .pulsewidth = 2048},  // 0 = no instrument
-      {.waveform_select = WAVE_NONE, .envelope = &envelope0, .envelope_enable=1, .pulsewidth = 2048},  // 1 = kick drum
-      {.waveform_select = WAVE_NONE, .envelope = &envelope2, .envelope_enable=1, .pulsewidth = 2048},  // 2 = closed hihat
-      {.waveform_select = WAVE_NONE, .envelope = &envelope2, .envelope_enable=1, .pulsewidth = 2048},  // 3 = open hihat
-      {.waveform_select = WAVE_NONE, .envelope = &envelope3, .envelope_enable=1, .pulsewidth = 2048},  // 4 = snare
+      {.waveform_select = WAVE_NONE, .envelope_enable=1, .attack=2, .decay=6, .sustain=0, .release=6, .default_volume=180, .pulsewidth = 2048},  // 0 = no instrument
+      {.waveform_select = WAVE_NONE, .envelope_enable=1, .attack=1, .decay=4, .sustain=0, .release=4, .default_volume=255, .pulsewidth = 2048},  // 1 = kick drum
+      {.waveform_select = WAVE_NONE, .envelope_enable=1, .attack=0, .decay=3, .sustain=0, .release=3, .default_volume=128, .pulsewidth = 2048},  // 2 = closed hihat
+      {.waveform_select = WAVE_NONE, .envelope_enable=1, .attack=0, .decay=3, .sustain=0, .release=3, .default_volume=128, .pulsewidth = 2048},  // 3 = open hihat
+      {.waveform_select = WAVE_NONE, .envelope_enable=1, .attack=0, .decay=5, .sustain=0, .release=5, .default_volume=255, .pulsewidth = 2048},  // 4 = snare
 
       // first user defined instrument here:
-      {.waveform_select = WAVE_SAWTOOTH|WAVE_TRIANGLE, .envelope = &envelope1, .envelope_enable=1, .pulsewidth = 400}  // 5 = bassline
+      {.waveform_select = WAVE_SAWTOOTH|WAVE_TRIANGLE, .envelope_enable=1, .attack=2, .decay=6, .sustain=0, .release=6, .default_volume=180, .pulsewidth = 400}  // 5 = bassline
   },
   .bars = {
     { .notes = {
@@ -0,0 +1,27 @@
+# Builds the audio co-processor's program (see hdl/picosoc/audio/audio_cpu.v)
+# into audio_cpu_firmware.c, for the main firmware to start with audio_cpu_load().
+# The co-processor runs it from where it sits in flash, so it's word aligned.
+# Include this after tiny_soc.mk, with :
+#   AUDIO_CPU_SONGS - C files for the songs to play, and the audio_cpu_songs table
+#   (see firmware/audio_cpu/main.c)
+
+AUDIO_CPU_DIR = $(FIRMWARE_DIR)/audio_cpu
+AUDIO_CPU_C_FILES = $(AUDIO_CPU_DIR)/main.c $(AUDIO_CPU_SONGS) \
+	$(INCLUDE_DIR)/songplayer/songplayer.c \
+	$(INCLUDE_DIR)/audio/audio.c
+
+audio_cpu.elf: $(AUDIO_CPU_DIR)/start.S $(AUDIO_CPU_DIR)/sections.lds $(AUDIO_CPU_C_FILES)
+	/opt/riscv32i/bin/riscv32-unknown-elf-gcc -march=rv32i -mabi=ilp32 -Os -nostartfiles -ffunction-sections -fdata-sections -Wl,-Bstatic,-T,$(AUDIO_CPU_DIR)/sections.lds,--gc-sections,--strip-debug,-Map=audio_cpu.map -ffreestanding -nostdlib -o audio_cpu.elf -I$(INCLUDE_DIR) $(AUDIO_CPU_DIR)/start.S $(AUDIO_CPU_C_FILES)
+
+audio_cpu_firmware: audio_cpu.elf
+	/opt/riscv32i/bin/riscv32-unknown-elf-objcopy -O binary audio_cpu.elf audio_cpu_firmware
+
+audio_cpu_firmware.c: audio_cpu_firmware
+	xxd -i audio_cpu_firmware | sed -e 's/^unsigned char \(.*\)\[\]/const unsigned char \1[] __attribute__((aligned(4)))/' -e 's/^unsigned/const unsigned/' > audio_cpu_firmware.c
+
+clean: audio_cpu_clean
+
+audio_cpu_clean:
+	rm -f audio_cpu.elf audio_cpu.map audio_cpu_firmware audio_cpu_firmware.c
+
+.PHONY: audio_cpu_clean
@@ -0,0 +1,57 @@
+#include <stdint.h>
+
+#include <audio/audio.h>
+#include <songplayer/songplayer.h>
+
+// the audio co-processor's program :: waits for commands from the main CPU
+// in the mailbox, and calls songplayer_tick every SONGPLAYER_TICK_US.
+
+#define SONGPLAYER_TICK_US 20000    /* 50Hz */
+
+// the songs that can be played (AUDIO_CPU_CMD_PLAY's argument indexes these),
+// supplied with AUDIO_CPU_SONGS (see audio_cpu.mk)
+extern const struct packed_song_t *const audio_cpu_songs[];
+extern const uint32_t audio_cpu_num_songs;
+
+void main() {
+  uint32_t status = 0;
+  uint32_t next_tick = reg_audio_cpu[AUDIO_CPU_REG_TIMER];
+
+  reg_audio_cpu[AUDIO_CPU_REG_STATUS] = status;
+
+  while (1) {
+    uint32_t command = reg_audio_cpu[AUDIO_CPU_REG_COMMAND];
+    if (command != 0) {
+      uint32_t arg = command & 0x00ffffff;
+      reg_audio_cpu[AUDIO_CPU_REG_COMMAND] = 0;   // taken
+
+      switch (command >> 24) {
+        case AUDIO_CPU_CMD_PLAY:
+          if (arg < audio_cpu_num_songs) {
+            songplayer_init(audio_cpu_songs[arg]);
+            status = AUDIO_CPU_STATUS_LOADED | AUDIO_CPU_STATUS_PLAYING;
+          }
+          break;
+        case AUDIO_CPU_CMD_STOP:
+          songplayer_stop();
+          status &= ~AUDIO_CPU_STATUS_PLAYING;
+          break;
+        case AUDIO_CPU_CMD_TRIGGER_EFFECT:
+          if (status & AUDIO_CPU_STATUS_LOADED) {
+            songplayer_trigger_effect(arg);
+          }
+          break;
+        default:
+          break;
+      }
+      reg_audio_cpu[AUDIO_CPU_REG_STATUS] = status;
+    }
+
+    if ((int32_t)(reg_audio_cpu[AUDIO_CPU_REG_TIMER] - next_tick) >= 0) {
+      next_tick += SONGPLAYER_TICK_US;
+      if (status & AUDIO_CPU_STATUS_LOADED) {
+        songplayer_tick();
+      }
+    }
+  }
+}
@@ -22,7 +22,7 @@ extern uint32_t sram;
 #define reg_spictrl (*(volatile uint32_t*)0x02000000)
 #define reg_uart_clkdiv (*(volatile uint32_t*)0x02000004)
 
-extern const struct song_t song_pacman;
+extern const struct packed_song_t song_pacman;
 
 // Board timensions
 #define TILE_SIZE 8
@@ -87,6 +87,27 @@ extern const struct song_t song_pacman;
 
 #define GHOST_POINTS 200
 
+// Sound effects (bars of the song, or generated)
+#define SFX_DEATH 0
+#define SFX_PILL 1
+#define SFX_WAKA 2
+#define SFX_EAT_GHOST 3
+
+// two quick rising square wave sweeps
+const struct songplayer_sound_t eat_ghost_sound = {
+  .freq = 300, .slide = 60, .slide_change = 4,
+  .waveform = WAVE_SQUARE, .pulsewidth = 0x80, .pulsewidth_sweep = -48,
+  .envelope = ENV_ATTACK(0) | ENV_DECAY(4) | ENV_SUSTAIN(12) | ENV_RELEASE(3),
+  .volume = 200, .length = 8, .repeat = 1, .tail = 8,
+};
+
+const struct songplayer_sfx_t sound_effects[] = {
+  [SFX_DEATH] = { .bar = 8, .priority = 2, .duck = 2 },
+  [SFX_PILL] = { .bar = 9, .priority = 1, .duck = 1 },
+  [SFX_WAKA] = { .bar = 10, .priority = 0, .duck = 0 },
+  [SFX_EAT_GHOST] = { .priority = 1, .duck = 1, .sound = &eat_ghost_sound },
+};
+
 // Board positions
 #define FRUIT_X 7
 #define FRUIT_Y 3
@@ -515,6 +536,9 @@ void setup_sprites() {
 
 // Set up all the graphics data for board portion of screen
 void setup_screen() {
+  // Hide the rebuild until everything is in place
+  vid_set_display_enable(0);
+
   // Initialse the video and set offset to (0,0)
   vid_init();
   vid_set_x_ofs(0);
@@ -566,6 +590,8 @@ void setup_screen() {
   // Disable ghost eyes and set ghosts inactive
   for(int i=0;i<NUM_GHOSTS;i++) ghost_eyes[i] = false;
   for(int i=0;i<NUM_GHOSTS;i++) ghost_active[i] = false;
+
+  vid_set_display_enable(1);
 }
 
 // Display available fruit
@@ -1056,6 +1082,7 @@ void main() {
 
   // Play music
   songplayer_init(&song_pacman);
+  songplayer_set_sfx_table(sound_effects, sizeof(sound_effects) / sizeof(sound_effects[0]));
   songplayer_start(0);
 
   // switch to dual IO mode
@@ -1299,6 +1326,7 @@ void main() {
             set_ghost_eyes = i+1;
             ghost_eyes[i] = true;
             ghost_points <= 1;
+            songplayer_play_sfx(SFX_EAT_GHOST);
             vid_enable_sprite(PACMAN, 0);
           } else { // Lost a life
             if (num_lives == 0) {
@@ -1310,7 +1338,7 @@ void main() {
               num_lives = 3;
               show_game_over();
             } else {
-              songplayer_trigger_effect(8);
+              songplayer_play_sfx(SFX_DEATH);
             }
             life_over = true;
 
@@ -1355,9 +1383,9 @@ void main() {
          board[sprite_y[PACMAN]][sprite_x[PACMAN]] &= ~(FOOD | BIG_FOOD | FRUIT);
 
          if (n & BIG_FOOD) {
-           songplayer_trigger_effect(9);  /* trigger eat pill sound effect */
+           songplayer_play_sfx(SFX_PILL);  /* trigger eat pill sound effect */
          } else if (n & FOOD) {
-           songplayer_trigger_effect(10);  /* trigger waka waka noise */
+           songplayer_play_sfx(SFX_WAKA);  /* trigger waka waka noise */
          }
          if (n & BIG_FOOD && !hunting) {
            hunting = 1;
@@ -0,0 +1,69 @@
+// packed from song_pacman.c by tools/songpack - do not edit
+#include <stddef.h>
+#include <songplayer/songplayer.h>
+
+static const struct song_instrument_t instruments[16] = {
+  { .pulsewidth = -2048, .default_volume = 180, .envelope_enable = 1, .attack = 2, .decay = 6, .release = 6, },   // 0
+  { .pulsewidth = -2048, .default_volume = 255, .envelope_enable = 1, .attack = 1, .decay = 4, .release = 4, },   // 1
+  { .pulsewidth = -2048, .default_volume = 128, .envelope_enable = 1, .decay = 3, .release = 3, },   // 2
+  { .pulsewidth = -2048, .default_volume = 128, .envelope_enable = 1, .decay = 3, .release = 3, },   // 3
+  { .pulsewidth = -2048, .default_volume = 255, .envelope_enable = 1, .decay = 5, .release = 5, },   // 4
+  { .waveform_select = 3, .pulsewidth = 400, .default_volume = 180, .envelope_enable = 1, .attack = 2, .decay = 6, .release = 6, },   // 5
+  { .waveform_select = 3, .pulsewidth = 400, .default_volume = 255, },   // 6
+  { .waveform_select = 1, .pulsewidth = 400, .default_volume = 255, },   // 7
+  { .waveform_select = 2, .pulsewidth = -2048, .default_volume = 128, },   // 8
+  { },   // 9
+  { },   // 10
+  { },   // 11
+  { },   // 12
+  { },   // 13
+  { },   // 14
+  { },   // 15
+};
+
+static const uint8_t pattern_map[] = { 0, 1, 2, 3, 4, 4, 4, 4 };
+
+static const uint8_t patterns[] = {
+  1, 4, 0, 0, 0, 0, 0,   // 0
+  2, 5, 0, 0, 0, 0, 0,   // 1
+  1, 6, 0, 0, 0, 0, 0,   // 2
+  3, 7, 0, 0, 0, 0, 0,   // 3
+  0, 0, 0, 0, 0, 0, 0,   // 4
+};
+
+static const uint16_t bar_offsets[] = {
+  0, 1, 31, 61, 95, 111, 127, 143, 159, 224, 242,
+};
+
+static const uint8_t bar_data[] = {
+  0x00, 0x03, 0x05, 0x3c, 0x81, 0x03, 0x05, 0x48, 0x81, 0x03, 0x05, 0x43, 0x81, 0x03, 0x05, 0x40,
+  0x81, 0x03, 0x05, 0x48, 0x03, 0x05, 0x43, 0x03, 0x05, 0x3c, 0x81, 0x03, 0x05, 0x40, 0x00, 0x03,
+  0x05, 0x3d, 0x81, 0x03, 0x05, 0x49, 0x81, 0x03, 0x05, 0x44, 0x81, 0x03, 0x05, 0x41, 0x81, 0x03,
+  0x05, 0x49, 0x03, 0x05, 0x44, 0x03, 0x05, 0x3d, 0x81, 0x03, 0x05, 0x41, 0x00, 0x03, 0x05, 0x40,
+  0x03, 0x05, 0x41, 0x03, 0x05, 0x42, 0x81, 0x03, 0x05, 0x42, 0x03, 0x05, 0x43, 0x03, 0x05, 0x44,
+  0x81, 0x03, 0x05, 0x44, 0x03, 0x05, 0x45, 0x03, 0x05, 0x46, 0x81, 0x03, 0x05, 0x48, 0x00, 0x03,
+  0x05, 0x30, 0x85, 0x03, 0x05, 0x37, 0x81, 0x03, 0x05, 0x30, 0x85, 0x03, 0x05, 0x38, 0x00, 0x03,
+  0x05, 0x31, 0x85, 0x03, 0x05, 0x38, 0x81, 0x03, 0x05, 0x31, 0x85, 0x03, 0x05, 0x37, 0x00, 0x03,
+  0x05, 0x30, 0x85, 0x03, 0x05, 0x37, 0x81, 0x03, 0x05, 0x30, 0x85, 0x03, 0x05, 0x37, 0x00, 0x03,
+  0x05, 0x37, 0x83, 0x03, 0x05, 0x38, 0x83, 0x03, 0x05, 0x3a, 0x83, 0x03, 0x05, 0x3c, 0x00, 0x0b,
+  0x06, 0x50, 0x02, 0x01, 0x08, 0x01, 0x01, 0x0b, 0x06, 0x4e, 0x02, 0x01, 0x08, 0x01, 0x01, 0x0b,
+  0x06, 0x4d, 0x02, 0x01, 0x08, 0x01, 0x01, 0x0b, 0x06, 0x4b, 0x02, 0x01, 0x08, 0x01, 0x01, 0x0b,
+  0x06, 0x49, 0x02, 0x01, 0x08, 0x01, 0x01, 0x0b, 0x06, 0x48, 0x02, 0x01, 0x0b, 0x06, 0x38, 0x01,
+  0x05, 0x08, 0x01, 0x05, 0x0b, 0x06, 0x38, 0x01, 0x05, 0x08, 0x01, 0x05, 0x08, 0x0c, 0x00, 0x00,
+  0x0b, 0x07, 0x50, 0x02, 0x04, 0x08, 0x02, 0x04, 0x08, 0x01, 0x04, 0x08, 0x01, 0x04, 0x08, 0x0c,
+  0x00, 0x00, 0x0b, 0x08, 0x48, 0x02, 0x04, 0x08, 0x0c, 0x00, 0x0b, 0x08, 0x38, 0x01, 0x04, 0x08,
+  0x0c, 0x00, 0x00,
+};
+
+const struct packed_song_t song_pacman = {
+  .rows_per_bar = 16,
+  .ticks_per_div = 4,
+  .num_channels = 7,
+  .song_length = 8,
+  .num_bars = 11,
+  .instruments = instruments,
+  .pattern_map = pattern_map,
+  .patterns = patterns,
+  .bar_offsets = bar_offsets,
+  .bar_data = bar_data
+};
@@ -1,8 +1,18 @@
 //
-// a very cut-down audio peripheral - wave generators + volume control
+// a very cut-down audio peripheral - wave generators + ADSR envelopes + LFOs + volume control + stereo panning
+// (+ a PCM sample voice streaming from SPI flash, if audio_pcm is defined)
+// (+ a state-variable filter, if audio_filter is defined)
+// (+ a 32 sample wavetable per voice, if audio_wavetable is defined)
+// (+ a sequencer playing timed register writes, if audio_sequencer is defined)
 //
 
 module audio
+#(
+  // number of voices mixed by the voice pipeline.  Each 1MHz sample period
+  // is 16 system clocks long, and the pipeline needs one clock per voice plus
+  // PIPELINE_OVERHEAD clocks, so at most 16 - PIPELINE_OVERHEAD voices fit.
+  parameter NUM_VOICES = 8
+)
 (
   input resetn,
   input clk,
@@ -10,7 +20,16 @@ module audio
 	input [3:0]  iomem_wstrb,
 	input [31:0] iomem_addr,
 	input [31:0] iomem_wdata,
-  output audio_out);
+  output reg iomem_ready,
+  output reg [31:0] iomem_rdata,
+  output audio_out_left,
+  output audio_out_right,
+
+  // flash read port for the PCM sample voice (shares the SPI flash with the CPU)
+  output dma_valid,
+  output [23:0] dma_addr,
+  input dma_ready,
+  input [31:0] dma_rdata);
 
   ////////////////////////////////////////////////////////////////////
   // Configurable parameters
@@ -19,23 +38,112 @@ module audio
   localparam FREQ_BITS = 24;
   localparam PULSEWIDTH_BITS = 12;
   localparam ACCUMULATOR_BITS = 24;
-  localparam NUM_VOICES = 4;
+  localparam LFO_PHASE_BITS = 19;
+  localparam DAC_ORDER = 2;           // 1 = first-order, 2 = second-order sigma-delta DAC (see pdm_dac.v)
+`ifdef audio_pcm
+  localparam NUM_PCM_VOICES = 1;
+`else
+  localparam NUM_PCM_VOICES = 0;
+`endif
+`ifdef audio_filter
+  localparam NUM_FILTER_STEPS = 3;
+`else
+  localparam NUM_FILTER_STEPS = 0;
+`endif
+  localparam MIX_BITS = SAMPLE_BITS + $clog2(NUM_VOICES + NUM_PCM_VOICES);   // mixer accumulator has room for every voice at full scale
+  localparam PAN_MIX_BITS = MIX_BITS + 1;                                       // ... panned hard to one side
+  localparam MIX_SHIFT = 2;           // the mix is scaled down as the original 4 voice mixer's was, and saturates
+
+  ////////////////////////////////////////////////////////////////////
+  // Register map
+  //  voice registers live at 0x0400_0000 + voice*0x20 (8 words per voice, up to 16 voices)
+  //  global registers live at 0x0400_0200
+  //  voice wavetables live at 0x0400_0400 + voice*0x20 (32 bytes per voice, written a byte at a time)
+  //  sequencer registers live at 0x0400_0600 (its programs are read from flash)
+  //  word 7 of each voice, and global word 7, are read-only status registers
+  ////////////////////////////////////////////////////////////////////
+  localparam VOICE_REGS = 8;
+  localparam NUM_GLOBAL_REGS = 7;
+  localparam GLOBAL_REG_BASE = NUM_VOICES * VOICE_REGS;
+
+  localparam REG_FREQ = 3'd0;
+  localparam REG_PULSEWIDTH = 3'd1;
+  localparam REG_WAVEPARAMS = 3'd2;
+  localparam REG_VOLUME     = 3'd3;
+  localparam REG_ENVELOPE   = 3'd4;
+  localparam REG_LFO        = 3'd5;
+  localparam REG_MIX        = 3'd6;
+  localparam REG_STATUS     = 3'd7;
+
+  localparam REG_GLOBAL_VOLUME = GLOBAL_REG_BASE + 0;
+  localparam REG_PCM_START = GLOBAL_REG_BASE + 1;
+  localparam REG_PCM_LENGTH = GLOBAL_REG_BASE + 2;
+  localparam REG_PCM_LOOP = GLOBAL_REG_BASE + 3;
+  localparam REG_PCM_RATE = GLOBAL_REG_BASE + 4;
+  localparam REG_PCM_CTRL = GLOBAL_REG_BASE + 5;
+  localparam REG_FILTER = GLOBAL_REG_BASE + 6;
+
+	reg [31:0] config_register_bank [0:GLOBAL_REG_BASE+NUM_GLOBAL_REGS-1];
 
-	reg [31:0] config_register_bank [0:16];
-  wire [4:0] bank_addr = iomem_addr[6:2];
+  // each access is acknowledged a clock later (so that reads can be registered);
+  // only act on the first clock of each access
+  wire iomem_access = iomem_valid && !iomem_ready;
 
   ///////////////////////////////////////////////////////////////////
-  //    Handle PicoSoC writing to the config register bank
+  // Sequencer :: its writes go through the same decoding as the CPU's.
+  // The CPU has priority; a sequencer write waits for a clock without
+  // a CPU access.
+  ///////////////////////////////////////////////////////////////////
+  wire [31:0] sequencer_rdata;
+  wire sequencer_wen;
+  wire [10:0] sequencer_waddr;
+  wire [3:0] sequencer_wstrb;
+  wire [31:0] sequencer_wdata;
+  wire sequencer_write = sequencer_wen && !iomem_access;
+
+  wire access_valid = iomem_access || sequencer_write;
+  wire [11:0] access_addr = iomem_access ? iomem_addr[11:0] : { 1'b0, sequencer_waddr };
+  wire [3:0] access_wstrb = iomem_access ? iomem_wstrb : sequencer_write ? sequencer_wstrb : 4'b0000;
+  wire [31:0] access_wdata = iomem_access ? iomem_wdata : sequencer_wdata;
+
+  wire bank_addr_global = access_addr[9];
+  wire [7:0] bank_addr = bank_addr_global ? GLOBAL_REG_BASE + access_addr[4:2] : access_addr[8:2];
+  wire bank_addr_wavetable = (access_addr[11:9] == 3'b010);
+  wire bank_addr_sequencer = (access_addr[11:9] == 3'b011);
+  wire bank_addr_valid = (access_addr[11:10] != 2'b00) ? 1'b0
+                       : bank_addr_global ? (access_addr[4:2] < NUM_GLOBAL_REGS) : (access_addr[8:2] < GLOBAL_REG_BASE);
+  wire [3:0] bank_voice = access_addr[8:5];
+  wire bank_write = access_valid && bank_addr_valid && |access_wstrb;
+
+  // writing the envelope register with the gate bit set (re)starts the attack
+  // phase of that voice's envelope, even if the gate was already on.
+  // the write side toggles a bit, and the voice pipeline acknowledges it.
+  reg [NUM_VOICES-1:0] env_trigger;
+
+  // likewise, writing the PCM control register with the play bit set (re)starts the sample
+  reg pcm_trigger;
+
+  ///////////////////////////////////////////////////////////////////
+  //    Handle PicoSoC (or the sequencer) writing to the config register bank
   ///////////////////////////////////////////////////////////////////
 	always @(posedge clk) begin
-    if (iomem_valid) begin
-      if (iomem_wstrb[0]) config_register_bank[bank_addr][ 7: 0] <= iomem_wdata[ 7: 0];
-      if (iomem_wstrb[1]) config_register_bank[bank_addr][15: 8] <= iomem_wdata[15: 8];
-      if (iomem_wstrb[2]) config_register_bank[bank_addr][23:16] <= iomem_wdata[23:16];
-      if (iomem_wstrb[3]) config_register_bank[bank_addr][31:24] <= iomem_wdata[31:24];
+    if (bank_write) begin
+      if (access_wstrb[0]) config_register_bank[bank_addr][ 7: 0] <= access_wdata[ 7: 0];
+      if (access_wstrb[1]) config_register_bank[bank_addr][15: 8] <= access_wdata[15: 8];
+      if (access_wstrb[2]) config_register_bank[bank_addr][23:16] <= access_wdata[23:16];
+      if (access_wstrb[3]) config_register_bank[bank_addr][31:24] <= access_wdata[31:24];
+
+      if (!bank_addr_global && bank_addr[2:0] == REG_ENVELOPE && access_wstrb[2] && access_wdata[17]) begin
+        env_trigger[bank_voice] <= !env_trigger[bank_voice];
+      end
+      if (bank_addr == REG_PCM_CTRL && access_wstrb[2] && access_wdata[16]) begin
+        pcm_trigger <= !pcm_trigger;
+      end
     end
     if (!resetn) begin
-      config_register_bank[16]<=8'hff;  /* global volume = full scale by default for backwards compatibility */
+      config_register_bank[REG_GLOBAL_VOLUME]<=8'hff;  /* global volume = full scale by default for backwards compatibility */
+      env_trigger <= 0;
+      pcm_trigger <= 0;
     end
 	end
 
@@ -49,12 +157,48 @@ module audio
   /////////////////////////////////////////////////////////////////////
   // AUDIO Output
   /////////////////////////////////////////////////////////////////////
-  reg signed [SAMPLE_BITS+1:0] tmp_mixed_voices;
-  reg signed [SAMPLE_BITS+1:0] mixed_voices;
+  reg signed [PAN_MIX_BITS-1:0] tmp_mixed_left;
+  reg signed [PAN_MIX_BITS-1:0] tmp_mixed_right;
+  reg signed [MIX_BITS-1:0] tmp_filter_input;   // voices routed through the filter
+  reg signed [SAMPLE_BITS+1:0] mixed_left;
+  reg signed [SAMPLE_BITS+1:0] mixed_right;
 
   // and final_mix samples are pulse-density modulated for output
   // (output DAC has extra resolution due to mixing)
-  pdm_dac #(.SAMPLE_BITS(SAMPLE_BITS+2)) audio_dac(.din(mixed_voices[13:0]), .dout(audio_out), .clk(clk));
+  pdm_dac #(.SAMPLE_BITS(SAMPLE_BITS+2), .ORDER(DAC_ORDER)) audio_dac_left(.din(mixed_left[13:0]), .dout(audio_out_left), .clk(clk));
+  pdm_dac #(.SAMPLE_BITS(SAMPLE_BITS+2), .ORDER(DAC_ORDER)) audio_dac_right(.din(mixed_right[13:0]), .dout(audio_out_right), .clk(clk));
+
+  ////////////////////////////////////////////////////////////////////
+  // Voice pipeline
+  //  step 0..NUM_VOICES-1 => process voice 0..NUM_VOICES-1
+  //  STEP_PCM             => mix the PCM sample voice (only with audio_pcm)
+  //  STEP_FILTER + 0..2   => state-variable filter (only with audio_filter)
+  //  STEP_AUX             => envelope/LFO update for one voice (round-robin)
+  //  STEP_GLOBAL + 0..1   => scale the left/right mixed samples by the global volume
+  //  STEP_IDLE            => wait for the next accumulator clock
+  ////////////////////////////////////////////////////////////////////
+  localparam STEP_PCM = NUM_VOICES;
+  localparam STEP_FILTER = NUM_VOICES + NUM_PCM_VOICES;
+  localparam STEP_AUX = STEP_FILTER + NUM_FILTER_STEPS;
+  localparam STEP_GLOBAL = STEP_AUX + 1;
+  localparam STEP_GLOBAL_RIGHT = STEP_AUX + 2;
+  localparam STEP_IDLE = STEP_AUX + 3;
+  localparam PIPELINE_OVERHEAD = NUM_PCM_VOICES + NUM_FILTER_STEPS + 4;   // pcm + filter + aux + global left/right + (at least one clock of) idle
+
+  // the pipeline has to finish within the 16 clocks of a sample period (or
+  // every other sample would be lost); fail to elaborate if it doesn't
+  generate
+    if (NUM_VOICES + PIPELINE_OVERHEAD > 16) begin : pipeline_too_long
+      audio_NUM_VOICES_plus_PIPELINE_OVERHEAD_exceeds_16_clocks too_many_voices();
+    end
+  endgenerate
+
+  reg [4:0] pipeline_step;
+  wire pipeline_voice = (pipeline_step < NUM_VOICES);
+  wire pipeline_pcm = (NUM_PCM_VOICES != 0) && (pipeline_step == STEP_PCM);
+  wire pipeline_filter = (NUM_FILTER_STEPS != 0) && (pipeline_step >= STEP_FILTER) && (pipeline_step < STEP_AUX);
+  wire [1:0] filter_step = pipeline_step - STEP_FILTER;
+  wire pipeline_aux = (pipeline_step == STEP_AUX);
 
   ////////////////////////////////////////////////////////////////////
   // Voice accumulators
@@ -63,36 +207,472 @@ module audio
   reg[ACCUMULATOR_BITS-1:0] prev_accumulator[0:NUM_VOICES-1];
   reg [22:0] lfsr[0:NUM_VOICES-1];
 
-  reg[5:0] voice_pipeline_state;
-  reg [1:0] voice_num;
-  wire[3:0] reg_index = voice_num<<2; // offset into config register file for current voice (4 words per voice)
+  wire [3:0] voice_num = pipeline_step[3:0];
+  wire[7:0] reg_index = voice_num<<3; // offset into config register file for current voice (8 words per voice)
 
   reg prev_aclk;      // previous accumulator (1MHz) clock value
 
-  localparam REG_FREQ = 4'd0;
-  localparam REG_PULSEWIDTH = 4'd1;
-  localparam REG_WAVEPARAMS = 4'd2;
-  localparam REG_VOLUME     = 4'd3;
+  ////////////////////////////////////////////////////////////////////
+  // Flash dma port
+  //  shared by the PCM voice and the sequencer.  The PCM voice goes first,
+  //  and whichever has the port keeps it until its read is done.
+  ////////////////////////////////////////////////////////////////////
+  wire pcm_dma_request;
+  wire [23:0] pcm_dma_addr;
+  wire sequencer_dma_valid;
+  wire [23:0] sequencer_dma_addr;
+  reg dma_sequencer;      // the sequencer has the port
+
+  assign dma_valid = dma_sequencer ? sequencer_dma_valid : pcm_dma_request;
+  assign dma_addr = dma_sequencer ? sequencer_dma_addr : pcm_dma_addr;
+  wire pcm_dma_ready = dma_ready && !dma_sequencer;
+  wire sequencer_dma_ready = dma_ready && dma_sequencer;
+
+  always @(posedge clk) begin
+    if (!dma_valid) begin
+      dma_sequencer <= sequencer_dma_valid && !pcm_dma_request;
+    end
+    if (!resetn) begin
+      dma_sequencer <= 0;
+    end
+  end
+
+  // the sequencer ticks are counted in microseconds (rising edges of aclk)
+`ifdef audio_sequencer
+  audio_sequencer sequencer(
+    .resetn(resetn),
+    .clk(clk),
+    .tick_us(!prev_aclk && aclk),
+    .iomem_valid(iomem_access && bank_addr_sequencer),
+    .iomem_wstrb(iomem_wstrb),
+    .iomem_addr(iomem_addr),
+    .iomem_wdata(iomem_wdata),
+    .rdata(sequencer_rdata),
+    .dma_valid(sequencer_dma_valid),
+    .dma_addr(sequencer_dma_addr),
+    .dma_ready(sequencer_dma_ready),
+    .dma_rdata(dma_rdata),
+    .write_valid(sequencer_wen),
+    .write_addr(sequencer_waddr),
+    .write_wstrb(sequencer_wstrb),
+    .write_wdata(sequencer_wdata),
+    .write_ready(!iomem_access));
+`else
+  assign sequencer_rdata = 32'h0;
+  assign sequencer_wen = 1'b0;
+  assign sequencer_waddr = 11'h000;
+  assign sequencer_wstrb = 4'h0;
+  assign sequencer_wdata = 32'h0;
+  assign sequencer_dma_valid = 1'b0;
+  assign sequencer_dma_addr = 24'h000000;
+`endif
+
+  integer i;
 
   wire [23:0] voice_accumulator = accumulator[voice_num];
   wire [31:0] voice_wave_params = config_register_bank[reg_index+REG_WAVEPARAMS];
   wire [22:0] voice_lfsr = lfsr[voice_num];
-  wire [23:0] voice_freq_increment = config_register_bank[reg_index+REG_FREQ][23:0];
-  wire [11:0] voice_pulse_width = config_register_bank[reg_index+REG_PULSEWIDTH][11:0];
+  wire voice_filter_route = (NUM_FILTER_STEPS != 0) && config_register_bank[reg_index+REG_MIX][0];
+  wire [4:0] voice_pan = config_register_bank[reg_index+REG_MIX][12:8];
+
+  ////////////////////////////////////////////////////////////////////
+  // Wavetables
+  //  each voice has 32 signed 8 bit samples, played back indexed by the
+  //  top 5 bits of its accumulator.  The memory read takes a clock, so the
+  //  sample for the next voice in the pipeline (or voice 0, while idle) is
+  //  read a step ahead; its accumulator won't change before it's used.
+  ////////////////////////////////////////////////////////////////////
+  wire [7:0] wavetable_sample;
+`ifdef audio_wavetable
+  wire [3:0] wavetable_voice = pipeline_voice ? voice_num + 4'd1 : 4'd0;
+  wire [23:0] wavetable_accumulator = accumulator[wavetable_voice];
+
+  wavetable_memory wavetable(
+    .clk(clk),
+    .wen(access_valid && bank_addr_wavetable && |access_wstrb),
+    .ren(1'b1),
+    .waddr(access_addr[8:0]),
+    .raddr({ wavetable_voice, wavetable_accumulator[ACCUMULATOR_BITS-1 -: 5] }),
+    .wdata(access_wdata[8*access_addr[1:0] +: 8]),
+    .rdata(wavetable_sample));
+`else
+  assign wavetable_sample = 8'h00;
+`endif
+
+  ////////////////////////////////////////////////////////////////////
+  // PCM sample voice
+  //  streams signed 8 bit (or 4 bit) samples from SPI flash through a
+  //  512 byte FIFO.  The FIFO is refilled a word at a time through the
+  //  dma port whenever the CPU isn't using the flash.
+  //  start, length and loop start are in bytes, and must be word aligned.
+  ////////////////////////////////////////////////////////////////////
+  wire [23:0] pcm_start = { config_register_bank[REG_PCM_START][23:2], 2'b00 };
+  wire [23:0] pcm_length = { config_register_bank[REG_PCM_LENGTH][23:2], 2'b00 };
+  wire [23:0] pcm_loop_start = { config_register_bank[REG_PCM_LOOP][23:2], 2'b00 };
+  wire pcm_loop_enable = config_register_bank[REG_PCM_LOOP][31] && (pcm_loop_start < pcm_length);
+  wire [15:0] pcm_rate = config_register_bank[REG_PCM_RATE][15:0];      // samples per microsecond * 65536
+  wire [7:0] pcm_volume = config_register_bank[REG_PCM_CTRL][7:0];
+  wire pcm_4bit = config_register_bank[REG_PCM_CTRL][8];
+  wire pcm_enable = config_register_bank[REG_PCM_CTRL][16];
+  wire pcm_filter_route = (NUM_FILTER_STEPS != 0) && config_register_bank[REG_PCM_CTRL][9];
+  wire [4:0] pcm_pan = config_register_bank[REG_PCM_CTRL][28:24];
+
+  reg pcm_playing;
+  reg signed [7:0] pcm_sample;
+  wire [7:0] pcm_output_volume = (pcm_playing && pcm_enable) ? pcm_volume : 8'd0;
+
+`ifdef audio_pcm
+  reg pcm_trigger_ack;
+  reg pcm_dma_valid;
+  reg [23:0] pcm_fetch_addr;
+  reg [23:0] pcm_fetch_remaining;   // bytes left to fetch before the end (or loop point)
+  reg [24:0] pcm_play_remaining;    // samples left to play (ignored when looping)
+  reg [8:0] pcm_wptr;               // FIFO write pointer, in 16 bit entries (+ wrap bit)
+  reg [10:0] pcm_rptr;              // FIFO read pointer, in 4 bit nibbles (+ wrap bit)
+  reg [15:0] pcm_phase;
+  reg [15:0] pcm_dma_data_hi;       // second half of the last word fetched
+  reg pcm_write_hi;
+
+  assign pcm_dma_request = pcm_dma_valid;
+  assign pcm_dma_addr = pcm_fetch_addr;
+
+  wire [15:0] pcm_fifo_rdata;
+  wire pcm_fifo_wen = (pcm_dma_valid && pcm_dma_ready) || pcm_write_hi;
+  wire [15:0] pcm_fifo_wdata = pcm_write_hi ? pcm_dma_data_hi : dma_rdata[15:0];
+
+  pcm_fifo_memory pcm_fifo(
+    .clk(clk),
+    .wen(pcm_fifo_wen),
+    .ren(1'b1),
+    .waddr(pcm_wptr[7:0]),
+    .raddr(pcm_rptr[9:2]),
+    .wdata(pcm_fifo_wdata),
+    .rdata(pcm_fifo_rdata));
 
-  wire signed [8:0] voice_volume =  |(voice_pipeline_state[3:0])?  /* if we are currently mixing voices, choose channel volume */
-                                        {1'b0,config_register_bank[reg_index+REG_VOLUME][7:0]}
-                                      : {1'b0,config_register_bank[16][7:0]}; /* otherwise, select global volume */
+  wire [8:0] pcm_fifo_used = pcm_wptr - pcm_rptr[10:2];
+  wire pcm_fetch_done = (pcm_fetch_remaining == 0) && !pcm_dma_valid && !pcm_write_hi;
+  // (the newest entry may still be being written, so don't read it until the next one arrives)
+  wire pcm_sample_available = (pcm_fifo_used > 1) || (pcm_fifo_used != 0 && pcm_fetch_done);
 
+  wire [16:0] pcm_next_phase = pcm_phase + pcm_rate;
+  wire [7:0] pcm_fifo_byte = pcm_rptr[1] ? pcm_fifo_rdata[15:8] : pcm_fifo_rdata[7:0];
+  wire [3:0] pcm_fifo_nibble = pcm_rptr[0] ? pcm_fifo_byte[7:4] : pcm_fifo_byte[3:0];
+
+  always @(posedge clk) begin
+    if (pcm_trigger != pcm_trigger_ack && !pcm_dma_valid && !pcm_write_hi) begin
+      // (re)start the sample
+      pcm_trigger_ack <= pcm_trigger;
+      pcm_fetch_addr <= pcm_start;
+      pcm_fetch_remaining <= pcm_length;
+      pcm_play_remaining <= pcm_4bit ? { pcm_length, 1'b0 } : { 1'b0, pcm_length };
+      pcm_wptr <= 0;
+      pcm_rptr <= 0;
+      pcm_phase <= 0;
+      pcm_sample <= 0;
+      pcm_playing <= (pcm_length != 0);
+    end else begin
+      ///////////////////////////////////////////////////////////////
+      // refill the FIFO
+      ///////////////////////////////////////////////////////////////
+      if (pcm_write_hi) begin
+        pcm_write_hi <= 0;
+        pcm_wptr <= pcm_wptr + 1;
+      end
+
+      if (pcm_dma_valid) begin
+        if (pcm_dma_ready) begin
+          pcm_dma_valid <= 0;
+          pcm_dma_data_hi <= dma_rdata[31:16];
+          pcm_write_hi <= 1;
+          pcm_wptr <= pcm_wptr + 1;
+          if (pcm_fetch_remaining == 4 && pcm_loop_enable) begin
+            pcm_fetch_addr <= pcm_start + pcm_loop_start;
+            pcm_fetch_remaining <= pcm_length - pcm_loop_start;
+          end else begin
+            pcm_fetch_addr <= pcm_fetch_addr + 4;
+            pcm_fetch_remaining <= pcm_fetch_remaining - 4;
+          end
+        end
+      end else if (pcm_playing && pcm_enable && !pcm_write_hi && pcm_fetch_remaining != 0 && pcm_fifo_used <= 254) begin
+        pcm_dma_valid <= 1;
+      end
+
+      ///////////////////////////////////////////////////////////////
+      // step through the samples, once per accumulator clock
+      ///////////////////////////////////////////////////////////////
+      if (pipeline_pcm && pcm_playing && pcm_enable) begin
+        pcm_phase <= pcm_next_phase[15:0];
+        if (pcm_next_phase[16] && pcm_sample_available) begin
+          pcm_sample <= pcm_4bit ? { pcm_fifo_nibble, 4'b0000 } : pcm_fifo_byte;
+          pcm_rptr <= pcm_rptr + (pcm_4bit ? 11'd1 : 11'd2);
+          if (!pcm_loop_enable) begin
+            pcm_play_remaining <= pcm_play_remaining - 1;
+            if (pcm_play_remaining == 1) begin
+              pcm_playing <= 0;
+            end
+          end
+        end
+      end
+    end
+
+    if (!resetn) begin
+      pcm_trigger_ack <= 0;
+      pcm_dma_valid <= 0;
+      pcm_write_hi <= 0;
+      pcm_playing <= 0;
+      pcm_fetch_remaining <= 0;
+      pcm_sample <= 0;
+    end
+  end
+`else
+  assign pcm_dma_request = 1'b0;
+  assign pcm_dma_addr = 24'h000000;
+
+  always @(posedge clk) begin
+    pcm_playing <= 0;
+    pcm_sample <= 0;
+  end
+`endif
+
+  ////////////////////////////////////////////////////////////////////
+  // State-variable filter
+  //  a Chamberlin state-variable filter, run once per sample on the
+  //  voices routed through it, using the shared multiplier for its three
+  //  multiplies:
+  //    lowpass  += cutoff * bandpass
+  //    highpass  = input - lowpass - damping * bandpass
+  //    bandpass += cutoff * highpass
+  //  state is kept in 14.8 fixed point, and saturated to 12 bits on its way
+  //  into the multiplier.
+  //  cutoff frequency = cutoff * 39Hz (39Hz..10kHz)
+  ////////////////////////////////////////////////////////////////////
+  localparam FILTER_LOWPASS = 2'd0;
+  localparam FILTER_HIGHPASS = 2'd1;
+  localparam FILTER_BANDPASS = 2'd2;
+
+  wire [7:0] filter_cutoff = config_register_bank[REG_FILTER][7:0];
+  wire [3:0] filter_resonance = config_register_bank[REG_FILTER][11:8];
+  wire filter_lowpass_enable = config_register_bank[REG_FILTER][16];
+  wire filter_bandpass_enable = config_register_bank[REG_FILTER][17];
+  wire filter_highpass_enable = config_register_bank[REG_FILTER][18];
+  wire [7:0] filter_damping = 8'd255 - filter_resonance * 8'd14;     // damping / 128 = 2.0 .. 0.35
+
+  reg signed [21:0] filter_lowpass;
+  reg signed [21:0] filter_bandpass;
+  reg signed [21:0] filter_highpass;
+
+  // a scaled mix, saturated to a 12 bit sample
+  function [11:0] saturate_mix;
+    input [PAN_MIX_BITS:0] sum;
+    saturate_mix = (sum[PAN_MIX_BITS:11] == 0 || &sum[PAN_MIX_BITS:11]) ? sum[11:0]
+                 : sum[PAN_MIX_BITS] ? 12'h800 : 12'h7ff;
+  endfunction
+
+  // integer part of a filter state, saturated to a 12 bit sample
+  function [11:0] filter_sample;
+    input [21:0] state;
+    filter_sample = (state[21:19] == 3'b000 || state[21:19] == 3'b111) ? state[19:8]
+                  : state[21] ? 12'h800 : 12'h7ff;
+  endfunction
+
+  wire signed [PAN_MIX_BITS:0] filter_input_sum = tmp_filter_input >>> MIX_SHIFT;
+  wire signed [11:0] filter_input = saturate_mix(filter_input_sum);
+  wire signed [21:0] filter_mix = (filter_lowpass_enable ? filter_lowpass : 22'sd0)
+                                + (filter_bandpass_enable ? filter_bandpass : 22'sd0)
+                                + (filter_highpass_enable ? filter_highpass : 22'sd0);
+  wire signed [11:0] filter_output = (NUM_FILTER_STEPS != 0) ? filter_sample(filter_mix) : 12'sd0;
+
+  // non-filtered voices + filter output (in the centre), saturated, ready for the global volume
+  wire signed [PAN_MIX_BITS:0] global_mix_left_sum = (tmp_mixed_left >>> MIX_SHIFT) + filter_output;
+  wire signed [PAN_MIX_BITS:0] global_mix_right_sum = (tmp_mixed_right >>> MIX_SHIFT) + filter_output;
+  wire [11:0] global_mix = saturate_mix((pipeline_step == STEP_GLOBAL_RIGHT) ? global_mix_right_sum : global_mix_left_sum);
+
+  ////////////////////////////////////////////////////////////////////
+  // Panning
+  //  pan is -8 (left) .. 0 (centre) .. 8 (right), saturated.  The right
+  //  channel gets sample * (8 + pan) / 8 (by shift-and-add rather than
+  //  another multiplier), and the left channel the remainder, so a centred
+  //  voice is mixed into both channels at full scale.
+  ////////////////////////////////////////////////////////////////////
+  wire [4:0] pipeline_pan = pipeline_pcm ? pcm_pan : voice_pan;
+  wire [4:0] pan_right_gain = pipeline_pan[4] ? ((pipeline_pan[3:0] < 4'h8) ? 5'd0 : pipeline_pan + 5'd8)
+                            : (pipeline_pan[3] ? 5'd16 : pipeline_pan + 5'd8);
+
+  wire signed [PAN_MIX_BITS+3:0] pan_sample = $signed(scaled_voice_output[MIX_BITS-1:0]);
+  wire signed [PAN_MIX_BITS+3:0] pan_right_sum = (pan_right_gain[4] ? pan_sample <<< 4 : 0)
+                                               + (pan_right_gain[3] ? pan_sample <<< 3 : 0)
+                                               + (pan_right_gain[2] ? pan_sample <<< 2 : 0)
+                                               + (pan_right_gain[1] ? pan_sample <<< 1 : 0)
+                                               + (pan_right_gain[0] ? pan_sample : 0);
+  wire signed [PAN_MIX_BITS-1:0] pan_right = pan_right_sum >>> 3;
+  wire signed [PAN_MIX_BITS-1:0] pan_left = (pan_sample <<< 1) - pan_right;
+
+  ////////////////////////////////////////////////////////////////////
+  // LFOs
+  //  each voice has a vibrato LFO (modulating the frequency by up to
+  //  about +/-12%) and a pulse-width LFO (modulating the pulse width by
+  //  up to +/-2048), both triangle waves.  They are updated in the aux
+  //  step using the shared multiplier.
+  //  LFO frequency = speed * 0.06Hz (0..15Hz) with 8 voices
+  ////////////////////////////////////////////////////////////////////
+  reg [LFO_PHASE_BITS-1:0] lfo_vibrato_phase[0:NUM_VOICES-1];
+  reg [LFO_PHASE_BITS-1:0] lfo_pwm_phase[0:NUM_VOICES-1];
+  reg signed [16:0] lfo_vibrato_offset[0:NUM_VOICES-1];   // added to the frequency
+  reg signed [11:0] lfo_pwm_offset[0:NUM_VOICES-1];       // added to the pulse width
+  reg signed [8:0] lfo_vibrato_mod;                       // vibrato depth * wave, for the current aux voice
+
+  wire [23:0] voice_freq_increment = config_register_bank[reg_index+REG_FREQ][23:0]
+                                      + { {7{lfo_vibrato_offset[voice_num][16]}}, lfo_vibrato_offset[voice_num] };
+  wire signed [13:0] voice_pulse_width_modulated = $signed({ 2'b00, config_register_bank[reg_index+REG_PULSEWIDTH][11:0] })
+                                      + lfo_pwm_offset[voice_num];
+  wire [11:0] voice_pulse_width = voice_pulse_width_modulated[13] ? 12'h000   /* clamp to 0..4095 */
+                                : voice_pulse_width_modulated[12] ? 12'hfff
+                                : voice_pulse_width_modulated[11:0];
+
+  ////////////////////////////////////////////////////////////////////
+  // ADSR envelope generators
+  //  each voice has a 24 bit envelope level, which is stepped once per
+  //  accumulator clock (1MHz) as the voice passes through the pipeline.
+  ////////////////////////////////////////////////////////////////////
+  localparam ENV_ATTACK  = 2'd0;
+  localparam ENV_DECAY   = 2'd1;
+  localparam ENV_SUSTAIN = 2'd2;
+  localparam ENV_RELEASE = 2'd3;
+
+  reg [23:0] env_level[0:NUM_VOICES-1];
+  reg [1:0] env_state[0:NUM_VOICES-1];
+  reg [7:0] env_volume[0:NUM_VOICES-1];   // voice volume scaled by the envelope level
+  reg [NUM_VOICES-1:0] env_trigger_ack;
+
+  // attack: time taken to ramp from 0 to full scale (2ms .. 8s)
+  function [13:0] attack_step;
+    input [3:0] rate;
+    case (rate)
+      4'd0:  attack_step = 14'd8389;    // 2ms
+      4'd1:  attack_step = 14'd2097;    // 8ms
+      4'd2:  attack_step = 14'd1049;    // 16ms
+      4'd3:  attack_step = 14'd699;     // 24ms
+      4'd4:  attack_step = 14'd442;     // 38ms
+      4'd5:  attack_step = 14'd300;     // 56ms
+      4'd6:  attack_step = 14'd247;     // 68ms
+      4'd7:  attack_step = 14'd210;     // 80ms
+      4'd8:  attack_step = 14'd168;     // 100ms
+      4'd9:  attack_step = 14'd67;      // 250ms
+      4'd10: attack_step = 14'd34;      // 500ms
+      4'd11: attack_step = 14'd21;      // 800ms
+      4'd12: attack_step = 14'd17;      // 1s
+      4'd13: attack_step = 14'd6;       // 3s
+      4'd14: attack_step = 14'd3;       // 5s
+      4'd15: attack_step = 14'd2;       // 8s
+    endcase
+  endfunction
+
+  // decay/release: time taken to fall from full scale to 0 (6ms .. 24s)
+  function [11:0] decay_step;
+    input [3:0] rate;
+    case (rate)
+      4'd0:  decay_step = 12'd2796;     // 6ms
+      4'd1:  decay_step = 12'd699;      // 24ms
+      4'd2:  decay_step = 12'd350;      // 48ms
+      4'd3:  decay_step = 12'd233;      // 72ms
+      4'd4:  decay_step = 12'd147;      // 114ms
+      4'd5:  decay_step = 12'd100;      // 168ms
+      4'd6:  decay_step = 12'd82;       // 204ms
+      4'd7:  decay_step = 12'd70;       // 240ms
+      4'd8:  decay_step = 12'd56;       // 300ms
+      4'd9:  decay_step = 12'd22;       // 750ms
+      4'd10: decay_step = 12'd11;       // 1.5s
+      4'd11: decay_step = 12'd7;        // 2.4s
+      4'd12: decay_step = 12'd6;        // 3s
+      4'd13: decay_step = 12'd2;        // 9s
+      4'd14: decay_step = 12'd1;        // 15s
+      4'd15: decay_step = 12'd1;        // 24s
+    endcase
+  endfunction
+
+  wire [31:0] voice_envelope_params = config_register_bank[reg_index+REG_ENVELOPE];
+  wire [3:0] voice_attack = voice_envelope_params[3:0];
+  wire [3:0] voice_decay = voice_envelope_params[7:4];
+  wire [3:0] voice_sustain = voice_envelope_params[11:8];
+  wire [3:0] voice_release = voice_envelope_params[15:12];
+  wire voice_envelope_enable = voice_envelope_params[16];
+  wire voice_gate = voice_envelope_params[17];
+
+  wire [23:0] voice_env_level = env_level[voice_num];
+  wire [1:0] voice_env_state = env_state[voice_num];
+  wire voice_env_retrigger = (env_trigger[voice_num] != env_trigger_ack[voice_num]);
+  wire [23:0] voice_sustain_level = { voice_sustain, voice_sustain, 16'h0000 };
+  wire [11:0] voice_release_step = decay_step(voice_release);
+  wire [11:0] voice_decay_step = decay_step(voice_decay);
+  wire [24:0] voice_env_attack_level = voice_env_level + attack_step(voice_attack);
+  wire [24:0] voice_env_decay_floor = voice_sustain_level + voice_decay_step;
+
+  ////////////////////////////////////////////////////////////////////
+  // aux step
+  //  once per sample, one of the following is done for aux_voice,
+  //  moving on to the next voice after AUX_PWM; so each voice's envelope
+  //  volume and LFOs are updated every 4*NUM_VOICES accumulator clocks.
+  ////////////////////////////////////////////////////////////////////
+  localparam AUX_ENVELOPE = 2'd0;         // envelope level * volume
+  localparam AUX_VIBRATO_DEPTH = 2'd1;    // vibrato wave * depth
+  localparam AUX_VIBRATO = 2'd2;          // frequency * vibrato
+  localparam AUX_PWM = 2'd3;              // pulse width wave * depth
+
+  reg [3:0] aux_voice;
+  reg [1:0] aux_step;
+
+  wire [7:0] aux_reg_index = aux_voice<<3;
+  wire [31:0] aux_lfo_params = config_register_bank[aux_reg_index+REG_LFO];
+  wire [7:0] aux_vibrato_depth = aux_lfo_params[7:0];
+  wire [7:0] aux_vibrato_speed = aux_lfo_params[15:8];
+  wire [7:0] aux_pwm_depth = aux_lfo_params[23:16];
+  wire [7:0] aux_pwm_speed = aux_lfo_params[31:24];
+  wire [LFO_PHASE_BITS-1:0] aux_vibrato_phase = lfo_vibrato_phase[aux_voice];
+  wire [LFO_PHASE_BITS-1:0] aux_pwm_phase = lfo_pwm_phase[aux_voice];
+
+  // triangle waves from the LFO phase, as signed -1024..1023
+  wire [10:0] aux_vibrato_triangle = aux_vibrato_phase[LFO_PHASE_BITS-1] ? ~aux_vibrato_phase[LFO_PHASE_BITS-2 -: 11]
+                                                                         : aux_vibrato_phase[LFO_PHASE_BITS-2 -: 11];
+  wire [10:0] aux_pwm_triangle = aux_pwm_phase[LFO_PHASE_BITS-1] ? ~aux_pwm_phase[LFO_PHASE_BITS-2 -: 11]
+                                                                 : aux_pwm_phase[LFO_PHASE_BITS-2 -: 11];
+  wire signed [11:0] aux_vibrato_wave = { {2{~aux_vibrato_triangle[10]}}, aux_vibrato_triangle[9:0] };
+  wire signed [11:0] aux_pwm_wave = { {2{~aux_pwm_triangle[10]}}, aux_pwm_triangle[9:0] };
+
+  // frequency / 128, saturated to fit the multiplier
+  wire [23:0] aux_freq = config_register_bank[aux_reg_index+REG_FREQ][23:0];
+  wire [10:0] aux_freq_scaled = |(aux_freq[23:18]) ? 11'h7ff : aux_freq[17:7];
+
+  wire signed [8:0] voice_volume =  pipeline_voice ?  /* if we are currently mixing voices, choose channel volume */
+                                        {1'b0, voice_envelope_enable ? env_volume[voice_num] : config_register_bank[reg_index+REG_VOLUME][7:0]}
+                                    : pipeline_pcm ?
+                                        {1'b0,pcm_output_volume}
+                                    : pipeline_filter ?
+                                        {1'b0, (filter_step == FILTER_HIGHPASS) ? filter_damping : filter_cutoff}
+                                    : pipeline_aux ?
+                                        ((aux_step == AUX_ENVELOPE) ? {1'b0,config_register_bank[aux_reg_index+REG_VOLUME][7:0]}
+                                        : (aux_step == AUX_VIBRATO_DEPTH) ? {1'b0,aux_vibrato_depth}
+                                        : (aux_step == AUX_VIBRATO) ? lfo_vibrato_mod
+                                        : {1'b0,aux_pwm_depth})
+                                      : {1'b0,config_register_bank[REG_GLOBAL_VOLUME][7:0]}; /* otherwise, select global volume */
+
+  wire voice_wave_select_wavetable = voice_wave_params[20];
   wire voice_wave_select_noise = voice_wave_params[19];
   wire voice_wave_select_pulse = voice_wave_params[18];
   wire voice_wave_select_sawtooth = voice_wave_params[17];
   wire voice_wave_select_triangle = voice_wave_params[16];
   wire voice_ring_modulation_enable = voice_wave_params[24];
+  wire voice_sync_enable = voice_wave_params[25];
 
-  reg [3:0] ringmod_bit;
-  wire[1:0] sync_source_for_voice = (voice_num == 0) ? 3 : (voice_num == 1) ? 0 : (voice_num == 2) ? 1 : 2;
-  wire voice_ringmod_source = ringmod_bit[1<<sync_source_for_voice];
+  // ring modulation and sync take the previous voice (voice 0 takes the last
+  // voice) as their source.  As each voice passes through the pipeline, it
+  // leaves its accumulator MSB, and whether that MSB has just gone high, for
+  // the voice after it.
+  reg [NUM_VOICES-1:0] ringmod_bit;
+  reg [NUM_VOICES-1:0] sync_bit;
+  wire[3:0] sync_source_for_voice = (voice_num == 0) ? NUM_VOICES-1 : voice_num-1;
+  wire voice_ringmod_source = ringmod_bit[sync_source_for_voice];
+  wire voice_sync_source = sync_bit[sync_source_for_voice];
+  wire [ACCUMULATOR_BITS-1:0] voice_next_accumulator = voice_accumulator + voice_freq_increment;
 
 
   ///////////////////////////////////////////////////////////////////
@@ -100,42 +680,92 @@ module audio
   ///////////////////////////////////////////////////////////////////
   localparam MAX_SCALE = (2**SAMPLE_BITS) - 1;
 
-  wire tone_triangle_invert_wave = (voice_ring_modulation_enable && voice_ringmod_source)
-                                  || (!voice_ring_modulation_enable && voice_accumulator[ACCUMULATOR_BITS-1]);
+  wire tone_triangle_invert_wave = voice_accumulator[ACCUMULATOR_BITS-1] ^ (voice_ring_modulation_enable && voice_ringmod_source);
   wire [SAMPLE_BITS-1:0] tone_triangle_unsigned_data  = tone_triangle_invert_wave ? ~voice_accumulator[ACCUMULATOR_BITS-2 -: SAMPLE_BITS]
                             : voice_accumulator[ACCUMULATOR_BITS-2 -: SAMPLE_BITS];
   wire [SAMPLE_BITS-1:0] tone_sawtooth_unsigned_data = voice_accumulator[ACCUMULATOR_BITS-1 -: SAMPLE_BITS];
   wire [SAMPLE_BITS-1:0] tone_noise_unsigned_data = { voice_lfsr[22], voice_lfsr[20], voice_lfsr[16], voice_lfsr[13], voice_lfsr[11], voice_lfsr[7], voice_lfsr[4], voice_lfsr[2], {(SAMPLE_BITS-8){1'b0}} };
+  wire [SAMPLE_BITS-1:0] tone_wavetable_unsigned_data = { wavetable_sample ^ 8'h80, {(SAMPLE_BITS-8){1'b0}} };
   wire [SAMPLE_BITS-1:0] tone_pulse_unsigned_data = (voice_accumulator[ACCUMULATOR_BITS-1 -: PULSEWIDTH_BITS] <= voice_pulse_width) ? MAX_SCALE : 0;
 
     /////////////////////////////////////////////////////////////////////////////
     // produce audio samples
     /////////////////////////////////////////////////////////////////////////////
     // this monstrocity may require some explaination..
-    // because we need to re-use the channel-scale multiplier for doing global
-    // volume scaling too, this mux selects the appropriate source to apply to
-    // the scaler.
-    // If we're mixing a normal voice (0-3), then take the logical AND of
+    // because we need to re-use the channel-scale multiplier for doing envelope,
+    // LFO and global volume scaling too, this mux selects the appropriate source
+    // to apply to the scaler.
+    // If we're mixing a normal voice, then take the logical AND of
     //  each of the enabled waveforms, and XOR it with 0x80000 to turn it
     //  into a signed value.
+    // If we're in the aux step, select the (positive) envelope level, so
+    //  that it can be scaled by the voice volume, or the LFO waves (to be
+    //  scaled by their depth), or the voice frequency (to be scaled by the
+    //  vibrato).
+    // If we're in a filter step, select the (saturated) filter state to be
+    //  scaled by the cutoff or damping.
     // If we've mixed all of the normal voices already, then select the
     //  "mixed" data so that this can be further scaled by the global volume.
     //  (see the voice_volume wire definition above, and the scaled_voice_output
     //   definition below for more info).
     wire signed [SAMPLE_BITS-1:0] unscaled_voice_output =
-       |(voice_pipeline_state[3:0])
+       pipeline_voice
        ?
         (12'b1000_0000_0000 ^  // invert MSB to convert unsigned to signed
             (12'b1111_1111_1111
+                & (voice_wave_select_wavetable ? tone_wavetable_unsigned_data : 12'd4095)
                 & (voice_wave_select_noise ? tone_noise_unsigned_data : 12'd4095)
                 & (voice_wave_select_pulse ? tone_pulse_unsigned_data : 12'd4095)
                 & (voice_wave_select_sawtooth ? tone_sawtooth_unsigned_data : 12'd4095)
                 & (voice_wave_select_triangle ? tone_triangle_unsigned_data : 12'd4095)
               )
           )
-        : tmp_mixed_voices[SAMPLE_BITS+1:2];  /* if voice_pipeline has mixed all voices, select output sample so it can be scaled by global volume */
+        : pipeline_pcm
+        ?
+          { pcm_sample, 4'b0000 }
+        : pipeline_filter
+        ?
+          filter_sample((filter_step == FILTER_BANDPASS) ? filter_highpass : filter_bandpass)
+        : pipeline_aux
+        ?
+          ((aux_step == AUX_ENVELOPE) ? { 4'b0000, env_level[aux_voice][23:16] }
+          : (aux_step == AUX_VIBRATO_DEPTH) ? aux_vibrato_wave
+          : (aux_step == AUX_VIBRATO) ? { 1'b0, aux_freq_scaled }
+          : aux_pwm_wave)
+        : global_mix;  /* if voice_pipeline has mixed all voices, select output sample so it can be scaled by global volume */
+
+  wire signed [SAMPLE_BITS+9-1:0] multiplier_output = unscaled_voice_output * voice_volume;
+  wire signed [SAMPLE_BITS+9-1:0] scaled_voice_output = multiplier_output >>> 8;
+
+  ///////////////////////////////////////////////////////////////////
+  //    Handle PicoSoC reading the status registers
+  //  voice status:  [31:16] phase (accumulator MSBs), [15] gate,
+  //                 [9:8] envelope state, [7:0] envelope level
+  //  global status: [31:16] right sample, [15:0] left sample (as sent to the DACs)
+  //  (everything else reads as zero)
+  ///////////////////////////////////////////////////////////////////
+  wire [23:0] status_accumulator = accumulator[bank_voice];
+  wire [23:0] status_env_level = env_level[bank_voice];
+  wire [1:0] status_env_state = env_state[bank_voice];
+  wire status_gate = config_register_bank[{ bank_voice, REG_ENVELOPE }][17];
 
-  wire signed [SAMPLE_BITS+9-1:0] scaled_voice_output = (unscaled_voice_output * voice_volume) >>> 8;
+  always @(posedge clk) begin
+    iomem_ready <= iomem_access;
+    if (iomem_access) begin
+      if (bank_addr_sequencer) begin
+        iomem_rdata <= sequencer_rdata;
+      end else if (!bank_addr_wavetable && bank_addr_global && iomem_addr[4:2] == REG_STATUS) begin
+        iomem_rdata <= { {2{mixed_right[SAMPLE_BITS+1]}}, mixed_right, {2{mixed_left[SAMPLE_BITS+1]}}, mixed_left };
+      end else if (!bank_addr_wavetable && !bank_addr_global && iomem_addr[4:2] == REG_STATUS && bank_voice < NUM_VOICES) begin
+        iomem_rdata <= { status_accumulator[ACCUMULATOR_BITS-1 -: 16], status_gate, 5'b00000, status_env_state, status_env_level[23:16] };
+      end else begin
+        iomem_rdata <= 32'h0;
+      end
+    end
+    if (!resetn) begin
+      iomem_ready <= 0;
+    end
+  end
 
   ///////////////////////////////////////////////////////////////////
   // handle voice logic
@@ -143,66 +773,146 @@ module audio
   always @(posedge clk) begin
     prev_aclk <= aclk;
 
-    voice_pipeline_state <= 6'b100000;
-
     /////////////////////////////////////////////////////////////////
     // state machine iterates through each voice, one-at-a-time,
     // increments the accumulators, noise LFSR's, and generates
     // waveforms
     /////////////////////////////////////////////////////////////////
-    (* full_case, parallel_case *)
-    case (1'b1)
-      /////////////////////////////////////////////////////////////
-      // state 0,1,2,3 => processing voice 1, 2, 3, 4
-      /////////////////////////////////////////////////////////////
-      voice_pipeline_state[0],
-      voice_pipeline_state[1],
-      voice_pipeline_state[2],
-      voice_pipeline_state[3]: begin
-        // increment the accumulator
-        prev_accumulator[voice_num] <= accumulator[voice_num];
-        accumulator[voice_num] <= accumulator[voice_num] + voice_freq_increment;
-
-        // update noise LFSR
-        if (accumulator[voice_num][19] && !prev_accumulator[voice_num][19]) begin
-          lfsr[voice_num] <= { lfsr[voice_num][21:0], lfsr[voice_num][22] ^ lfsr[voice_num][17] };
-        end
+    if (pipeline_voice) begin
+      // increment the accumulator (or reset it, if synced to a source that has just wrapped)
+      prev_accumulator[voice_num] <= accumulator[voice_num];
+      accumulator[voice_num] <= (voice_sync_enable && voice_sync_source) ? {ACCUMULATOR_BITS{1'b0}} : voice_next_accumulator;
+
+      // update noise LFSR
+      if (accumulator[voice_num][19] && !prev_accumulator[voice_num][19]) begin
+        lfsr[voice_num] <= { lfsr[voice_num][21:0], lfsr[voice_num][22] ^ lfsr[voice_num][17] };
+      end
 
-        // produce ring-mod output
-        ringmod_bit[1<<voice_num] <= voice_accumulator[ACCUMULATOR_BITS-1];
+      // produce ring-mod and sync outputs
+      ringmod_bit[voice_num] <= voice_accumulator[ACCUMULATOR_BITS-1];
+      sync_bit[voice_num] <= !voice_accumulator[ACCUMULATOR_BITS-1] && voice_next_accumulator[ACCUMULATOR_BITS-1];
 
-        // scale samples by envelope generator, and add them either to the filter chain, or non-filter chain
-        tmp_mixed_voices <= tmp_mixed_voices + scaled_voice_output[SAMPLE_BITS+1:0];
+      // step the envelope generator
+      if (voice_env_retrigger) begin
+        env_trigger_ack[voice_num] <= env_trigger[voice_num];
+        env_state[voice_num] <= ENV_ATTACK;
+      end else if (!voice_gate || voice_env_state == ENV_RELEASE) begin
+        env_state[voice_num] <= ENV_RELEASE;
+        env_level[voice_num] <= (voice_env_level > voice_release_step) ? voice_env_level - voice_release_step : 24'd0;
+      end else begin
+        case (voice_env_state)
+          ENV_ATTACK: begin
+            if (voice_env_attack_level[24]) begin
+              env_level[voice_num] <= 24'hffffff;
+              env_state[voice_num] <= ENV_DECAY;
+            end else begin
+              env_level[voice_num] <= voice_env_attack_level[23:0];
+            end
+          end
+          ENV_DECAY: begin
+            if ({1'b0, voice_env_level} <= voice_env_decay_floor) begin
+              env_level[voice_num] <= voice_sustain_level;
+              env_state[voice_num] <= ENV_SUSTAIN;
+            end else begin
+              env_level[voice_num] <= voice_env_level - voice_decay_step;
+            end
+          end
+          default: begin
+            env_level[voice_num] <= voice_sustain_level;
+          end
+        endcase
+      end
 
-        // move on to the next voice
-        voice_num <= voice_num + 1;
-        voice_pipeline_state <= voice_pipeline_state << 1;
+      // scale samples by volume, and add them either to the filter chain, or (panned) non-filter chain
+      if (voice_filter_route) begin
+        tmp_filter_input <= tmp_filter_input + scaled_voice_output[MIX_BITS-1:0];
+      end else begin
+        tmp_mixed_left <= tmp_mixed_left + pan_left;
+        tmp_mixed_right <= tmp_mixed_right + pan_right;
       end
-      voice_pipeline_state[4]: begin
-        // latch sample value out
-        mixed_voices <= { scaled_voice_output[SAMPLE_BITS-1:0],2'b0 };   /* scaled voice output now contains (global_volume * tmp_mixed_voices) / 256 */
-        voice_pipeline_state <= 6'b100000;  // move to "idle" state until next aclk
+
+      // move on to the next voice
+      pipeline_step <= pipeline_step + 1;
+    end else if (pipeline_pcm) begin
+      if (pcm_filter_route) begin
+        tmp_filter_input <= tmp_filter_input + scaled_voice_output[MIX_BITS-1:0];
+      end else begin
+        tmp_mixed_left <= tmp_mixed_left + pan_left;
+        tmp_mixed_right <= tmp_mixed_right + pan_right;
       end
-      voice_pipeline_state[5]: begin
-        // accumulator clock has gone high; reset state machine
-        if (!prev_aclk && aclk) begin
-          voice_pipeline_state <= 6'b000001;
-          tmp_mixed_voices <= 0;
-          voice_num <= 0;
+      pipeline_step <= pipeline_step + 1;
+    end else if (pipeline_filter) begin
+      case (filter_step)
+        FILTER_LOWPASS: begin
+          filter_lowpass <= filter_lowpass + (multiplier_output >>> 4);
+        end
+        FILTER_HIGHPASS: begin
+          filter_highpass <= $signed({ filter_input, 8'h00 }) - filter_lowpass - (multiplier_output <<< 1);
+        end
+        default: begin
+          filter_bandpass <= filter_bandpass + (multiplier_output >>> 4);
+        end
+      endcase
+      pipeline_step <= pipeline_step + 1;
+    end else if (pipeline_aux) begin
+      case (aux_step)
+        AUX_ENVELOPE: begin
+          env_volume[aux_voice] <= scaled_voice_output[7:0];   /* (envelope_level * volume) / 256 */
         end
+        AUX_VIBRATO_DEPTH: begin
+          // vibrato wave * depth => -255..255
+          lfo_vibrato_mod <= multiplier_output >>> 10;
+          lfo_vibrato_phase[aux_voice] <= aux_vibrato_phase + aux_vibrato_speed;
+        end
+        AUX_VIBRATO: begin
+          // (frequency / 128) * vibrato / 16 => up to +/- frequency * 255/2048
+          lfo_vibrato_offset[aux_voice] <= multiplier_output >>> 4;
+        end
+        AUX_PWM: begin
+          // pulse width wave * depth => -2040..2040
+          lfo_pwm_offset[aux_voice] <= multiplier_output >>> 7;
+          lfo_pwm_phase[aux_voice] <= aux_pwm_phase + aux_pwm_speed;
+          aux_voice <= (aux_voice == NUM_VOICES-1) ? 4'd0 : aux_voice + 1;
+        end
+      endcase
+      aux_step <= aux_step + 1;
+      pipeline_step <= STEP_GLOBAL;
+    end else if (pipeline_step == STEP_GLOBAL) begin
+      // latch sample values out
+      mixed_left <= { scaled_voice_output[SAMPLE_BITS-1:0],2'b0 };   /* scaled voice output now contains (global_volume * tmp_mixed_left) / 256 */
+      pipeline_step <= STEP_GLOBAL_RIGHT;
+    end else if (pipeline_step == STEP_GLOBAL_RIGHT) begin
+      mixed_right <= { scaled_voice_output[SAMPLE_BITS-1:0],2'b0 };
+      pipeline_step <= STEP_IDLE;  // move to "idle" state until next aclk
+    end else begin
+      // accumulator clock has gone high; reset state machine
+      if (!prev_aclk && aclk) begin
+        pipeline_step <= 0;
+        tmp_mixed_left <= 0;
+        tmp_mixed_right <= 0;
+        tmp_filter_input <= 0;
       end
-    endcase
+    end
 
     if (!resetn) begin
-      voice_num <= 0;
-      voice_pipeline_state <= 6'b100000;
-      lfsr[0] <= 23'b01101110010010000101011;
-      lfsr[1] <= 23'b01101110010010000101011;
-      lfsr[2] <= 23'b01101110010010000101011;
-      lfsr[3] <= 23'b01101110010010000101011;
+      pipeline_step <= STEP_IDLE;
+      aux_voice <= 0;
+      aux_step <= AUX_ENVELOPE;
+      env_trigger_ack <= 0;
+      ringmod_bit <= 0;
+      sync_bit <= 0;
+      filter_lowpass <= 0;
+      filter_bandpass <= 0;
+      filter_highpass <= 0;
+      for (i = 0; i < NUM_VOICES; i = i + 1) begin
+        lfsr[i] <= 23'b01101110010010000101011;
+        env_level[i] <= 0;
+        env_state[i] <= ENV_RELEASE;
+        env_volume[i] <= 0;
+        lfo_vibrato_offset[i] <= 0;
+        lfo_pwm_offset[i] <= 0;
+      end
     end
   end
 
 endmodule
-
-`endif
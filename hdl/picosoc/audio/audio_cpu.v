@@ -0,0 +1,371 @@
+/*
+ * Audio co-processor
+ *
+ * A second, minimal picorv32, which only has access to the audio peripheral,
+ * a mailbox, its own (data) RAM, and the flash it runs its program from.  It
+ * runs the songplayer on its own, so music timing doesn't depend on the main
+ * CPU (or its IRQs) at all.
+ *
+ * Sits between the main CPU and the audio peripheral, and shares the audio
+ * peripheral between the two CPUs (the main CPU goes first if both start an
+ * access in the same clock).
+ *
+ * The program runs straight out of the flash (through the SoC's dma port,
+ * after the audio peripheral's own PCM and sequencer reads), through a small
+ * direct-mapped cache of single words.  The program is far too big for the
+ * block RAM that's left once there's video; only .data, .bss and the stack
+ * are in the co-processor's RAM.
+ *
+ * Main CPU view (0x0410_0000, everything else in 0x04xx_xxxx is the audio peripheral):
+ *   0: control  | 0: run |  (clearing it holds the co-processor in reset, and
+ *                 empties the cache; it starts once the cache is empty)
+ *   1: command  | 31-24: command | 23-0: argument |  (reads back zero once
+ *                 the co-processor has taken the command)
+ *   2: status   | set by the co-processor |  (read-only)
+ *   3: timer    | free-running microsecond counter |  (read-only)
+ *   4: code     | 23-2: flash address of the program |  (only change it while stopped)
+ *
+ * Co-processor view :
+ *   0x0000_0000: RAM (MEM_WORDS words; the stack starts at the top)
+ *   0x0100_0000: the program in flash (read-only, starting at code; the program starts here)
+ *   0x0400_0000: audio peripheral (as for the main CPU)
+ *   0x0410_0000: mailbox - 1: command (writing clears it), 2: status, 3: timer
+ */
+
+module audio_cpu
+#(
+  parameter integer MEM_WORDS = 512,    // 2KBytes (4 BRAMs)
+  parameter integer CACHE_WORDS = 256   // 1KByte (2 BRAMs, and 1 for the tags)
+)
+(
+  input resetn,
+  input clk,
+
+  // main CPU accesses to 0x04xx_xxxx
+  input iomem_valid,
+  input [3:0]  iomem_wstrb,
+  input [31:0] iomem_addr,
+  input [31:0] iomem_wdata,
+  output iomem_ready,
+  output [31:0] iomem_rdata,
+
+  // to the audio peripheral
+  output audio_valid,
+  output [3:0] audio_wstrb,
+  output [31:0] audio_addr,
+  output [31:0] audio_wdata,
+  input audio_ready,
+  input [31:0] audio_rdata,
+
+  // the audio peripheral's flash reads
+  input audio_dma_valid,
+  input [23:0] audio_dma_addr,
+  output audio_dma_ready,
+  output [31:0] audio_dma_rdata,
+
+  // to the SoC's flash read port (valid is held until ready)
+  output dma_valid,
+  output [23:0] dma_addr,
+  input dma_ready,
+  input [31:0] dma_rdata);
+
+  localparam REG_CONTROL = 3'd0;
+  localparam REG_COMMAND = 3'd1;
+  localparam REG_STATUS = 3'd2;
+  localparam REG_TIMER = 3'd3;
+  localparam REG_CODE = 3'd4;
+
+  localparam CACHE_BITS = $clog2(CACHE_WORDS);
+  localparam TAG_BITS = 22 - CACHE_BITS;
+
+  localparam CACHE_IDLE = 2'd0;
+  localparam CACHE_LOOKUP = 2'd1;   // reading the tag and data
+  localparam CACHE_FILL = 2'd2;     // reading the word from flash
+  localparam CACHE_DONE = 2'd3;
+
+  reg run;
+  reg [31:0] command;
+  reg [31:0] status;
+  reg [31:0] timer;
+  reg [3:0] timer_prescale;
+  reg [21:0] code_base;
+
+  wire main_local = iomem_valid && iomem_addr[20];
+  wire main_audio = iomem_valid && !iomem_addr[20];
+  wire main_local_access;
+
+  ///////////////////////////////////////////////////////////////////
+  // co-processor
+  ///////////////////////////////////////////////////////////////////
+  wire        cpu_mem_valid;
+  wire        cpu_mem_ready;
+  wire [31:0] cpu_mem_addr;
+  wire [31:0] cpu_mem_wdata;
+  wire [3:0]  cpu_mem_wstrb;
+  wire [31:0] cpu_mem_rdata;
+
+  // the co-processor only starts once its cache has been emptied
+  reg cache_flushed;
+
+  // one register read port: the register file takes 2 BRAMs rather than 4,
+  // for a clock more on instructions that read two registers
+  picorv32 #(
+    .ENABLE_COUNTERS(0),
+    .ENABLE_COUNTERS64(0),
+    .ENABLE_REGS_16_31(1),
+    .ENABLE_REGS_DUALPORT(0),
+    .TWO_STAGE_SHIFT(0),
+    .BARREL_SHIFTER(0),
+    .COMPRESSED_ISA(0),
+    .CATCH_MISALIGN(0),
+    .CATCH_ILLINSN(0),
+    .ENABLE_MUL(0),
+    .ENABLE_DIV(0),
+    .ENABLE_IRQ(0),
+    .PROGADDR_RESET(32'h0100_0000),
+    .STACKADDR(4*MEM_WORDS)
+  ) cpu (
+    .clk(clk),
+    .resetn(resetn && run && cache_flushed),
+    .mem_valid(cpu_mem_valid),
+    .mem_ready(cpu_mem_ready),
+    .mem_addr(cpu_mem_addr),
+    .mem_wdata(cpu_mem_wdata),
+    .mem_wstrb(cpu_mem_wstrb),
+    .mem_rdata(cpu_mem_rdata),
+    .pcpi_wr(1'b0),
+    .pcpi_rd(32'h0),
+    .pcpi_wait(1'b0),
+    .pcpi_ready(1'b0),
+    .irq(32'h0));
+
+  wire cpu_ram = cpu_mem_addr < 4*MEM_WORDS;
+  wire cpu_flash = (cpu_mem_addr[31:24] == 8'h01) && !(|cpu_mem_wstrb);
+  wire cpu_io = (cpu_mem_addr[31:24] == 8'h04);
+  wire cpu_mailbox = cpu_io && cpu_mem_addr[20];
+  wire cpu_audio = cpu_io && !cpu_mem_addr[20];
+
+  ///////////////////////////////////////////////////////////////////
+  // RAM
+  ///////////////////////////////////////////////////////////////////
+  reg ram_ready;
+  wire [31:0] ram_rdata;
+  wire cpu_ram_access = cpu_mem_valid && !cpu_mem_ready && cpu_ram;
+
+  picosoc_mem #(.WORDS(MEM_WORDS)) memory (
+    .clk(clk),
+    .wen(cpu_ram_access ? cpu_mem_wstrb : 4'b0),
+    .addr(cpu_mem_addr[23:2]),
+    .wdata(cpu_mem_wdata),
+    .rdata(ram_rdata));
+
+  always @(posedge clk) begin
+    ram_ready <= cpu_ram_access;
+  end
+
+  ///////////////////////////////////////////////////////////////////
+  // program cache :: one word per line, tagged with the rest of the
+  // word address.  A miss reads just that word, so straight-line code
+  // still gets the flash's quicker sequential reads.
+  ///////////////////////////////////////////////////////////////////
+  reg [1:0] cache_state;
+  reg [CACHE_BITS-1:0] flush_index;
+  reg [23:0] fill_addr;
+  reg [31:0] fill_rdata;
+
+  reg [TAG_BITS:0] cache_tags[0:CACHE_WORDS-1];   // { valid, tag }
+  reg [TAG_BITS:0] cache_tag;
+  wire [31:0] cache_rdata;
+
+  wire [CACHE_BITS-1:0] cache_index = cache_flushed ? cpu_mem_addr[CACHE_BITS+1:2] : flush_index;
+  wire [TAG_BITS-1:0] cpu_tag = cpu_mem_addr[23:CACHE_BITS+2];
+  wire cache_hit = (cache_tag == { 1'b1, cpu_tag });
+
+  // (a fill that finishes after the co-processor was stopped isn't kept)
+  wire fill_ready;
+  wire cache_write = (cache_state == CACHE_FILL) && fill_ready && cache_flushed;
+  wire flush_write = !cache_flushed && (cache_state == CACHE_IDLE);
+
+  picosoc_mem #(.WORDS(CACHE_WORDS)) cache_memory (
+    .clk(clk),
+    .wen(cache_write ? 4'b1111 : 4'b0),
+    .addr(cache_index),
+    .wdata(dma_rdata),
+    .rdata(cache_rdata));
+
+  always @(posedge clk) begin
+    cache_tag <= cache_tags[cache_index];
+    if (cache_write || flush_write) begin
+      cache_tags[cache_index] <= { cache_write, cpu_tag };
+    end
+    if (flush_write) begin
+      flush_index <= flush_index + 1;
+      if (&flush_index) begin
+        cache_flushed <= 1;
+      end
+    end
+
+    case (cache_state)
+      CACHE_IDLE: begin
+        if (cpu_mem_valid && cpu_flash && cache_flushed) begin
+          cache_state <= CACHE_LOOKUP;
+        end
+      end
+      CACHE_LOOKUP: begin
+        cache_state <= cache_hit ? CACHE_IDLE : CACHE_FILL;
+        fill_addr <= { code_base + cpu_mem_addr[23:2], 2'b00 };
+      end
+      CACHE_FILL: begin
+        if (fill_ready) begin
+          fill_rdata <= dma_rdata;
+          cache_state <= CACHE_DONE;
+        end
+      end
+      default: begin
+        cache_state <= CACHE_IDLE;
+      end
+    endcase
+
+    if (!resetn) begin
+      cache_state <= CACHE_IDLE;
+      cache_flushed <= 0;
+      flush_index <= 0;
+    end else if (main_local_access && iomem_addr[4:2] == REG_CONTROL && iomem_wstrb[0] && !iomem_wdata[0]) begin
+      cache_flushed <= 0;
+      flush_index <= 0;
+    end
+  end
+
+  wire cache_ready = ((cache_state == CACHE_LOOKUP) && cache_hit) || (cache_state == CACHE_DONE);
+  wire [31:0] cache_rdata_out = (cache_state == CACHE_DONE) ? fill_rdata : cache_rdata;
+
+  ///////////////////////////////////////////////////////////////////
+  // flash, shared between the audio peripheral (which goes first) and
+  // the cache.  Once a read has started, it keeps the flash until it completes.
+  ///////////////////////////////////////////////////////////////////
+  wire fill_valid = (cache_state == CACHE_FILL);
+  reg flash_busy;
+  reg flash_busy_cache;
+  wire flash_cache_sel = flash_busy ? flash_busy_cache : !audio_dma_valid;
+
+  assign dma_valid = flash_cache_sel ? fill_valid : audio_dma_valid;
+  assign dma_addr = flash_cache_sel ? fill_addr : audio_dma_addr;
+  assign audio_dma_ready = dma_ready && !flash_cache_sel;
+  assign audio_dma_rdata = dma_rdata;
+  assign fill_ready = dma_ready && flash_cache_sel;
+
+  always @(posedge clk) begin
+    if (!resetn || dma_ready) begin
+      flash_busy <= 0;
+    end else if (!flash_busy && dma_valid) begin
+      flash_busy <= 1;
+      flash_busy_cache <= flash_cache_sel;
+    end
+  end
+
+  ///////////////////////////////////////////////////////////////////
+  // audio peripheral, shared between the two CPUs.  An access is
+  // acknowledged a clock after it starts, and the owner is held until then.
+  ///////////////////////////////////////////////////////////////////
+  wire cpu_audio_req = cpu_mem_valid && cpu_audio;
+  reg audio_busy;
+  reg audio_owner_cpu;
+  wire audio_grant_cpu = audio_busy ? audio_owner_cpu : !main_audio;
+
+  assign audio_valid = audio_grant_cpu ? cpu_audio_req : main_audio;
+  assign audio_wstrb = audio_grant_cpu ? cpu_mem_wstrb : iomem_wstrb;
+  assign audio_addr = audio_grant_cpu ? cpu_mem_addr : iomem_addr;
+  assign audio_wdata = audio_grant_cpu ? cpu_mem_wdata : iomem_wdata;
+
+  always @(posedge clk) begin
+    if (audio_valid && !audio_ready) begin
+      audio_busy <= 1;
+      audio_owner_cpu <= audio_grant_cpu;
+    end
+    if (audio_ready || !resetn) begin
+      audio_busy <= 0;
+    end
+  end
+
+  ///////////////////////////////////////////////////////////////////
+  // mailbox and timer
+  ///////////////////////////////////////////////////////////////////
+  reg local_ready;
+  reg [31:0] local_rdata;
+  reg mailbox_ready;
+  reg [31:0] mailbox_rdata;
+
+  assign main_local_access = main_local && !local_ready;
+  wire cpu_mailbox_access = cpu_mem_valid && cpu_mailbox && !mailbox_ready;
+
+  always @(posedge clk) begin
+    timer_prescale <= timer_prescale + 1;
+    if (timer_prescale == 4'd15) begin
+      timer <= timer + 1;
+    end
+
+    mailbox_ready <= cpu_mailbox_access;
+    if (cpu_mailbox_access) begin
+      case (cpu_mem_addr[4:2])
+        REG_COMMAND: mailbox_rdata <= command;
+        REG_STATUS: mailbox_rdata <= status;
+        REG_TIMER: mailbox_rdata <= timer;
+        default: mailbox_rdata <= 32'h0;
+      endcase
+      if (|cpu_mem_wstrb && cpu_mem_addr[4:2] == REG_COMMAND) begin
+        command <= 32'h0;
+      end
+      if (&cpu_mem_wstrb && cpu_mem_addr[4:2] == REG_STATUS) begin
+        status <= cpu_mem_wdata;
+      end
+    end
+
+    // (a new command from the main CPU wins over the co-processor clearing the old one)
+    local_ready <= main_local_access;
+    if (main_local_access) begin
+      case (iomem_addr[4:2])
+        REG_CONTROL: local_rdata <= { 31'b0, run };
+        REG_COMMAND: local_rdata <= command;
+        REG_STATUS: local_rdata <= status;
+        REG_TIMER: local_rdata <= timer;
+        REG_CODE: local_rdata <= { 8'h00, code_base, 2'b00 };
+        default: local_rdata <= 32'h0;
+      endcase
+      if (iomem_wstrb[0] && iomem_addr[4:2] == REG_CONTROL) begin
+        run <= iomem_wdata[0];
+      end
+      if (&iomem_wstrb && iomem_addr[4:2] == REG_COMMAND) begin
+        command <= iomem_wdata;
+      end
+      if (&iomem_wstrb && iomem_addr[4:2] == REG_CODE) begin
+        code_base <= iomem_wdata[23:2];
+      end
+    end
+
+    if (!resetn) begin
+      run <= 0;
+      command <= 0;
+      status <= 0;
+      timer <= 0;
+      timer_prescale <= 0;
+      code_base <= 0;
+      local_ready <= 0;
+      mailbox_ready <= 0;
+    end
+  end
+
+  assign iomem_ready = main_local ? local_ready : (audio_ready && !audio_grant_cpu);
+  assign iomem_rdata = main_local ? local_rdata : audio_rdata;
+
+  assign cpu_mem_ready = cpu_ram ? ram_ready
+                       : cpu_flash ? cache_ready
+                       : cpu_mailbox ? mailbox_ready
+                       : cpu_audio ? (audio_ready && audio_grant_cpu)
+                       : cpu_mem_valid;    // nothing else here; reads as zero
+  assign cpu_mem_rdata = cpu_ram ? ram_rdata
+                       : cpu_flash ? cache_rdata_out
+                       : cpu_mailbox ? mailbox_rdata
+                       : cpu_audio ? audio_rdata
+                       : 32'h0;
+
+endmodule
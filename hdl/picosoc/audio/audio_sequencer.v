@@ -0,0 +1,250 @@
+/*
+ * Audio sequencer
+ *
+ * Plays programs of timed audio register writes straight out of the SPI
+ * flash (through the audio peripheral's dma port), so music can play without
+ * any CPU time, and without any BRAM.  There are two tracks, each with its
+ * own program, so a sound effect can be started on one while music carries
+ * on playing on the other.
+ *
+ * A program is a list of 32 bit words, made up of commands :
+ *
+ *   0000 xxxx xxxx xxxx xxxx xxxx xxxx xxxx  END    stop (or jump to the loop address, if looping)
+ *   0001 xxxx xxxx xxxx TTTT TTTT TTTT TTTT  WAIT   wait T ticks
+ *   0010 xAAA AAAA AAxx xxxx xxxx xxxx xxxx  WRITE  write the next word to byte offset A
+ *                                                   (from 0x0400_0000)
+ *   0011 xAAA AAAA AAAA xxxx xxxx VVVV VVVV  WRITE_BYTE  write byte V to byte offset A
+ *   0100 xAAA AAAA AAAx VVVV VVVV VVVV VVVV  WRITE_HALF  write V to the half word at A
+ *
+ * anything else stops the track.  Writes go through the same decoding as the
+ * CPU's, so they can reach the voice and global registers, and the wavetables
+ * (but not the sequencer's own registers).
+ *
+ * Registers (mapped to 0x0400_0600 by audio), for track t = 0 or 1:
+ *   t*4+0: control  | 0: play |
+ *                     writing 1 starts the track from its start address, 0 stops it.
+ *                     (the request takes effect between commands.)  Reads back 1 while playing.
+ *   t*4+1: start    | 23-2: flash address of the program |
+ *   t*4+2: loop     | 31: loop enable | 23-2: flash address to jump to at END |
+ *   t*4+3: pc       | 23-2: flash address of the next command (read only) |
+ *   8:     tick     | 15-0: tick length, in microseconds (eg. 20000 for 50Hz) |
+ */
+module audio_sequencer
+(
+  input resetn,
+  input clk,
+  input tick_us,              /* pulses once every microsecond */
+
+  input iomem_valid,          /* an access to the sequencer registers */
+  input [3:0]  iomem_wstrb,
+  input [31:0] iomem_addr,
+  input [31:0] iomem_wdata,
+  output reg [31:0] rdata,
+
+  // flash reads (valid is held until ready)
+  output dma_valid,
+  output [23:0] dma_addr,
+  input dma_ready,
+  input [31:0] dma_rdata,
+
+  // writes to the audio peripheral (valid is held until ready)
+  output write_valid,
+  output reg [10:0] write_addr,
+  output reg [3:0] write_wstrb,
+  output reg [31:0] write_wdata,
+  input write_ready);
+
+  localparam NUM_TRACKS = 2;
+
+  localparam REG_CONTROL = 2'd0;
+  localparam REG_START = 2'd1;
+  localparam REG_LOOP = 2'd2;
+  localparam REG_PC = 2'd3;
+
+  localparam OP_END = 4'h0;
+  localparam OP_WAIT = 4'h1;
+  localparam OP_WRITE = 4'h2;
+  localparam OP_WRITE_BYTE = 4'h3;
+  localparam OP_WRITE_HALF = 4'h4;
+
+  localparam STATE_SELECT = 3'd0;     // pick a track with a command to run
+  localparam STATE_FETCH = 3'd1;      // reading the command from flash
+  localparam STATE_DECODE = 3'd2;
+  localparam STATE_FETCH_DATA = 3'd3; // reading the value of a WRITE
+  localparam STATE_WRITE = 3'd4;
+
+  wire reg_write = iomem_valid && |iomem_wstrb;
+  wire reg_tick = iomem_addr[5];
+  wire reg_track = iomem_addr[4];
+  wire [1:0] reg_addr = iomem_addr[3:2];
+
+  reg [21:0] start_addr[0:NUM_TRACKS-1];
+  reg [21:0] loop_addr[0:NUM_TRACKS-1];
+  reg [NUM_TRACKS-1:0] loop_enable;
+  reg [15:0] tick_length;
+
+  // play/stop requests from the CPU, applied between commands
+  reg [NUM_TRACKS-1:0] request;
+  reg [NUM_TRACKS-1:0] request_play;
+
+  reg [2:0] state;
+  reg track;                          // the track whose command is running
+  reg [31:0] command;
+  reg [NUM_TRACKS-1:0] playing;
+  reg [21:0] pc[0:NUM_TRACKS-1];
+  reg [15:0] wait_ticks[0:NUM_TRACKS-1];
+  reg [15:0] tick_count;
+  wire tick = tick_us && (tick_count == 0);
+
+  wire [NUM_TRACKS-1:0] runnable = { playing[1] && wait_ticks[1] == 0, playing[0] && wait_ticks[0] == 0 };
+  wire [NUM_TRACKS-1:0] status_playing = (request & request_play) | (~request & playing);
+
+  assign dma_valid = (state == STATE_FETCH) || (state == STATE_FETCH_DATA);
+  assign dma_addr = { pc[track], 2'b00 };
+  assign write_valid = (state == STATE_WRITE);
+
+  wire [3:0] opcode = command[31:28];
+
+  always @(*) begin
+    if (reg_tick) begin
+      rdata = { 16'h0000, tick_length };
+    end else begin
+      case (reg_addr)
+        REG_CONTROL: rdata = { 31'b0, status_playing[reg_track] };
+        REG_START: rdata = { 8'h00, start_addr[reg_track], 2'b00 };
+        REG_LOOP: rdata = { loop_enable[reg_track], 7'b0, loop_addr[reg_track], 2'b00 };
+        default: rdata = { 8'h00, pc[reg_track], 2'b00 };
+      endcase
+    end
+  end
+
+  integer t;
+
+  always @(posedge clk) begin
+    // free-running tick timer
+    if (tick_us) begin
+      tick_count <= (tick_count == 0) ? tick_length - 1 : tick_count - 1;
+    end
+    for (t = 0; t < NUM_TRACKS; t = t + 1) begin
+      if (tick && wait_ticks[t] != 0) begin
+        wait_ticks[t] <= wait_ticks[t] - 1;
+      end
+    end
+
+    case (state)
+      STATE_SELECT: begin
+        if (|request) begin
+          for (t = 0; t < NUM_TRACKS; t = t + 1) begin
+            if (request[t]) begin
+              playing[t] <= request_play[t];
+              pc[t] <= start_addr[t];
+              wait_ticks[t] <= 0;
+            end
+          end
+          request <= 0;
+        end else if (runnable[!track]) begin
+          // take turns, so neither track holds up the other
+          track <= !track;
+          state <= STATE_FETCH;
+        end else if (runnable[track]) begin
+          state <= STATE_FETCH;
+        end
+      end
+
+      STATE_FETCH: begin
+        if (dma_ready) begin
+          command <= dma_rdata;
+          pc[track] <= pc[track] + 1;
+          state <= STATE_DECODE;
+        end
+      end
+
+      STATE_DECODE: begin
+        write_addr <= command[26:16];
+        state <= STATE_SELECT;
+        case (opcode)
+          OP_WAIT: begin
+            wait_ticks[track] <= command[15:0];
+          end
+          OP_WRITE: begin
+            write_wstrb <= 4'b1111;
+            state <= STATE_FETCH_DATA;
+          end
+          OP_WRITE_BYTE: begin
+            write_wstrb <= 4'b0001 << command[17:16];
+            write_wdata <= {4{command[7:0]}};
+            state <= STATE_WRITE;
+          end
+          OP_WRITE_HALF: begin
+            write_wstrb <= command[17] ? 4'b1100 : 4'b0011;
+            write_wdata <= {2{command[15:0]}};
+            state <= STATE_WRITE;
+          end
+          OP_END: begin
+            if (loop_enable[track]) begin
+              pc[track] <= loop_addr[track];
+            end else begin
+              playing[track] <= 0;
+            end
+          end
+          default: begin
+            playing[track] <= 0;
+          end
+        endcase
+      end
+
+      STATE_FETCH_DATA: begin
+        if (dma_ready) begin
+          write_wdata <= dma_rdata;
+          pc[track] <= pc[track] + 1;
+          state <= STATE_WRITE;
+        end
+      end
+
+      STATE_WRITE: begin
+        if (write_ready) begin
+          state <= STATE_SELECT;
+        end
+      end
+
+      default: begin
+        state <= STATE_SELECT;
+      end
+    endcase
+
+    if (reg_write && !reg_tick) begin
+      case (reg_addr)
+        REG_CONTROL: begin
+          if (iomem_wstrb[0]) begin
+            request[reg_track] <= 1;
+            request_play[reg_track] <= iomem_wdata[0];
+          end
+        end
+        REG_START: begin
+          start_addr[reg_track] <= iomem_wdata[23:2];
+        end
+        REG_LOOP: begin
+          loop_addr[reg_track] <= iomem_wdata[23:2];
+          loop_enable[reg_track] <= iomem_wdata[31];
+        end
+        default: ;
+      endcase
+    end
+    if (reg_write && reg_tick) begin
+      tick_length <= iomem_wdata[15:0];
+    end
+
+    if (!resetn) begin
+      state <= STATE_SELECT;
+      track <= 0;
+      playing <= 0;
+      request <= 0;
+      loop_enable <= 0;
+      wait_ticks[0] <= 0;
+      wait_ticks[1] <= 0;
+      tick_length <= 16'd20000;
+      tick_count <= 0;
+    end
+  end
+
+endmodule
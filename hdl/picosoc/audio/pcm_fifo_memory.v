@@ -0,0 +1,16 @@
+// 1 BRAM
+// PCM sample FIFO = 256 x 16 bits = 512 bytes
+module pcm_fifo_memory (
+    input clk, wen, ren,
+    input [7:0] waddr, raddr,
+    input [15:0] wdata,
+    output reg [15:0] rdata
+);
+    reg [15:0] mem [0:255];
+    always @(posedge clk) begin
+      if (ren)
+        rdata <= mem[raddr];
+      if (wen)
+        mem[waddr] <= wdata;
+    end
+endmodule
@@ -7,7 +7,7 @@
  * to the data-in (din) value.  It can be filtered to an analog output
  * using a low-pass filter (eg. an RC filter).
  *
- * Principle of operation:
+ * Principle of operation (ORDER = 1):
  *
  * This works by repeatedly adding the input (din) value to an accumulator of the
  * same width, and setting the output to "1" if the accumulator overflows.
@@ -16,22 +16,61 @@
  *
  * (The accumulator has to be an extra bit wider than data-in to accomodate
  *  the overflow (output) bit).
+ *
+ * ORDER = 2:
+ *
+ * A second-order sigma-delta modulator; two integrators in a row, each fed
+ * with the difference between its input and the (full-scale) output.  This
+ * pushes much more of the quantisation noise up to high frequencies, where the
+ * output filter removes it, and breaks up the idle tones the first-order DAC
+ * produces with small or constant inputs.  The integrators saturate, so that
+ * inputs close to full scale overload gracefully rather than oscillating.
  */
-module pdm_dac #(parameter SAMPLE_BITS = 12)(
+module pdm_dac #(parameter SAMPLE_BITS = 12, parameter ORDER = 1)(
   input signed [SAMPLE_BITS-1:0] din,
   input wire clk,
   output wire dout
 );
 
-reg [SAMPLE_BITS:0] accumulator;
-wire [SAMPLE_BITS-1:0] unsigned_din;
+generate
+  if (ORDER == 2) begin : second_order
+    localparam INTEGRATOR_BITS = SAMPLE_BITS + 4;
+    localparam signed [INTEGRATOR_BITS-1:0] FULL_SCALE = 2**(SAMPLE_BITS-1);
+    localparam signed [INTEGRATOR_BITS-1:0] INTEGRATOR_MAX = 2**(INTEGRATOR_BITS-1) - 1;
+    localparam signed [INTEGRATOR_BITS-1:0] INTEGRATOR_MIN = -(2**(INTEGRATOR_BITS-1));
+
+    reg signed [INTEGRATOR_BITS-1:0] integrator1;
+    reg signed [INTEGRATOR_BITS-1:0] integrator2;
+    reg out_bit;
+
+    wire signed [INTEGRATOR_BITS-1:0] feedback = out_bit ? FULL_SCALE : -FULL_SCALE;
+
+    wire signed [INTEGRATOR_BITS:0] sum1 = integrator1 + din - feedback;
+    wire signed [INTEGRATOR_BITS-1:0] next1 = (sum1[INTEGRATOR_BITS] == sum1[INTEGRATOR_BITS-1]) ? sum1[INTEGRATOR_BITS-1:0]
+                                            : sum1[INTEGRATOR_BITS] ? INTEGRATOR_MIN : INTEGRATOR_MAX;
+    wire signed [INTEGRATOR_BITS:0] sum2 = integrator2 + next1 - feedback;
+    wire signed [INTEGRATOR_BITS-1:0] next2 = (sum2[INTEGRATOR_BITS] == sum2[INTEGRATOR_BITS-1]) ? sum2[INTEGRATOR_BITS-1:0]
+                                            : sum2[INTEGRATOR_BITS] ? INTEGRATOR_MIN : INTEGRATOR_MAX;
+
+    always @(posedge clk) begin
+      integrator1 <= next1;
+      integrator2 <= next2;
+      out_bit <= !next2[INTEGRATOR_BITS-1];
+    end
+
+    assign dout = out_bit;
+  end else begin : first_order
+    reg [SAMPLE_BITS:0] accumulator;
+    wire [SAMPLE_BITS-1:0] unsigned_din;
 
-assign unsigned_din = din ^ (2**(SAMPLE_BITS-1));
+    assign unsigned_din = din ^ (2**(SAMPLE_BITS-1));
 
-always @(posedge clk) begin
-  accumulator <= (accumulator[SAMPLE_BITS-1 : 0] + unsigned_din);
-end
+    always @(posedge clk) begin
+      accumulator <= (accumulator[SAMPLE_BITS-1 : 0] + unsigned_din);
+    end
 
-assign dout = accumulator[SAMPLE_BITS];
+    assign dout = accumulator[SAMPLE_BITS];
+  end
+endgenerate
 
 endmodule
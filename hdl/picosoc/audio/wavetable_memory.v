@@ -0,0 +1,16 @@
+// 1 BRAM
+// voice wavetables = 512 x 8 bits (32 samples for each of up to 16 voices)
+module wavetable_memory (
+    input clk, wen, ren,
+    input [8:0] waddr, raddr,
+    input [7:0] wdata,
+    output reg [7:0] rdata
+);
+    reg [7:0] mem [0:511];
+    always @(posedge clk) begin
+      if (ren)
+        rdata <= mem[raddr];
+      if (wen)
+        mem[waddr] <= wdata;
+    end
+endmodule
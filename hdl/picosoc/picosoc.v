@@ -40,6 +40,13 @@ module picosoc (
 	input  irq_6,
 	input  irq_7,
 
+	// flash read port for peripherals (eg. audio sample streaming);
+	// served whenever the CPU isn't using the flash
+	input         dma_valid,
+	output        dma_ready,
+	input  [23:0] dma_addr,
+	output [31:0] dma_rdata,
+
 	output ser_tx,
 	input  ser_rx,
 
@@ -98,6 +105,27 @@ module picosoc (
 	wire spimem_ready;
 	wire [31:0] spimem_rdata;
 
+	// flash arbitration: the CPU gets the flash if it wants it, otherwise the dma
+	// port does.  Once a read has started, it keeps the flash until it completes.
+	wire cpu_flash_valid = mem_valid && mem_addr >= 4*MEM_WORDS && mem_addr < 32'h 0200_0000;
+	wire spimemio_ready;
+	reg flash_busy;
+	reg flash_busy_dma;
+	wire flash_dma_sel = flash_busy ? flash_busy_dma : (!cpu_flash_valid && dma_valid);
+
+	assign spimem_ready = spimemio_ready && !flash_dma_sel;
+	assign dma_ready = spimemio_ready && flash_dma_sel;
+	assign dma_rdata = spimem_rdata;
+
+	always @(posedge clk) begin
+		if (!resetn || spimemio_ready) begin
+			flash_busy <= 0;
+		end else if (!flash_busy && (cpu_flash_valid || dma_valid)) begin
+			flash_busy <= 1;
+			flash_busy_dma <= !cpu_flash_valid;
+		end
+	end
+
 	reg ram_ready;
 	wire [31:0] ram_rdata;
 
@@ -151,9 +179,9 @@ module picosoc (
 	spimemio spimemio (
 		.clk    (clk),
 		.resetn (resetn),
-		.valid  (mem_valid && mem_addr >= 4*MEM_WORDS && mem_addr < 32'h 0200_0000),
-		.ready  (spimem_ready),
-		.addr   (mem_addr[23:0]),
+		.valid  (flash_dma_sel ? dma_valid : cpu_flash_valid),
+		.ready  (spimemio_ready),
+		.addr   (flash_dma_sel ? dma_addr : mem_addr[23:0]),
 		.rdata  (spimem_rdata),
 
 		.flash_csb    (flash_csb   ),
@@ -0,0 +1,16 @@
+// 4 BRAMS
+// bitmap memory = 128x64 pixels @ 2bpp = 16384 bits or 2048 bytes
+module bitmap_memory (
+    input clk, wen, ren,
+    input [12:0] waddr, raddr,
+    input [1:0] wdata,
+    output reg [1:0] rdata
+);
+    reg [1:0] mem [0:8191];   // enough memory for a 128x64 bitmap window @ 2bpp
+    always @(posedge clk) begin
+      if (ren)
+        rdata <= mem[raddr];
+      if (wen)
+        mem[waddr] <= wdata;
+    end
+endmodule
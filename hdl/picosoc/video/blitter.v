@@ -0,0 +1,221 @@
+/*
+ * 2D blitter for the bitmap layer
+ *
+ * Draws into the 128x64 @ 2bpp bitmap memory one pixel per clock, so the
+ * CPU only has to set up a handful of registers per primitive.
+ *
+ * Registers (mapped to 0x0550_0000 by video_vga):
+ *   0: source        | 21-16: y | 6-0: x |  (copy source, or line end point)
+ *   1: destination   | 21-16: y | 6-0: x |  (fill/copy destination, or line start point)
+ *   2: size          | 22-16: height | 7-0: width |
+ *   3: colour        | 16: colour key enable | 9-8: colour key | 1-0: colour |
+ *   4: command       | 1-0: operation (1 = fill, 2 = copy, 3 = line) |
+ *                      writing a non-zero operation starts the blit (ignored while busy).
+ *                      reading returns the busy flag in bit 0.
+ *
+ * Pixels that fall outside the bitmap are clipped.  Copies run top-left to
+ * bottom-right, so overlapping copies should only move data up/left.
+ *
+ * The bitmap memory only has one read port, which is shared with the video
+ * scan-out; copies read a source pixel whenever the beam is not inside the
+ * bitmap window (rd_ready), and every blitter write waits for a free write
+ * port (wr_ready) so that CPU writes to the bitmap are never lost.
+ */
+
+module blitter
+(
+  input resetn,
+  input clk,
+	input iomem_valid,
+	input [3:0]  iomem_wstrb,
+	input [31:0] iomem_addr,
+	input [31:0] iomem_wdata,
+  output busy,
+  output reg irq,             /* pulses for one clock when a blit completes */
+
+  output mem_ren,
+  output [12:0] mem_raddr,
+  input [1:0] mem_rdata,
+  input rd_ready,
+
+  output mem_wen,
+  output [12:0] mem_waddr,
+  output [1:0] mem_wdata,
+  input wr_ready);
+
+  localparam REG_SRC = 0;
+  localparam REG_DST = 1;
+  localparam REG_SIZE = 2;
+  localparam REG_COLOUR = 3;
+  localparam REG_CMD = 4;
+
+  localparam OP_FILL = 2'd1;
+  localparam OP_COPY = 2'd2;
+  localparam OP_LINE = 2'd3;
+
+  localparam STATE_IDLE = 3'd0;
+  localparam STATE_FILL = 3'd1;
+  localparam STATE_COPY_READ = 3'd2;
+  localparam STATE_COPY_LATCH = 3'd3;
+  localparam STATE_COPY_WRITE = 3'd4;
+  localparam STATE_LINE = 3'd5;
+
+	reg [31:0] config_register_bank [0:3];
+  wire [2:0] bank_addr = iomem_addr[4:2];
+
+  wire [6:0] src_x = config_register_bank[REG_SRC][6:0];
+  wire [5:0] src_y = config_register_bank[REG_SRC][21:16];
+  wire [6:0] dst_x = config_register_bank[REG_DST][6:0];
+  wire [5:0] dst_y = config_register_bank[REG_DST][21:16];
+  wire [7:0] width = config_register_bank[REG_SIZE][7:0];
+  wire [6:0] height = config_register_bank[REG_SIZE][22:16];
+  wire [1:0] colour = config_register_bank[REG_COLOUR][1:0];
+  wire [1:0] colour_key = config_register_bank[REG_COLOUR][9:8];
+  wire colour_key_enable = config_register_bank[REG_COLOUR][16];
+
+  reg [2:0] state;
+  assign busy = (state != STATE_IDLE);
+
+  wire cmd_write = iomem_valid && iomem_wstrb[0] && (bank_addr == REG_CMD);
+
+  ///////////////////////////////////////////////////////////////////
+  // rectangle (fill/copy) position
+  ///////////////////////////////////////////////////////////////////
+  reg [7:0] rect_x;   // column within the rectangle
+  reg [6:0] rect_y;   // row within the rectangle
+  wire rect_last_x = (rect_x == width - 1);
+  wire rect_last_y = (rect_y == height - 1);
+
+  wire [8:0] rect_dst_x = dst_x + rect_x;
+  wire [7:0] rect_dst_y = dst_y + rect_y;
+  wire [8:0] rect_src_x = src_x + rect_x;
+  wire [7:0] rect_src_y = src_y + rect_y;
+  wire rect_dst_visible = (rect_dst_x[8:7] == 2'b00) && (rect_dst_y[7:6] == 2'b00);
+  wire rect_src_visible = (rect_src_x[8:7] == 2'b00) && (rect_src_y[7:6] == 2'b00);
+
+  reg [1:0] copy_pixel;
+  reg copy_pixel_visible;
+
+  ///////////////////////////////////////////////////////////////////
+  // line (Bresenham) state
+  ///////////////////////////////////////////////////////////////////
+  reg [6:0] line_x;
+  reg [5:0] line_y;
+  reg line_step_x;    // 1 = step left, 0 = step right
+  reg line_step_y;    // 1 = step up, 0 = step down
+  reg signed [9:0] line_dx;   // abs(x1-x0)
+  reg signed [9:0] line_dy;   // -abs(y1-y0)
+  reg signed [9:0] line_err;
+  wire signed [10:0] line_e2 = $signed({ line_err, 1'b0 });
+  wire line_move_x = (line_e2 >= line_dy);
+  wire line_move_y = (line_e2 <= line_dx);
+  wire line_done = (line_x == src_x) && (line_y == src_y);
+
+  wire [6:0] line_dx_abs = (src_x >= dst_x) ? src_x - dst_x : dst_x - src_x;
+  wire [5:0] line_dy_abs = (src_y >= dst_y) ? src_y - dst_y : dst_y - src_y;
+
+  ///////////////////////////////////////////////////////////////////
+  // memory ports
+  ///////////////////////////////////////////////////////////////////
+  assign mem_ren = (state == STATE_COPY_READ);
+  assign mem_raddr = { rect_src_y[5:0], rect_src_x[6:0] };
+
+  wire copy_keyed_out = colour_key_enable && (copy_pixel == colour_key);
+
+  assign mem_wen = (state == STATE_FILL) ? rect_dst_visible
+                 : (state == STATE_COPY_WRITE) ? (rect_dst_visible && copy_pixel_visible && !copy_keyed_out)
+                 : (state == STATE_LINE);
+  assign mem_waddr = (state == STATE_LINE) ? { line_y, line_x } : { rect_dst_y[5:0], rect_dst_x[6:0] };
+  assign mem_wdata = (state == STATE_COPY_WRITE) ? copy_pixel : colour;
+
+  ///////////////////////////////////////////////////////////////////
+  //    Handle PicoSoC writing to the config register bank
+  ///////////////////////////////////////////////////////////////////
+	always @(posedge clk) begin
+		if (iomem_valid && (bank_addr < REG_CMD)) begin
+			if (iomem_wstrb[0]) config_register_bank[bank_addr][ 7: 0] <= iomem_wdata[ 7: 0];
+			if (iomem_wstrb[1]) config_register_bank[bank_addr][15: 8] <= iomem_wdata[15: 8];
+			if (iomem_wstrb[2]) config_register_bank[bank_addr][23:16] <= iomem_wdata[23:16];
+			if (iomem_wstrb[3]) config_register_bank[bank_addr][31:24] <= iomem_wdata[31:24];
+		end
+	end
+
+  ///////////////////////////////////////////////////////////////////
+  // blit state machine
+  ///////////////////////////////////////////////////////////////////
+  always @(posedge clk) begin
+    irq <= 0;
+
+    case (state)
+      STATE_IDLE: begin
+        if (cmd_write) begin
+          rect_x <= 0;
+          rect_y <= 0;
+          line_x <= dst_x;
+          line_y <= dst_y;
+          line_step_x <= (src_x < dst_x);
+          line_step_y <= (src_y < dst_y);
+          line_dx <= { 3'b000, line_dx_abs };
+          line_dy <= -$signed({ 4'b0000, line_dy_abs });
+          line_err <= $signed({ 3'b000, line_dx_abs }) - $signed({ 4'b0000, line_dy_abs });
+
+          case (iomem_wdata[1:0])
+            OP_FILL: state <= (width != 0 && height != 0) ? STATE_FILL : STATE_IDLE;
+            OP_COPY: state <= (width != 0 && height != 0) ? STATE_COPY_READ : STATE_IDLE;
+            OP_LINE: state <= STATE_LINE;
+            default: state <= STATE_IDLE;
+          endcase
+        end
+      end
+
+      STATE_FILL, STATE_COPY_WRITE: begin
+        if (wr_ready) begin
+          state <= (state == STATE_FILL) ? STATE_FILL : STATE_COPY_READ;
+          rect_x <= rect_x + 1;
+          if (rect_last_x) begin
+            rect_x <= 0;
+            rect_y <= rect_y + 1;
+            if (rect_last_y) begin
+              state <= STATE_IDLE;
+              irq <= 1;
+            end
+          end
+        end
+      end
+
+      STATE_COPY_READ: begin
+        // the read is issued on this clock edge if the scan-out doesn't need the port
+        if (rd_ready) begin
+          copy_pixel_visible <= rect_src_visible;
+          state <= STATE_COPY_LATCH;
+        end
+      end
+
+      STATE_COPY_LATCH: begin
+        copy_pixel <= mem_rdata;
+        state <= STATE_COPY_WRITE;
+      end
+
+      STATE_LINE: begin
+        if (wr_ready) begin
+          if (line_done) begin
+            state <= STATE_IDLE;
+            irq <= 1;
+          end else begin
+            if (line_move_x) line_x <= line_step_x ? line_x - 1 : line_x + 1;
+            if (line_move_y) line_y <= line_step_y ? line_y - 1 : line_y + 1;
+            line_err <= line_err + (line_move_x ? line_dy : 10'sd0) + (line_move_y ? line_dx : 10'sd0);
+          end
+        end
+      end
+
+      default: state <= STATE_IDLE;
+    endcase
+
+    if (!resetn) begin
+      state <= STATE_IDLE;
+      irq <= 0;
+    end
+  end
+
+endmodule
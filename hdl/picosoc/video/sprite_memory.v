@@ -1,13 +1,16 @@
 
-// 4 BRAMS
-// sprite memory = 64 sprites @ 16x16 resolution @ 1bpp = 16384 bits or 2048 bytes
-module sprite_memory (
+// 4 BRAMS per bank (a second bank only fits in builds without the bitmap layer and
+// the audio FIFO/wavetables: see README.md)
+// sprite memory = 64 sprites @ 16x16 resolution @ 1bpp = 16384 bits or 2048 bytes per bank
+module sprite_memory #(
+    parameter BANK_BITS = 0     // 2**BANK_BITS banks of 64 sprite images
+) (
     input clk, wen, ren,
-    input [13:0] waddr, raddr,
+    input [BANK_BITS+13:0] waddr, raddr,
     input wdata,
     output reg rdata
 );
-    reg [0:0] mem [0:16383];   // enough memory for 64 16x16 sprites @ 1bpp
+    reg [0:0] mem [0:(16384<<BANK_BITS)-1];   // enough memory for 64 16x16 sprites @ 1bpp per bank
     always @(posedge clk) begin
       if (ren)
         rdata <= mem[raddr];
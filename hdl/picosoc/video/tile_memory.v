@@ -1,12 +1,12 @@
 
-// 6 BRAMS
+// 8 BRAMS
 module tile_memory (
     input clk, wen, ren,
     input [11:0] waddr, raddr,
-    input [5:0] wdata,
-    output reg [5:0] rdata
+    input [7:0] wdata,
+    output reg [7:0] rdata
 );
-    reg [5:0] mem [0:4095];   // enough memory for 64x64 map of tiles // uses ~6 BRAMS of Ice40
+    reg [7:0] mem [0:4095];   // enough memory for 64x64 map of tiles + a 2 bit attribute set per tile // uses ~8 BRAMS of Ice40
     always @(posedge clk) begin
       if (ren)
         rdata <= mem[raddr];
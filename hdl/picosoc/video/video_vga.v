@@ -4,6 +4,9 @@
  * 320x240 tile map based graphics adaptor
  *  texture memory mapped to 0x0510_0000
  *  tile memory mapped to 0x0520_0000
+ *  sprite memory mapped to 0x0530_0000
+ *  bitmap memory mapped to 0x0540_0000 (only when built with -Dvga_bitmap)
+ *  blitter mapped to 0x0550_0000 (only when built with -Dvga_bitmap -Dvga_blitter)
  */
 
 module video_vga
@@ -14,6 +17,8 @@ module video_vga
 	input [3:0]  iomem_wstrb,
 	input [31:0] iomem_addr,
 	input [31:0] iomem_wdata,
+  output [31:0] iomem_rdata,
+  output blit_irq,
   output vga_hsync,
   output vga_vsync,
   output vga_r,
@@ -32,11 +37,39 @@ module video_vga
   // video registers
   // 0: x scroll offset
   // 1: y scroll offset
-  // 2,3,4,5: sprite registers for sprites 1-4
+  // 2-9: sprite registers for sprites 1-8
+  // 10: bitmap window position / enable
+  // 11: bitmap palette
+  // 12: tile palette (alternate colours for tiles with the palette attribute set)
+  // 13: display control (fade level / display off)
+  // 14: sprite image bank (only with -Dvga_sprite_banks)
+  // 15: tile attribute sets
 
   localparam NUM_SPRITES = 8;
+  localparam NUM_REGISTERS = 16;
 
-	reg [31:0] config_register_bank [0:NUM_SPRITES+1];
+  localparam REG_BITMAP_POS = 10;
+  localparam REG_BITMAP_PALETTE = 11;
+  localparam REG_TILE_PALETTE = 12;
+  localparam REG_DISPLAY_CTRL = 13;
+  localparam REG_SPRITE_BANK = 14;
+  localparam REG_TILE_ATTRIBUTES = 15;
+
+  // with -Dvga_sprite_banks, sprite memory holds two banks of 64 images; the
+  // sprite bank register picks which bank the sprites' 6-bit image numbers
+  // refer to, so the CPU can upload into one bank while the other is shown.
+  // The second bank takes 4 more BRAMs, which with the bitmap's 4 is more
+  // than the HX8K has (see README.md).
+`ifdef vga_sprite_banks
+`ifdef vga_bitmap
+`error "-Dvga_sprite_banks and -Dvga_bitmap need more BRAMs than the HX8K has"
+`endif
+  localparam SPRITE_BANK_BITS = 1;
+`else
+  localparam SPRITE_BANK_BITS = 0;
+`endif
+
+	reg [31:0] config_register_bank [0:NUM_REGISTERS-1];
   wire [3:0] bank_addr = iomem_addr[5:2];
 
   // todo sprites
@@ -46,8 +79,10 @@ module video_vga
   wire texmem_write = (iomem_valid && iomem_wstrb[0] && iomem_addr[23:20]==4'h1);
   wire tilemem_write = (iomem_valid && iomem_wstrb[0] && iomem_addr[23:20]==4'h2);
   wire spritemem_write = (iomem_valid && iomem_wstrb[0] && iomem_addr[23:20]==4'h3);
+  wire bitmapmem_write = (iomem_valid && iomem_wstrb[0] && iomem_addr[23:20]==4'h4);
+  wire blitter_select = (iomem_valid && iomem_addr[23:20]==4'h5);
 
-  wire [5:0] tile_read_data;
+  wire [7:0] tile_read_data;
   wire [2:0] texture_read_data;
 
   wire [9:0] xofs = config_register_bank[0][8:0];
@@ -57,15 +92,48 @@ module video_vga
   wire [9:0] effective_x = half_xpos+xofs;
   wire [9:0] effective_next_x = next_xpos+xofs;
 
+  /////////////////////////////////////////////////////////////////
+  // Tile map entry
+  /////////////////////////////////////////////////////////////////
+  // | 7-6           | 5-0       |
+  // | attribute set | texture # |
+  //
+  // Each tile picks one of four attribute sets from the tile
+  // attributes register, one per nibble (set 0 in bits 3-0):
+  //
+  // | 3        | 2       | 1      | 0      |
+  // | priority | palette | flip y | flip x |
+  //
+  // flip x/y mirror the texture, palette remaps the texture colours
+  // through the tile palette register, and priority draws the tile's
+  // non-zero pixels in front of sprites and the bitmap layer.  (Two
+  // bits per tile rather than four keeps the tile map to 8 BRAMs.)
+  /////////////////////////////////////////////////////////////////
+
   // need to read ahead with tile memory to prevent edge-artifacts
   wire [11:0] tile_read_address = { effective_y[8:3], effective_next_x[8:3] };
   tile_memory tilemem(
     .clk(clk),
     .ren(video_active), .raddr(tile_read_address), .rdata(tile_read_data),
-    .wen(tilemem_write), .waddr(iomem_addr[13:2]), .wdata(iomem_wdata[5:0])
+    .wen(tilemem_write), .waddr(iomem_addr[13:2]), .wdata(iomem_wdata[7:0])
   );
 
-  wire [11:0] texture_read_address = { tile_read_data[5:0], effective_y[2:0], effective_x[2:0] };
+  wire [31:0] tile_attribute_sets = config_register_bank[REG_TILE_ATTRIBUTES];
+  wire [3:0] tile_attributes = tile_attribute_sets[{ tile_read_data[7:6], 2'b00 } +: 4];
+  wire tile_flip_x = tile_attributes[0];
+  wire tile_flip_y = tile_attributes[1];
+
+  // palette/priority are needed alongside the texture data, which arrives a clock later
+  reg tile_palette_select;
+  reg tile_priority;
+  always @(posedge clk) begin
+    tile_palette_select <= tile_attributes[2];
+    tile_priority <= tile_attributes[3];
+  end
+
+  wire [11:0] texture_read_address = { tile_read_data[5:0],
+                                       effective_y[2:0] ^ {3{tile_flip_y}},
+                                       effective_x[2:0] ^ {3{tile_flip_x}} };
   texture_memory texturemem(
     .clk(clk),
     .ren(video_active), .raddr(texture_read_address), .rdata(texture_read_data),
@@ -139,15 +207,146 @@ module video_vga
 
   wire sprite_read_data;
 
+`ifdef vga_sprite_banks
+  wire [SPRITE_BANK_BITS-1:0] sprite_bank = config_register_bank[REG_SPRITE_BANK][SPRITE_BANK_BITS-1:0];
+
+  sprite_memory #(.BANK_BITS(SPRITE_BANK_BITS)) spritemem(
+    .clk(clk),
+    .ren(video_active), .raddr({ sprite_bank, sprite_read_address }), .rdata(sprite_read_data),
+    .wen(spritemem_write), .waddr(iomem_addr[SPRITE_BANK_BITS+15:2]), .wdata(iomem_wdata[0])
+  );
+`else
   sprite_memory spritemem(
     .clk(clk),
     .ren(video_active), .raddr(sprite_read_address), .rdata(sprite_read_data),
     .wen(spritemem_write), .waddr(iomem_addr[15:2]), .wdata(iomem_wdata[0])
   );
+`endif
+
+  // tile palette register holds 8 alternate colours, one per nibble (colour 0 in bits 2-0)
+  wire [31:0] tile_palette = config_register_bank[REG_TILE_PALETTE];
+  wire [2:0] tile_palette_colour = tile_palette[{texture_read_data, 2'b00} +: 3];
+  wire [2:0] tile_colour = tile_palette_select ? tile_palette_colour : texture_read_data;
+  wire tile_foreground = tile_priority && (texture_read_data != 3'b000);
+
+  /////////////////////////////////////////////////////////////////
+  // Bitmap layer
+  /////////////////////////////////////////////////////////////////
+  // A 128x64 @ 2bpp bitmap that is overlaid on a movable window of
+  // the tile map.  The window is positioned in tile map (not screen)
+  // coordinates, so it scrolls along with the tiles underneath it.
+  //
+  // | 31     | 30-25 | 24-16 | 15-9 | 8-0  |
+  // | enable | N/A   | ypos  | N/A  | xpos |
+  //
+  // Pixel value 0 is transparent; values 1-3 select one of the three
+  // colours in the bitmap palette register:
+  //
+  // | 10-8     | 7 | 6-4      | 3 | 2-0      |
+  // | colour 3 |   | colour 2 |   | colour 1 |
+  /////////////////////////////////////////////////////////////////
+
+`ifdef vga_bitmap
+  wire bitmap_enable = config_register_bank[REG_BITMAP_POS][31];
+  wire [8:0] bitmap_xpos = config_register_bank[REG_BITMAP_POS][8:0];
+  wire [8:0] bitmap_ypos = config_register_bank[REG_BITMAP_POS][24:16];
+  wire [10:0] bitmap_palette = config_register_bank[REG_BITMAP_PALETTE][10:0];
+
+  // position of the next pixel relative to the bitmap window (wraps around the 512x512 map)
+  wire [8:0] bitmap_x = effective_next_x[8:0] - bitmap_xpos;
+  wire [8:0] bitmap_y = effective_y[8:0] - bitmap_ypos;
+  wire in_bitmap_window = bitmap_enable && (bitmap_x[8:7] == 2'b00) && (bitmap_y[8:6] == 3'b000);
+
+  wire [12:0] bitmap_read_address = { bitmap_y[5:0], bitmap_x[6:0] };
+  wire [1:0] bitmap_read_data;
+
+`ifdef vga_blitter
+  wire blit_busy;
+  wire blit_ren, blit_wen;
+  wire [12:0] blit_raddr, blit_waddr;
+  wire [1:0] blit_wdata;
+
+  // the blitter may read whenever the scan-out is not inside the bitmap window,
+  // and may write whenever the CPU isn't writing to bitmap memory
+  wire blit_rd_ready = !(video_active && in_bitmap_window);
+  wire blit_read = blit_ren && blit_rd_ready;
+
+  blitter blitter(
+    .clk(clk),
+    .resetn(resetn),
+    .iomem_valid(blitter_select),
+    .iomem_wstrb(iomem_wstrb),
+    .iomem_addr(iomem_addr),
+    .iomem_wdata(iomem_wdata),
+    .busy(blit_busy),
+    .irq(blit_irq),
+    .mem_ren(blit_ren), .mem_raddr(blit_raddr), .mem_rdata(bitmap_read_data), .rd_ready(blit_rd_ready),
+    .mem_wen(blit_wen), .mem_waddr(blit_waddr), .mem_wdata(blit_wdata), .wr_ready(!bitmapmem_write)
+  );
+
+  assign iomem_rdata = { 31'b0, blit_busy };
+
+  bitmap_memory bitmapmem(
+    .clk(clk),
+    .ren(video_active || blit_read), .raddr(blit_read ? blit_raddr : bitmap_read_address), .rdata(bitmap_read_data),
+    .wen(bitmapmem_write || blit_wen),
+    .waddr(bitmapmem_write ? iomem_addr[14:2] : blit_waddr),
+    .wdata(bitmapmem_write ? iomem_wdata[1:0] : blit_wdata)
+  );
+`else
+  bitmap_memory bitmapmem(
+    .clk(clk),
+    .ren(video_active), .raddr(bitmap_read_address), .rdata(bitmap_read_data),
+    .wen(bitmapmem_write), .waddr(iomem_addr[14:2]), .wdata(iomem_wdata[1:0])
+  );
+`endif
+
+  // bitmap data arrives a clock after the address, so delay the window test to match
+  reg bitmap_pixel_valid;
+  always @(posedge clk) begin
+    bitmap_pixel_valid <= in_bitmap_window;
+  end
+
+  wire bitmap_opaque = bitmap_pixel_valid && (bitmap_read_data != 2'b00);
+  wire [2:0] bitmap_colour = (bitmap_read_data == 2'd1) ? bitmap_palette[2:0]
+                           : (bitmap_read_data == 2'd2) ? bitmap_palette[6:4]
+                           : bitmap_palette[10:8];
+  wire [2:0] background_colour = bitmap_opaque ? bitmap_colour : tile_colour;
+`else
+  wire [2:0] background_colour = tile_colour;
+`endif
+
+`ifndef vga_blitter
+  assign iomem_rdata = 32'h0;
+  assign blit_irq = 1'b0;
+`endif
+
+  wire [2:0] sprite_colour = { sprite_b, sprite_g, sprite_r };
+  wire [2:0] pixel_colour = tile_foreground ? tile_colour
+                          : sprite_read_data ? sprite_colour
+                          : background_colour;
+
+  /////////////////////////////////////////////////////////////////
+  // Fade / display off
+  /////////////////////////////////////////////////////////////////
+  // | 8           | 7-4 | 3-0        |
+  // | display off | N/A | fade level |
+  //
+  // With only one bit per colour channel, brightness is faded with a
+  // 4x4 ordered dither: fade level n blanks n out of every 16 pixels
+  // (0 = full brightness).  Display off blanks the whole screen, so the
+  // tile/texture memories can be rebuilt without showing the mess.
+  /////////////////////////////////////////////////////////////////
+  localparam [63:0] BAYER_4X4 = 64'h5d7f_91b3_6e4c_a280;  // thresholds 0-15, indexed by {y[1:0], x[1:0]}
+
+  wire [3:0] fade_level = config_register_bank[REG_DISPLAY_CTRL][3:0];
+  wire display_off = config_register_bank[REG_DISPLAY_CTRL][8];
+  wire [3:0] fade_threshold = BAYER_4X4[{ half_ypos[1:0], half_xpos[1:0], 2'b00 } +: 4];
+  wire pixel_visible = video_active && !display_off && (fade_threshold >= fade_level);
 
-  assign vga_r = video_active && ((sprite_read_data && sprite_r) || (!sprite_read_data && texture_read_data[0]));
-  assign vga_g = video_active && ((sprite_read_data && sprite_g) || (!sprite_read_data && texture_read_data[1]));
-  assign vga_b = video_active && ((sprite_read_data && sprite_b) || (!sprite_read_data && texture_read_data[2]));
+  assign vga_r = pixel_visible && pixel_colour[0];
+  assign vga_g = pixel_visible && pixel_colour[1];
+  assign vga_b = pixel_visible && pixel_colour[2];
 
 	always @(posedge clk) begin
 		if (iomem_valid && reg_write) begin
@@ -167,6 +366,12 @@ module video_vga
       config_register_bank[7]<=32'h0;
       config_register_bank[8]<=32'h0;
       config_register_bank[9]<=32'h0;
+      config_register_bank[10]<=32'h0;
+      config_register_bank[11]<=32'h0;
+      config_register_bank[12]<=32'h0;
+      config_register_bank[13]<=32'h0;
+      config_register_bank[14]<=32'h0;
+      config_register_bank[15]<=32'h0;
     end
 	end
 
@@ -120,19 +120,89 @@ module top (
     wire i2c_en    = (iomem_addr[31:24] == 8'h07); /* I2C device mapped to 0x06xx_xxxx */
 
 
+    // flash read port (audio sample streaming and sequencing, and the audio co-processor)
+    wire        dma_valid;
+    wire        dma_ready;
+    wire [23:0] dma_addr;
+    wire [31:0] dma_rdata;
+
+    wire [31:0] audio_iomem_rdata;
+    wire audio_iomem_ready;
+
 `ifdef pdm_audio
-    wire audio_data;
-  	assign AUDIO_LEFT = audio_data;
-  	assign AUDIO_RIGHT = audio_data;
+    // the audio peripheral's bus (shared with the audio co-processor, if there is one)
+    wire        audio_bus_valid;
+    wire        audio_bus_ready;
+    wire [3:0]  audio_bus_wstrb;
+    wire [31:0] audio_bus_addr;
+    wire [31:0] audio_bus_wdata;
+    wire [31:0] audio_bus_rdata;
+
+    // the audio peripheral's flash reads (shared with the audio co-processor, if there is one)
+    wire        audio_dma_valid;
+    wire        audio_dma_ready;
+    wire [23:0] audio_dma_addr;
+    wire [31:0] audio_dma_rdata;
+
+`ifdef audio_cpu
+    audio_cpu audio_coprocessor(
+      .clk(CLK),
+      .resetn(resetn),
+      .iomem_valid(iomem_valid && audio_en),
+      .iomem_wstrb(iomem_wstrb),
+      .iomem_addr(iomem_addr),
+      .iomem_wdata(iomem_wdata),
+      .iomem_ready(audio_iomem_ready),
+      .iomem_rdata(audio_iomem_rdata),
+      .audio_valid(audio_bus_valid),
+      .audio_wstrb(audio_bus_wstrb),
+      .audio_addr(audio_bus_addr),
+      .audio_wdata(audio_bus_wdata),
+      .audio_ready(audio_bus_ready),
+      .audio_rdata(audio_bus_rdata),
+      .audio_dma_valid(audio_dma_valid),
+      .audio_dma_addr(audio_dma_addr),
+      .audio_dma_ready(audio_dma_ready),
+      .audio_dma_rdata(audio_dma_rdata),
+      .dma_valid(dma_valid),
+      .dma_addr(dma_addr),
+      .dma_ready(dma_ready),
+      .dma_rdata(dma_rdata)
+    );
+`else
+    assign audio_bus_valid = iomem_valid && audio_en;
+    assign audio_bus_wstrb = iomem_wstrb;
+    assign audio_bus_addr = iomem_addr;
+    assign audio_bus_wdata = iomem_wdata;
+    assign audio_iomem_ready = audio_bus_ready;
+    assign audio_iomem_rdata = audio_bus_rdata;
+    assign dma_valid = audio_dma_valid;
+    assign dma_addr = audio_dma_addr;
+    assign audio_dma_ready = dma_ready;
+    assign audio_dma_rdata = dma_rdata;
+`endif
+
   	audio audio_peripheral(
   		.clk(CLK),
   		.resetn(resetn),
-  		.audio_out(audio_data),
-  		.iomem_valid(iomem_valid && audio_en),
-  		.iomem_wstrb(iomem_wstrb),
-  		.iomem_addr(iomem_addr),
-  		.iomem_wdata(iomem_wdata)
+  		.iomem_ready(audio_bus_ready),
+  		.iomem_rdata(audio_bus_rdata),
+  		.audio_out_left(AUDIO_LEFT),
+  		.audio_out_right(AUDIO_RIGHT),
+  		.iomem_valid(audio_bus_valid),
+  		.iomem_wstrb(audio_bus_wstrb),
+  		.iomem_addr(audio_bus_addr),
+  		.iomem_wdata(audio_bus_wdata),
+  		.dma_valid(audio_dma_valid),
+  		.dma_addr(audio_dma_addr),
+  		.dma_ready(audio_dma_ready),
+  		.dma_rdata(audio_dma_rdata)
   );
+`else
+    assign audio_iomem_ready = 1'b1;
+    assign audio_iomem_rdata = 32'h0;
+    assign dma_valid = 1'b0;
+    assign dma_addr = 24'h000000;
 `endif
 
 `ifdef oled
@@ -151,6 +221,9 @@ module top (
   );
 `endif
 
+  wire [31:0] video_iomem_rdata;
+  wire video_blit_irq;
+
 `ifdef vga
       video_vga vga_video_peripheral(
       		.clk(CLK),
@@ -159,12 +232,17 @@ module top (
       		.iomem_wstrb(iomem_wstrb),
       		.iomem_addr(iomem_addr),
       		.iomem_wdata(iomem_wdata),
+      		.iomem_rdata(video_iomem_rdata),
+      		.blit_irq(video_blit_irq),
       		.vga_hsync(VGA_HSYNC),
       		.vga_vsync(VGA_VSYNC),
       		.vga_r(VGA_R),
       		.vga_g(VGA_G),
       		.vga_b(VGA_B)
       	);
+`else
+  assign video_iomem_rdata = 32'h0;
+  assign video_blit_irq = 1'b0;
 `endif
 
   wire [31:0] gpio_iomem_rdata;
@@ -215,9 +293,11 @@ wire i2c_iomem_ready;
 `endif
 
 
-assign iomem_ready = i2c_en ? i2c_iomem_ready : gpio_en ? gpio_iomem_ready : 1'b1;
-assign iomem_rdata =  i2c_iomem_ready ? i2c_iomem_rdata
-                    : gpio_iomem_ready ? gpio_iomem_rdata
+assign iomem_ready = i2c_en ? i2c_iomem_ready : gpio_en ? gpio_iomem_ready : audio_en ? audio_iomem_ready : 1'b1;
+assign iomem_rdata =  i2c_en ? i2c_iomem_rdata
+                    : gpio_en ? gpio_iomem_rdata
+                    : audio_en ? audio_iomem_rdata
+                    : video_en ? video_iomem_rdata
                     : 32'h0;
 
 picosoc #(
@@ -258,9 +338,14 @@ picosoc #(
 	.flash_io3_di (flash_io3_di),
 
 	.irq_5        (1'b0),
-	.irq_6        (1'b0        ),
+	.irq_6        (video_blit_irq),   /* blitter completion */
 	.irq_7        (1'b0        ),
 
+	.dma_valid    (dma_valid   ),
+	.dma_ready    (dma_ready   ),
+	.dma_addr     (dma_addr    ),
+	.dma_rdata    (dma_rdata   ),
+
 	.iomem_valid  (iomem_valid ),
 	.iomem_ready  (iomem_ready ),
 	.iomem_wstrb  (iomem_wstrb ),
@@ -6,5 +6,186 @@ void audio_set_global_volume(uint32_t volume)
   if (v > 255) {
     v = 255;
   }
-  reg_audio[REG_GLOBAL_VOLUME] = v;
+  AUDIO_WRITE(REG_GLOBAL_VOLUME, v);
+}
+
+void audio_play_sample(const struct audio_sample_t *sample, uint32_t volume)
+{
+  AUDIO_WRITE(REG_PCM_START, (uint32_t)(uintptr_t)sample->data);
+  AUDIO_WRITE(REG_PCM_LENGTH, sample->length);
+  AUDIO_WRITE(REG_PCM_LOOP, sample->loop_start | (sample->flags & PCM_LOOP_ENABLE));
+  AUDIO_WRITE(REG_PCM_RATE, sample->rate);
+  AUDIO_WRITE(REG_PCM_CTRL, PCM_PLAY | (sample->flags & PCM_4BIT) | (volume & 0xff));
+}
+
+void audio_stop_sample()
+{
+  AUDIO_WRITE(REG_PCM_CTRL, 0);
+}
+
+void audio_load_wavetable(uint32_t voice, const int8_t *samples)
+{
+  uint32_t offset = AUDIO_WAVETABLE_OFFSET + voice * AUDIO_WAVETABLE_SIZE;
+  for (int i = 0; i < AUDIO_WAVETABLE_SIZE; i++) {
+    AUDIO_WRITE_BYTE(offset + i, samples[i]);
+  }
+}
+
+uint32_t audio_get_voice_status(uint32_t voice)
+{
+  return AUDIO_READ(voice * AUDIO_VOICE_STRIDE + REG_STATUS);
+}
+
+void audio_get_samples(int16_t *left, int16_t *right)
+{
+  uint32_t samples = AUDIO_READ(REG_SAMPLE_TAP);
+  *left = (int16_t)(samples & 0xffff);
+  *right = (int16_t)(samples >> 16);
+}
+
+void audio_set_sample_pan(int32_t pan)
+{
+  // byte write to the top of REG_PCM_CTRL, so that the play bit isn't touched
+  AUDIO_WRITE_BYTE(REG_PCM_CTRL * 4 + 3, PCM_PAN(pan) >> 24);
+}
+
+void audio_set_filter(uint32_t cutoff, uint32_t resonance, uint32_t mode)
+{
+  AUDIO_WRITE(REG_FILTER, FILTER_CUTOFF(cutoff) | FILTER_RESONANCE(resonance)
+                         | (mode & (FILTER_LOWPASS | FILTER_BANDPASS | FILTER_HIGHPASS)));
+}
+
+struct audio_shadow_stats_t audio_shadow_stats = { 0, 0, 0, 0 };
+
+static uint32_t shadow[AUDIO_SHADOW_REGS];
+static uint32_t shadow_dirty[(AUDIO_SHADOW_REGS + 31) / 32];
+static uint32_t shadow_known[(AUDIO_SHADOW_REGS + 31) / 32];    /* hardware holds the shadow value */
+static uint32_t shadow_requested = 0;
+
+// the shadow keeps the voice registers, followed by the global registers
+static int32_t shadow_index(uint32_t reg)
+{
+  if (reg < AUDIO_NUM_VOICES * AUDIO_VOICE_STRIDE) {
+    return reg;
+  }
+  if (reg >= REG_GLOBAL_VOLUME && reg < REG_GLOBAL_VOLUME + 8) {
+    return AUDIO_NUM_VOICES * AUDIO_VOICE_STRIDE + (reg - REG_GLOBAL_VOLUME);
+  }
+  return -1;
+}
+
+static void shadow_set(uint32_t reg, uint32_t value, uint32_t always)
+{
+  int32_t index = shadow_index(reg);
+  if (index < 0) {
+    AUDIO_WRITE(reg, value);
+    return;
+  }
+  shadow_requested++;
+  uint32_t bit = 1 << (index & 31);
+  uint32_t word = index >> 5;
+  if (always || !(shadow_known[word] & bit) || shadow[index] != value) {
+    shadow[index] = value;
+    shadow_dirty[word] |= bit;
+  }
+}
+
+void audio_shadow_write(uint32_t reg, uint32_t value)
+{
+  shadow_set(reg, value, 0);
+}
+
+void audio_shadow_trigger(uint32_t reg, uint32_t value)
+{
+  shadow_set(reg, value, 1);
+}
+
+void audio_shadow_flush()
+{
+  uint32_t written = 0;
+  for (uint32_t word = 0; word < sizeof(shadow_dirty) / sizeof(shadow_dirty[0]); word++) {
+    uint32_t dirty = shadow_dirty[word];
+    uint32_t index = word << 5;
+    shadow_dirty[word] = 0;
+    shadow_known[word] |= dirty;
+    // in register order, so eg. a voice's frequency is set before its envelope gate
+    for (; dirty != 0; dirty >>= 1, index++) {
+      if (dirty & 1) {
+        uint32_t reg = (index < AUDIO_NUM_VOICES * AUDIO_VOICE_STRIDE)
+                       ? index : REG_GLOBAL_VOLUME + (index - AUDIO_NUM_VOICES * AUDIO_VOICE_STRIDE);
+        AUDIO_WRITE(reg, shadow[index]);
+        written++;
+      }
+    }
+  }
+  audio_shadow_stats.requested += shadow_requested;
+  audio_shadow_stats.written += written;
+  audio_shadow_stats.last_requested = shadow_requested;
+  audio_shadow_stats.last_written = written;
+  shadow_requested = 0;
+}
+
+void audio_shadow_invalidate()
+{
+  for (uint32_t word = 0; word < sizeof(shadow_known) / sizeof(shadow_known[0]); word++) {
+    shadow_known[word] = 0;
+  }
+}
+
+void audio_sequencer_play(uint32_t track, const struct audio_sequence_t *sequence)
+{
+  volatile uint32_t *regs = reg_audio_sequencer + track * SEQ_TRACK_STRIDE;
+  regs[SEQ_REG_START] = (uint32_t)(uintptr_t)sequence->program;
+  regs[SEQ_REG_LOOP] = sequence->loop ? (uint32_t)(uintptr_t)sequence->loop | SEQ_LOOP_ENABLE : 0;
+  regs[SEQ_REG_CONTROL] = SEQ_PLAY;
+}
+
+void audio_sequencer_stop(uint32_t track)
+{
+  reg_audio_sequencer[track * SEQ_TRACK_STRIDE + SEQ_REG_CONTROL] = 0;
+}
+
+void audio_sequencer_set_tick(uint32_t us)
+{
+  reg_audio_sequencer[SEQ_REG_TICK] = us & 0xffff;
+}
+
+uint32_t audio_sequencer_playing(uint32_t track)
+{
+  return reg_audio_sequencer[track * SEQ_TRACK_STRIDE + SEQ_REG_CONTROL] & SEQ_PLAY;
+}
+
+void audio_cpu_load(const uint8_t *image)
+{
+  reg_audio_cpu[AUDIO_CPU_REG_CONTROL] = 0;
+  reg_audio_cpu[AUDIO_CPU_REG_CODE] = (uint32_t)(uintptr_t)image & 0x00fffffc;
+  reg_audio_cpu[AUDIO_CPU_REG_COMMAND] = 0;
+  reg_audio_cpu[AUDIO_CPU_REG_CONTROL] = AUDIO_CPU_RUN;
+}
+
+void audio_cpu_command(uint32_t command, uint32_t arg)
+{
+  while (reg_audio_cpu[AUDIO_CPU_REG_COMMAND] != 0) {
+  }
+  reg_audio_cpu[AUDIO_CPU_REG_COMMAND] = AUDIO_CPU_COMMAND(command, arg);
+}
+
+void audio_cpu_play(uint32_t song)
+{
+  audio_cpu_command(AUDIO_CPU_CMD_PLAY, song);
+}
+
+void audio_cpu_stop()
+{
+  audio_cpu_command(AUDIO_CPU_CMD_STOP, 0);
+}
+
+void audio_cpu_trigger_effect(uint32_t bar_num)
+{
+  audio_cpu_command(AUDIO_CPU_CMD_TRIGGER_EFFECT, bar_num);
+}
+
+uint32_t audio_cpu_status()
+{
+  return reg_audio_cpu[AUDIO_CPU_REG_STATUS];
 }
@@ -9,21 +9,246 @@
 #define FREQ_HZ_TO_DIVIDER(H) ((uint32_t)(H * 16777216 / 1000000))
 #define FREQ_DIVIDER_TO_HZ(D) ((uint32_t)(D * 1000000 / 16777216))
 
+// must match the NUM_VOICES parameter of the audio peripheral
+#define AUDIO_NUM_VOICES 8
+
+// voice registers (word offsets from voice*AUDIO_VOICE_STRIDE)
+#define AUDIO_VOICE_STRIDE 8
+
 #define REG_FREQ        0
 #define REG_PULSEWIDTH  1
 #define REG_WAVESELECT  2
 #define REG_VOLUME      3
+#define REG_ENVELOPE    4
+#define REG_LFO         5
+#define REG_MIX         6
+#define REG_STATUS      7   /* read only */
 
-#define REG_GLOBAL_VOLUME 16
+// global registers (word offsets from reg_audio)
+#define REG_GLOBAL_VOLUME 0x80
+#define REG_PCM_START     0x81
+#define REG_PCM_LENGTH    0x82
+#define REG_PCM_LOOP      0x83
+#define REG_PCM_RATE      0x84
+#define REG_PCM_CTRL      0x85
+#define REG_FILTER        0x86
+#define REG_SAMPLE_TAP    0x87  /* read only */
 
+#define WAVE_WAVETABLE 16
 #define WAVE_NOISE    8
 #define WAVE_SQUARE   4
 #define WAVE_SAWTOOTH 2
 #define WAVE_TRIANGLE 1
 #define WAVE_NONE     0
 
+// REG_WAVESELECT modulation bits (source = previous voice)
+#define WAVE_RINGMOD  0x01000000
+#define WAVE_SYNC     0x02000000
+
+// REG_ENVELOPE fields
+#define ENV_ATTACK(A)   ((A) & 0x0f)
+#define ENV_DECAY(D)    (((D) & 0x0f) << 4)
+#define ENV_SUSTAIN(S)  (((S) & 0x0f) << 8)
+#define ENV_RELEASE(R)  (((R) & 0x0f) << 12)
+#define ENV_ENABLE      0x00010000
+#define ENV_GATE        0x00020000
+
+// REG_LFO fields (LFO frequency = speed * 0.06Hz)
+#define LFO_VIBRATO_DEPTH(D)  ((D) & 0xff)
+#define LFO_VIBRATO_SPEED(S)  (((S) & 0xff) << 8)
+#define LFO_PWM_DEPTH(D)      (((D) & 0xff) << 16)
+#define LFO_PWM_SPEED(S)      (((uint32_t)(S) & 0xff) << 24)
+
+// REG_PCM_LOOP / REG_PCM_CTRL fields
+#define PCM_LOOP_ENABLE 0x80000000
+#define PCM_4BIT        0x00000100
+#define PCM_PLAY        0x00010000
+#define PCM_FILTER      0x00000200
+#define PCM_PAN(P)      (((uint32_t)(P) & 0x1f) << 24)
+
+// REG_STATUS fields
+#define STATUS_ENV_LEVEL(S)   ((S) & 0xff)
+#define STATUS_ENV_STATE(S)   (((S) >> 8) & 3)
+#define STATUS_GATE           0x00008000
+#define STATUS_PHASE(S)       ((S) >> 16)
+
+#define ENV_STATE_ATTACK  0
+#define ENV_STATE_DECAY   1
+#define ENV_STATE_SUSTAIN 2
+#define ENV_STATE_RELEASE 3
+
+// REG_MIX fields
+#define MIX_FILTER      0x00000001
+#define MIX_PAN(P)      (((uint32_t)(P) & 0x1f) << 8)
+
+// pan positions, for MIX_PAN/PCM_PAN (-8..8)
+#define PAN_LEFT    (-8)
+#define PAN_CENTRE  0
+#define PAN_RIGHT   8
+
+// REG_FILTER fields (cutoff frequency = cutoff * 39Hz)
+#define FILTER_CUTOFF(C)    ((C) & 0xff)
+#define FILTER_RESONANCE(R) (((R) & 0x0f) << 8)
+#define FILTER_LOWPASS      0x00010000
+#define FILTER_BANDPASS     0x00020000
+#define FILTER_HIGHPASS     0x00040000
+
+// PCM sample rate (Hz) to REG_PCM_RATE value (samples per microsecond * 65536)
+#define PCM_HZ_TO_RATE(H) ((uint32_t)(H) * 8192 / 125000)
+
 #define reg_audio ((volatile uint32_t*)0x04000000)
 
+// the audio functions access the registers through these, so that host builds
+// (-DAUDIO_HOST, see tools/songrender) can run against a model of the peripheral.
+// R is a register (word) number, A a byte offset into the peripheral.
+#ifdef AUDIO_HOST
+void audio_host_write(uint32_t offset, uint32_t value, uint32_t bytes);
+uint32_t audio_host_read(uint32_t offset);
+#define AUDIO_WRITE(R, V)       audio_host_write((R) << 2, (V), 4)
+#define AUDIO_WRITE_BYTE(A, V)  audio_host_write((A), (uint8_t)(V), 1)
+#define AUDIO_READ(R)           audio_host_read((R) << 2)
+#else
+#define AUDIO_WRITE(R, V)       (reg_audio[R] = (V))
+#define AUDIO_WRITE_BYTE(A, V)  (((volatile uint8_t*)reg_audio)[A] = (V))
+#define AUDIO_READ(R)           (reg_audio[R])
+#endif
+
+// per-voice wavetables (signed 8 bit samples; byte writes only)
+#define AUDIO_WAVETABLE_SIZE 32
+#define reg_audio_wavetable ((volatile int8_t*)0x04000400)
+#define AUDIO_WAVETABLE_OFFSET 0x400    /* (from reg_audio, in bytes) */
+
+// sequencer registers (SEQ_REG_* + track*SEQ_TRACK_STRIDE, and SEQ_REG_TICK)
+#define AUDIO_SEQUENCER_TRACKS 2
+#define SEQ_TRACK_STRIDE 4
+#define SEQ_REG_CONTROL 0
+#define SEQ_REG_START   1
+#define SEQ_REG_LOOP    2
+#define SEQ_REG_PC      3
+#define SEQ_REG_TICK    8
+#define SEQ_PLAY        0x00000001
+#define SEQ_LOOP_ENABLE 0x80000000
+#define reg_audio_sequencer ((volatile uint32_t*)0x04000600)
+
+// sequencer program commands (32 bit words, read from flash).  A is a byte
+// offset from 0x0400_0000, eg. (3*AUDIO_VOICE_STRIDE + REG_FREQ) << 2, and
+// SEQ_WRITE is followed by the value to write.
+#define SEQ_END                 0x00000000
+#define SEQ_WAIT(T)             (0x10000000 | ((T) & 0xffff))
+#define SEQ_WRITE(A)            (0x20000000 | (((A) & 0x7fc) << 16))
+#define SEQ_WRITE_BYTE(A, V)    (0x30000000 | (((A) & 0x7ff) << 16) | ((V) & 0xff))
+#define SEQ_WRITE_HALF(A, V)    (0x40000000 | (((A) & 0x7fe) << 16) | ((V) & 0xffff))
+
+// audio co-processor mailbox (the same address from both CPUs)
+#define AUDIO_CPU_REG_CONTROL 0     /* main CPU only */
+#define AUDIO_CPU_REG_COMMAND 1     /* zero once the co-processor has taken the command */
+#define AUDIO_CPU_REG_STATUS  2     /* written by the co-processor */
+#define AUDIO_CPU_REG_TIMER   3     /* microseconds, free-running */
+#define AUDIO_CPU_REG_CODE    4     /* flash address of the program (main CPU only, while stopped) */
+#define AUDIO_CPU_RUN 1
+#define reg_audio_cpu ((volatile uint32_t*)0x04100000)
+
+// mailbox commands (8 bit command, 24 bit argument)
+#define AUDIO_CPU_CMD_PLAY           1     /* argument = song number */
+#define AUDIO_CPU_CMD_STOP           2
+#define AUDIO_CPU_CMD_TRIGGER_EFFECT 3     /* argument = bar number */
+#define AUDIO_CPU_COMMAND(C, A) (((uint32_t)(C) << 24) | ((A) & 0x00ffffff))
+
+// co-processor status
+#define AUDIO_CPU_STATUS_LOADED  0x01
+#define AUDIO_CPU_STATUS_PLAYING 0x02
+
+// a shadow of the voice and global registers in RAM.  audio_shadow_write
+// only records the value, and audio_shadow_flush writes the registers whose
+// values changed since they were last flushed.  The first write to each
+// register always goes through (as does anything after audio_shadow_invalidate,
+// eg. after writing the registers directly).
+#define AUDIO_SHADOW_REGS (AUDIO_NUM_VOICES * AUDIO_VOICE_STRIDE + 8)
+
+struct audio_shadow_stats_t {
+  uint32_t requested;       /* writes requested, in total */
+  uint32_t written;         /* registers actually written, in total */
+  uint32_t last_requested;  /* ... and since the flush before the last one */
+  uint32_t last_written;
+};
+
+extern struct audio_shadow_stats_t audio_shadow_stats;
+
+// a PCM sample in flash, for the sample playback voice
+// (data, length and loop_start must all be word aligned)
+struct audio_sample_t {
+  const void *data;
+  uint32_t length;        /* in bytes */
+  uint32_t loop_start;    /* in bytes from the start of data */
+  uint32_t flags;         /* PCM_4BIT, PCM_LOOP_ENABLE */
+  uint32_t rate;          /* PCM_HZ_TO_RATE(sample rate) */
+};
+
+// a program for the sequencer, in flash (see tools/songseq)
+struct audio_sequence_t {
+  const uint32_t *program;
+  const uint32_t *loop;   /* where to carry on after SEQ_END (NULL to stop there) */
+};
+
 void audio_set_global_volume(uint32_t volume);
 
+// start playing a sample on the PCM voice (replacing any sample already playing)
+void audio_play_sample(const struct audio_sample_t *sample, uint32_t volume);
+
+void audio_stop_sample();
+
+// load a voice's wavetable (AUDIO_WAVETABLE_SIZE signed samples), played with WAVE_WAVETABLE
+void audio_load_wavetable(uint32_t voice, const int8_t *samples);
+
+// read a voice's status (see STATUS_* for the fields)
+uint32_t audio_get_voice_status(uint32_t voice);
+
+// read the samples currently being output (signed 14 bit)
+void audio_get_samples(int16_t *left, int16_t *right);
+
+// set the pan position (PAN_LEFT..PAN_RIGHT) of the PCM voice, without restarting it
+void audio_set_sample_pan(int32_t pan);
+
+// set up the state-variable filter (mode = FILTER_LOWPASS | FILTER_BANDPASS | FILTER_HIGHPASS)
+void audio_set_filter(uint32_t cutoff, uint32_t resonance, uint32_t mode);
+
+// start playing a sequence on a sequencer track (0 or 1), replacing whatever it was playing
+void audio_sequencer_play(uint32_t track, const struct audio_sequence_t *sequence);
+
+void audio_sequencer_stop(uint32_t track);
+
+// set the length of a SEQ_WAIT tick, in microseconds (20000 by default)
+void audio_sequencer_set_tick(uint32_t us);
+
+// non-zero while a sequencer track is playing
+uint32_t audio_sequencer_playing(uint32_t track);
+
+// write a register's shadow (reg = voice*AUDIO_VOICE_STRIDE + REG_*, or a global REG_*)
+void audio_shadow_write(uint32_t reg, uint32_t value);
+
+// write a register's shadow, and flush it even if the value hasn't changed
+// (for writes with side effects, like setting ENV_GATE)
+void audio_shadow_trigger(uint32_t reg, uint32_t value);
+
+// write the changed registers to the hardware
+void audio_shadow_flush();
+
+// forget what the hardware registers hold, so each register is flushed on its next write
+void audio_shadow_invalidate();
+
+// start the audio co-processor on a program (see firmware/audio_cpu), which it
+// runs straight out of flash, so the image must be word aligned, and stay put
+void audio_cpu_load(const uint8_t *image);
+
+// post a command to the audio co-processor (waits for it to take the last one)
+void audio_cpu_command(uint32_t command, uint32_t arg);
+
+// play one of the co-processor's songs from the start, stop it, or trigger a sound effect
+void audio_cpu_play(uint32_t song);
+void audio_cpu_stop();
+void audio_cpu_trigger_effect(uint32_t bar_num);
+
+// read the co-processor's status (see AUDIO_CPU_STATUS_*)
+uint32_t audio_cpu_status();
+
 #endif
@@ -3,21 +3,39 @@
 #include <songplayer/songplayer.h>
 #include <uart/uart.h>
 
-const struct song_t *player_song = NULL;
+const struct packed_song_t *player_song = NULL;
 struct globalctrl_t globalctrl = {
   .song_row = -1,
   .song_pos = 0,
   .ticks_per_div = 6,
   .tick_div_count = 0,
-  .sound_fx_row = 16,
-  .sound_fx_bar = 0,
+  .duck = 0,
+  .filter_cutoff = 0xff,
+  .filter_resonance = 0,
+  .filter_mode = FILTER_LOWPASS,
   .active = 0
 };
-struct channelctrl_t channelctrl[4] = {
-  {.note.raw = 0, .note_on_time = 0 },
-  {.note.raw = 0, .note_on_time = 0 },
-  {.note.raw = 0, .note_on_time = 0 }
+struct channelctrl_t channelctrl[SONGPLAYER_NUM_CHANNELS];
+
+// sound effects :: slot n always plays on sfx_slot_channel[n]
+struct sfx_slot_t sfx_slots[SONGPLAYER_SFX_SLOTS];
+static const int8_t sfx_slot_channel[SONGPLAYER_SFX_SLOTS] = {
+  SONGPLAYER_SFX_CHANNEL, SONGPLAYER_MUSIC_CHANNELS-1, SONGPLAYER_MUSIC_CHANNELS-2
 };
+static int8_t channel_sfx_slot[SONGPLAYER_NUM_CHANNELS];    /* -1 = playing music */
+
+// effects triggered since the last tick (written outside the tick, read by it;
+// SONGPLAYER_SFX_QUEUE must be a power of 2)
+static struct songplayer_sfx_t sfx_queue[SONGPLAYER_SFX_QUEUE];
+static volatile uint32_t sfx_queue_head = 0;
+static volatile uint32_t sfx_queue_tail = 0;
+
+static const struct songplayer_sfx_t *sfx_table = NULL;
+static uint32_t sfx_table_size = 0;
+
+void set_channel_instrument(int chan, int instrument_num);
+void update_channel_mix(int chan);
+void update_channel_volume(int chan);
 
 
 const uint32_t note_to_freq[] = {
@@ -37,20 +55,53 @@ const uint32_t note_to_freq[] = {
 };
 
 
-void songplayer_init(const struct song_t* song) {
+void update_filter() {
+  audio_shadow_write(REG_FILTER, FILTER_CUTOFF(globalctrl.filter_cutoff) | FILTER_RESONANCE(globalctrl.filter_resonance)
+                                 | globalctrl.filter_mode);
+}
+
+void songplayer_init(const struct packed_song_t* song) {
   // reset song player to initial position
   globalctrl.song_pos = 0;
   globalctrl.song_row = -1;
   globalctrl.next_pos_override = -1;
+  globalctrl.next_row_override = 0;
   globalctrl.ticks_per_div = song->ticks_per_div;
 
   globalctrl.tick_div_count = globalctrl.ticks_per_div;
   globalctrl.active = 1;
   player_song = song;
-  for (int chan = 0; chan < 3; chan++) {
+  for (int chan = 0; chan < SONGPLAYER_MUSIC_CHANNELS; chan++) {
     channelctrl[chan].note.raw = 0;
     channelctrl[chan].note_on_time = 0;
+    channelctrl[chan].gate_time = 0;
+    channelctrl[chan].mix = 0;
+    channelctrl[chan].pan = PAN_CENTRE;
+    channelctrl[chan].bar_data = NULL;
+    channelctrl[chan].skip_rows = 0;
+    channelctrl[chan].instrument.sample = NULL;
+    channelctrl[chan].instrument.envelope = 0;
+    channelctrl[chan].instrument.default_volume = 0;
+    channelctrl[chan].instrument.lfo = 0;
+    channelctrl[chan].lfo = 0;
+    channelctrl[chan].pitch = 0;
+    channelctrl[chan].porta_target = 0;
+    channelctrl[chan].porta_speed = 0;
+    channelctrl[chan].arpeggio = 0;
+    audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_MIX, 0);
   }
+  for (int chan = 0; chan < SONGPLAYER_NUM_CHANNELS; chan++) {
+    channel_sfx_slot[chan] = -1;
+  }
+  for (int slot = 0; slot < SONGPLAYER_SFX_SLOTS; slot++) {
+    sfx_slots[slot].active = 0;
+  }
+  globalctrl.duck = 0;
+  globalctrl.filter_cutoff = 0xff;
+  globalctrl.filter_resonance = 0;
+  globalctrl.filter_mode = FILTER_LOWPASS;
+  update_filter();
+  audio_shadow_flush();
 }
 
 void songplayer_stop() {
@@ -61,12 +112,75 @@ void songplayer_start(int pos) {
   globalctrl.song_pos = pos;
   globalctrl.song_row = -1;
   globalctrl.next_pos_override = -1;
+  globalctrl.next_row_override = 0;
   globalctrl.active = 1;
 }
 
+static void queue_sfx(struct songplayer_sfx_t sfx) {
+  uint32_t head = sfx_queue_head;
+  uint32_t next = (head + 1) & (SONGPLAYER_SFX_QUEUE - 1);
+  if (next == sfx_queue_tail) {
+    return;   // full
+  }
+  sfx_queue[head] = sfx;
+  sfx_queue_head = next;
+}
+
+void songplayer_set_sfx_table(const struct songplayer_sfx_t *table, uint32_t count) {
+  sfx_table = table;
+  sfx_table_size = count;
+}
+
+void songplayer_play_sfx(uint32_t sfx) {
+  if (sfx < sfx_table_size) {
+    queue_sfx(sfx_table[sfx]);
+  }
+}
+
 void songplayer_trigger_effect(uint32_t bar_num) {
-  globalctrl.sound_fx_bar = bar_num;
-  globalctrl.sound_fx_row = 0;
+  struct songplayer_sfx_t sfx = { .bar = bar_num, .priority = 0, .duck = 0 };
+  if (bar_num < 256) {
+    queue_sfx(sfx);
+  }
+}
+
+// start reading a bar of the (packed) song
+static const uint8_t *bar_start(int bar_num) {
+  if (bar_num >= player_song->num_bars) {
+    static const uint8_t empty_bar = SONG_END_OF_BAR;
+    return &empty_bar;
+  }
+  return player_song->bar_data + player_song->bar_offsets[bar_num];
+}
+
+// decode the next row of a packed bar, advancing through the bar's data
+static struct songnote_expanded_t next_row(const uint8_t **data, int32_t *skip_rows) {
+  union songnote_t row = { .raw = 0 };
+
+  if (*skip_rows > 0) {
+    (*skip_rows)--;
+    return row.note;
+  }
+
+  const uint8_t *p = *data;
+  uint8_t flags = *p;
+  if (flags == SONG_END_OF_BAR) {
+    return row.note;
+  }
+  p++;
+  if (flags & SONG_ROW_SKIP) {
+    *skip_rows = (flags & ~SONG_ROW_SKIP) - 1;
+  } else {
+    if (flags & SONG_ROW_INSTRUMENT) row.note.instrument = *p++;
+    if (flags & SONG_ROW_NOTE) row.note.new_note = *p++;
+    if (flags & SONG_ROW_VOLUME) row.note.volume = *p++;
+    if (flags & SONG_ROW_EFFECT) {
+      row.note.effect = *p++;
+      row.note.effect_parameter = *p++;
+    }
+  }
+  *data = p;
+  return row.note;
 }
 
 
@@ -75,108 +189,460 @@ void handle_percussion_div(int chan, int instrument) {
   switch(instrument) {
     case 1: // kick drum
       // kick drums have 1/50th sec noise followed by fast ramp down 50% pulse
-      reg_audio[chan*4+REG_FREQ]=note_to_freq[90];
-      reg_audio[chan*4+REG_WAVESELECT]=0x00080000;  /* enable, noise, fast attack/decay, full sustain volume */
+      audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_FREQ, note_to_freq[90]);
+      audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_WAVESELECT, 0x00080000);  /* enable, noise, fast attack/decay, full sustain volume */
       break;
     case 2: // hi-hat (closed)
-      reg_audio[chan*4+REG_FREQ]=note_to_freq[100];
-      reg_audio[chan*4+REG_WAVESELECT]=0x00080000;
+      audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_FREQ, note_to_freq[100]);
+      audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_WAVESELECT, 0x00080000);
       break;
     case 3: // hi-hat (open)
-      reg_audio[chan*4+REG_FREQ]=note_to_freq[100];
-      reg_audio[chan*4+REG_WAVESELECT]=0x00080000;  /* same as kick drum; noise enabled */
+      audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_FREQ, note_to_freq[100]);
+      audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_WAVESELECT, 0x00080000);  /* same as kick drum; noise enabled */
       break;
     case 4: // snare
-      reg_audio[chan*4+REG_FREQ]=note_to_freq[50];
-      reg_audio[chan*4+REG_WAVESELECT]=0x00090000;  /* combo triangle + noise (?!?!?) */
+      audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_FREQ, note_to_freq[50]);
+      audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_WAVESELECT, 0x00090000);  /* combo triangle + noise (?!?!?) */
       break;
     default:
       break;
   }
 }
 
-void handle_effect_div(int chan, struct songnote_expanded_t *incoming_note) {
+// music channels are ducked while sound effects play
+void update_channel_volume(int chan) {
+  uint32_t volume = (uint8_t)channelctrl[chan].volume;
+  if (chan < SONGPLAYER_MUSIC_CHANNELS && channel_sfx_slot[chan] < 0) {
+    volume >>= globalctrl.duck;
+  }
+  audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_VOLUME, volume);
+}
+
+void update_channel_mix(int chan) {
+  audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_MIX, channelctrl[chan].mix | MIX_PAN(channelctrl[chan].pan));
+  if (channelctrl[chan].instrument.sample) {
+    audio_set_sample_pan(channelctrl[chan].pan);
+  }
+}
+
+// filter effects:
+//  9xx - set filter cutoff to xx
+//  E0x - route channel through the filter (x=1) or not (x=0)
+//  E1x - sweep filter cutoff up by x every tick
+//  E2x - sweep filter cutoff down by x every tick
+//  E3x - set filter resonance to x
+//  E4x - set filter mode (x = 1 lowpass, 2 bandpass, 4 highpass, or a combination)
+void handle_filter_effect(int chan, int effect, int param) {
+  int amount = param & 0x0f;
+  if (effect == 0x09) {
+    globalctrl.filter_cutoff = param;
+  } else {
+    switch (param >> 4) {
+      case 0x0:
+        channelctrl[chan].mix = amount ? MIX_FILTER : 0;
+        update_channel_mix(chan);
+        return;
+      case 0x1:
+        globalctrl.filter_cutoff += amount;
+        if (globalctrl.filter_cutoff > 0xff)
+          globalctrl.filter_cutoff = 0xff;
+        break;
+      case 0x2:
+        globalctrl.filter_cutoff -= amount;
+        if (globalctrl.filter_cutoff < 0)
+          globalctrl.filter_cutoff = 0;
+        break;
+      case 0x3:
+        globalctrl.filter_resonance = amount;
+        break;
+      case 0x4:
+        globalctrl.filter_mode = (amount & 7) << 16;
+        break;
+      default:
+        return;
+    }
+  }
+  update_filter();
+}
+
+// frequency of a pitch in 1/16ths of a semitone, between the notes of
+// note_to_freq (for portamento; no multiplier, so the fraction is added bit by bit)
+static uint32_t pitch_to_freq(int32_t pitch) {
+  int note = pitch >> 4;
+  if (note >= 127) {
+    return note_to_freq[127];
+  }
+  uint32_t freq = note_to_freq[note];
+  uint32_t step = note_to_freq[note+1] - freq;
+  uint32_t fraction = 0;
+  if (pitch & 8) fraction += step << 3;
+  if (pitch & 4) fraction += step << 2;
+  if (pitch & 2) fraction += step << 1;
+  if (pitch & 1) fraction += step;
+  return freq + (fraction >> 4);
+}
+
+static void volume_slide(int chan, int param) {
+  int32_t volume = (uint8_t)channelctrl[chan].volume;
+  volume += (param >> 4) - (param & 0x0f);
+  if (volume < 0) volume = 0;
+  if (volume > 0xff) volume = 0xff;
+  channelctrl[chan].volume = volume;
+  update_channel_volume(chan);
+}
+
+// effects, on the row's first tick (div) and the ticks after it (tick).  The
+// LFO effects are programmed into the voice once, and run in hardware.
+#define LFO_VIBRATO_MASK (LFO_VIBRATO_DEPTH(0xff) | LFO_VIBRATO_SPEED(0xff))
+#define LFO_PWM_MASK     (LFO_PWM_DEPTH(0xff) | LFO_PWM_SPEED(0xff))
+
+// 0xy - arpeggio: note, note+x, note+y, one each tick
+static void effect_div_arpeggio(int chan, struct songnote_expanded_t *incoming_note) {
+  channelctrl[chan].arpeggio = 0;
+}
+
+static void effect_tick_arpeggio(int chan) {
+  struct channelctrl_t *ctrl = &channelctrl[chan];
+  int param = ctrl->note.note.effect_parameter;
+  int offset = 0;
+  if (param == 0) {
+    return;
+  }
+  ctrl->arpeggio++;
+  if (ctrl->arpeggio == 3) {
+    ctrl->arpeggio = 0;
+  }
+  if (ctrl->arpeggio == 1) {
+    offset = param >> 4;
+  } else if (ctrl->arpeggio == 2) {
+    offset = param & 0x0f;
+  }
+  int new_note = ctrl->note.note.new_note + offset;
+  new_note = (new_note > 127) ? 127 : new_note;          // (rather than wrapping round)
+  audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_FREQ, note_to_freq[new_note]);
+}
+
+// 1xx - slide up xx semitones every tick
+static void effect_tick_slide_up(int chan) {
   struct songnote_expanded_t *note = &channelctrl[chan].note.note;
-  switch(note->effect) {
-    case 0x01: /* slide up */
-        note->new_note = note->new_note + note->effect_parameter;
-        if (!incoming_note->new_note) {
-        reg_audio[chan*4+REG_FREQ] = note_to_freq[note->new_note];
-      }
-      break;
-    case 0x02: /* slide down */
-      if (!incoming_note->new_note) {
-        note->new_note = note->new_note - note->effect_parameter;
-        reg_audio[chan*4+REG_FREQ] = note_to_freq[note->new_note];
+  int new_note = note->new_note + note->effect_parameter;
+  note->new_note = (new_note > 127) ? 127 : new_note;    // (rather than wrapping round)
+  audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_FREQ, note_to_freq[note->new_note]);
+}
+
+static void effect_div_slide_up(int chan, struct songnote_expanded_t *incoming_note) {
+  if (!incoming_note->new_note) {
+    effect_tick_slide_up(chan);
+  }
+}
+
+// 2xx - slide down xx semitones every tick
+static void effect_tick_slide_down(int chan) {
+  struct songnote_expanded_t *note = &channelctrl[chan].note.note;
+  int new_note = note->new_note - note->effect_parameter;
+  note->new_note = (new_note < 1) ? 1 : new_note;        // (0 would silence it)
+  audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_FREQ, note_to_freq[note->new_note]);
+}
+
+static void effect_div_slide_down(int chan, struct songnote_expanded_t *incoming_note) {
+  if (!incoming_note->new_note) {
+    effect_tick_slide_down(chan);
+  }
+}
+
+// 3xx - portamento to the row's note (which isn't played), xx/16 semitones
+// every tick (300 carries on at the last speed)
+static void effect_div_portamento(int chan, struct songnote_expanded_t *incoming_note) {
+  struct channelctrl_t *ctrl = &channelctrl[chan];
+  if (ctrl->note.note.effect == 0x3 && ctrl->note.note.effect_parameter != 0) {
+    ctrl->porta_speed = ctrl->note.note.effect_parameter;
+  }
+  if ((ctrl->pitch >> 4) != ctrl->note.note.new_note) {
+    ctrl->pitch = ctrl->note.note.new_note << 4;    // slid or arpeggiated since the note started
+  }
+}
+
+static void effect_tick_portamento(int chan) {
+  struct channelctrl_t *ctrl = &channelctrl[chan];
+  if (ctrl->pitch < ctrl->porta_target) {
+    ctrl->pitch += ctrl->porta_speed;
+    if (ctrl->pitch > ctrl->porta_target) ctrl->pitch = ctrl->porta_target;
+  } else if (ctrl->pitch > ctrl->porta_target) {
+    ctrl->pitch -= ctrl->porta_speed;
+    if (ctrl->pitch < ctrl->porta_target) ctrl->pitch = ctrl->porta_target;
+  }
+  ctrl->note.note.new_note = ctrl->pitch >> 4;
+  audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_FREQ, pitch_to_freq(ctrl->pitch));
+}
+
+// 4xy - vibrato at speed x, depth y (the hardware LFO; 0 keeps the last value)
+static void effect_div_vibrato(int chan, struct songnote_expanded_t *incoming_note) {
+  struct channelctrl_t *ctrl = &channelctrl[chan];
+  int param = ctrl->note.note.effect_parameter;
+  if (param >> 4) {
+    ctrl->lfo = (ctrl->lfo & ~LFO_VIBRATO_SPEED(0xff)) | LFO_VIBRATO_SPEED((param >> 4) << 4);
+  }
+  if (param & 0x0f) {
+    ctrl->lfo = (ctrl->lfo & ~LFO_VIBRATO_DEPTH(0xff)) | LFO_VIBRATO_DEPTH((param & 0x0f) << 4);
+  }
+}
+
+// 5xy - carry on the portamento, and slide the volume (as Axy)
+static void effect_tick_portamento_volume(int chan) {
+  effect_tick_portamento(chan);
+  volume_slide(chan, channelctrl[chan].note.note.effect_parameter);
+}
+
+// 6xy - carry on the vibrato, and slide the volume (as Axy)
+static void effect_tick_volume_slide(int chan) {
+  volume_slide(chan, channelctrl[chan].note.note.effect_parameter);
+}
+
+// 7xy - pulse width modulation at speed x, depth y (the hardware LFO; 0 keeps the last value)
+static void effect_div_pwm(int chan, struct songnote_expanded_t *incoming_note) {
+  struct channelctrl_t *ctrl = &channelctrl[chan];
+  int param = ctrl->note.note.effect_parameter;
+  if (param >> 4) {
+    ctrl->lfo = (ctrl->lfo & ~LFO_PWM_SPEED(0xff)) | LFO_PWM_SPEED((param >> 4) << 4);
+  }
+  if (param & 0x0f) {
+    ctrl->lfo = (ctrl->lfo & ~LFO_PWM_DEPTH(0xff)) | LFO_PWM_DEPTH((param & 0x0f) << 4);
+  }
+}
+
+// 8xx - set pan position (00 = left, 80 = centre, ff = right)
+static void effect_div_pan(int chan, struct songnote_expanded_t *incoming_note) {
+  channelctrl[chan].pan = ((channelctrl[chan].note.note.effect_parameter * 17) >> 8) + PAN_LEFT;
+  update_channel_mix(chan);
+}
+
+// 9xx - set filter cutoff
+static void effect_div_filter(int chan, struct songnote_expanded_t *incoming_note) {
+  handle_filter_effect(chan, 0x09, channelctrl[chan].note.note.effect_parameter);
+}
+
+// Bxx - position jump, after this row
+static void song_position_jump(int param) {
+  if (param < player_song->song_length) {
+    globalctrl.next_pos_override = param;
+  }
+}
+
+static void effect_div_position_jump(int chan, struct songnote_expanded_t *incoming_note) {
+  song_position_jump(channelctrl[chan].note.note.effect_parameter);
+}
+
+// Cxx - set volume
+static void effect_div_volume(int chan, struct songnote_expanded_t *incoming_note) {
+  channelctrl[chan].volume = channelctrl[chan].note.note.effect_parameter;
+  update_channel_volume(chan);
+}
+
+static void effect_tick_volume(int chan) {
+  effect_div_volume(chan, NULL);
+}
+
+// Dxx - pattern break: carry on from row xx of the next position, after this row
+static void song_pattern_break(int32_t row) {
+  if (globalctrl.next_pos_override == -1) {
+    globalctrl.next_pos_override = globalctrl.song_pos + 1;
+    if (globalctrl.next_pos_override >= player_song->song_length) {
+      globalctrl.next_pos_override = 0;
+    }
+  }
+  globalctrl.next_row_override = (row < player_song->rows_per_bar) ? row : 0;
+}
+
+static void effect_div_pattern_break(int chan, struct songnote_expanded_t *incoming_note) {
+  song_pattern_break(channelctrl[chan].note.note.effect_parameter);
+}
+
+// Exy - extended: filter routing/sweep/resonance/mode (see handle_filter_effect),
+//  ECx - key off (close the gate) after x ticks
+static void effect_div_extended(int chan, struct songnote_expanded_t *incoming_note) {
+  int param = channelctrl[chan].note.note.effect_parameter;
+  switch (param >> 4) {
+    case 0x1:
+    case 0x2:
+      break;    // sweeps are every tick
+    case 0xc:
+      channelctrl[chan].gate_time = param & 0x0f;
+      if (channelctrl[chan].gate_time == 0) {
+        audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_ENVELOPE, channelctrl[chan].envelope);  /* gate off; release */
       }
       break;
-    case 0x0c: /* set volume */
-      channelctrl[chan].volume = channelctrl[chan].note.note.effect_parameter;
-      reg_audio[chan*4+REG_VOLUME] = channelctrl[chan].volume;
+    default:
+      handle_filter_effect(chan, 0x0e, param);
       break;
-    case 0x0b: /* position jump - jump to new pattern */
-      globalctrl.next_pos_override = note->effect_parameter;
   }
 }
 
+static void effect_tick_extended(int chan) {
+  int param = channelctrl[chan].note.note.effect_parameter;
+  if ((param >> 4) == 0x1 || (param >> 4) == 0x2) {
+    handle_filter_effect(chan, 0x0e, param);
+  }
+}
+
+// Fxx - set speed (ticks per row; the tick rate is fixed by whoever calls songplayer_tick)
+static void song_speed(int param) {
+  if (param > 0 && param < 32) {
+    globalctrl.ticks_per_div = param;
+  }
+}
+
+static void effect_div_speed(int chan, struct songnote_expanded_t *incoming_note) {
+  song_speed(channelctrl[chan].note.note.effect_parameter);
+}
+
+// Bxx, Dxx and Fxx change the song, rather than the channel they're on
+static int is_song_effect(int effect) {
+  return effect == 0xb || effect == 0xd || effect == 0xf;
+}
+
+// the song effects of a row whose channel a sound effect has taken, which
+// the song still needs (the channel's own effects wait for the channel)
+static void handle_song_effect(struct songnote_expanded_t note) {
+  switch (note.effect) {
+    case 0xb: song_position_jump(note.effect_parameter); break;
+    case 0xd: song_pattern_break(note.effect_parameter); break;
+    case 0xf: song_speed(note.effect_parameter); break;
+  }
+}
+
+static void (*const effect_div_handlers[16])(int chan, struct songnote_expanded_t *incoming_note) = {
+  effect_div_arpeggio, effect_div_slide_up, effect_div_slide_down, effect_div_portamento,
+  effect_div_vibrato, effect_div_portamento, NULL, effect_div_pwm,
+  effect_div_pan, effect_div_filter, NULL, effect_div_position_jump,
+  effect_div_volume, effect_div_pattern_break, effect_div_extended, effect_div_speed
+};
+
+static void (*const effect_tick_handlers[16])(int chan) = {
+  effect_tick_arpeggio, effect_tick_slide_up, effect_tick_slide_down, effect_tick_portamento,
+  NULL, effect_tick_portamento_volume, effect_tick_volume_slide, NULL,
+  NULL, NULL, effect_tick_volume_slide, NULL,
+  effect_tick_volume, NULL, effect_tick_extended, NULL
+};
+
+void handle_effect_div(int chan, struct songnote_expanded_t *incoming_note) {
+  struct channelctrl_t *ctrl = &channelctrl[chan];
+  int effect = ctrl->note.note.effect;
+
+  // the LFO effects only last as long as the effect does, then it's back to the instrument's
+  if (effect != 0x4 && effect != 0x6) {
+    ctrl->lfo = (ctrl->lfo & ~LFO_VIBRATO_MASK) | (ctrl->instrument.lfo & LFO_VIBRATO_MASK);
+  }
+  if (effect != 0x7) {
+    ctrl->lfo = (ctrl->lfo & ~LFO_PWM_MASK) | (ctrl->instrument.lfo & LFO_PWM_MASK);
+  }
+
+  if (effect_div_handlers[effect]) {
+    effect_div_handlers[effect](chan, incoming_note);
+  }
+  audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_LFO, ctrl->lfo);
+}
+
 void handle_effect_tick(int chan) {
-  struct songnote_expanded_t *note = &channelctrl[chan].note.note;
-  switch(note->effect) {
-    case 0x01: /* slide up */
-      note->new_note = note->new_note + note->effect_parameter;
-      reg_audio[chan*4+REG_FREQ] = note_to_freq[note->new_note];
-      break;
-    case 0x02: /* slide down */
-      note->new_note = note->new_note - note->effect_parameter;
-      reg_audio[chan*4+REG_FREQ] = note_to_freq[note->new_note];
-      break;
-    case 0x0c: /* set volume */
-      channelctrl[chan].volume = channelctrl[chan].note.note.effect_parameter;
-      reg_audio[chan*4+REG_VOLUME] = channelctrl[chan].volume;
-      break;
-    default: break;
+  int effect = channelctrl[chan].note.note.effect;
+  if (effect_tick_handlers[effect]) {
+    effect_tick_handlers[effect](chan);
+  }
+}
+
+// set a channel up to play an instrument, decoding the parts needed for its
+// notes into channelctrl (this is the only place the instrument is read from the song)
+void set_channel_instrument(int chan, int instrument_num) {
+  const struct song_instrument_t *instrument = &player_song->instruments[instrument_num];
+  struct channel_instrument_t *cached = &channelctrl[chan].instrument;
+  channelctrl[chan].note.note.instrument = instrument_num;
+
+  // set channel parameters based on instrument
+  if (instrument_num >= FIRST_USER_INSTRUMENT) {
+    audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_WAVESELECT,
+            (0x08<<24) /* enable voice */
+            +(instrument->waveform_select<<16)
+            +(instrument->ringmod ? WAVE_RINGMOD : 0)
+            +(instrument->sync ? WAVE_SYNC : 0));
+    audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_PULSEWIDTH, instrument->pulsewidth);
+    if (instrument->wavetable) {
+      audio_load_wavetable(chan, instrument->wavetable);
+    }
   }
+
+  // vibrato and pulse width modulation are done by the hardware LFOs
+  cached->lfo = LFO_VIBRATO_DEPTH(instrument->vibrato_depth)
+              | LFO_VIBRATO_SPEED(instrument->vibrato_speed)
+              | LFO_PWM_DEPTH(instrument->pulsewidth_modulation_depth)
+              | LFO_PWM_SPEED(instrument->pulsewidth_modulation_speed);
+  channelctrl[chan].lfo = cached->lfo;
+  audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_LFO, cached->lfo);
+
+  cached->sample = instrument->sample;
+  cached->default_volume = instrument->default_volume;
+  if (instrument->envelope_enable) {
+    cached->envelope = ENV_ATTACK(instrument->attack) | ENV_DECAY(instrument->decay)
+                     | ENV_SUSTAIN(instrument->sustain) | ENV_RELEASE(instrument->release)
+                     | ENV_ENABLE;
+  } else {
+    cached->envelope = 0;
+  }
+
+  channelctrl[chan].pan = instrument->pan;
+  update_channel_mix(chan);
 }
 
 void play_note_on_channel(int chan, struct songnote_expanded_t note) {
+  // portamento slides to the row's note, rather than playing it
+  if ((note.effect == 0x3 || note.effect == 0x5) && note.new_note != 0
+      && channelctrl[chan].note.note.new_note != 0) {
+    channelctrl[chan].porta_target = note.new_note << 4;
+    note.new_note = 0;
+  }
+  // an arpeggio leaves the voice on one of its notes
+  if (channelctrl[chan].note.note.effect == 0x0 && channelctrl[chan].note.note.effect_parameter != 0
+      && note.new_note == 0) {
+    audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_FREQ, note_to_freq[channelctrl[chan].note.note.new_note]);
+  }
+
   channelctrl[chan].note.note.effect = note.effect;
   channelctrl[chan].note.note.effect_parameter = note.effect_parameter;
 
   // "disable" voice if we have a new note
   if (note.new_note != 0) {
     channelctrl[chan].note.note.new_note = note.new_note;
-//            reg_audio[chan*4+REG_VOLUME]=0;
+//            reg_audio[chan*AUDIO_VOICE_STRIDE+REG_VOLUME]=0;
   }
   // switch out instrument waveform parameters for new voice
   if (note.instrument != 0) {
-    channelctrl[chan].note.note.instrument = note.instrument;
-
-    // set channel parameters based on instrument
-    if (note.instrument >= FIRST_USER_INSTRUMENT) {
-      struct song_instrument_t instrument = player_song->instruments[note.instrument];
-      reg_audio[chan*4+REG_WAVESELECT]=
-              (0x08<<24) /* enable voice */
-              +(instrument.waveform_select<<16);
-      reg_audio[chan*4+REG_PULSEWIDTH]=instrument.pulsewidth;
-    }
+    set_channel_instrument(chan, note.instrument);
   }
   // handle new note
   if (note.new_note != 0) {
     channelctrl[chan].note_on_time = 0;
+    channelctrl[chan].pitch = note.new_note << 4;
+    channelctrl[chan].porta_target = channelctrl[chan].pitch;
 
     // set frequency of note
-    reg_audio[chan*4+REG_FREQ] = note_to_freq[note.new_note];
-
-    handle_percussion_div(chan, channelctrl[chan].note.note.instrument);
-
-    struct song_instrument_t instrument = player_song->instruments[note.instrument];
-    if (instrument.envelope_enable) {
-      channelctrl[chan].volume = instrument.envelope->points[0];
+    audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_FREQ, note_to_freq[note.new_note]);
+
+    // (notes without an instrument play the channel's current one)
+    const struct channel_instrument_t *instrument = &channelctrl[chan].instrument;
+    if (instrument->sample) {
+      // sampled instruments play on the PCM voice, leaving this voice silent
+      audio_play_sample(instrument->sample, instrument->default_volume);
+      audio_set_sample_pan(channelctrl[chan].pan);
+      channelctrl[chan].volume = 0;
     } else {
-      channelctrl[chan].volume = instrument.default_volume;
+      handle_percussion_div(chan, channelctrl[chan].note.note.instrument);
+      channelctrl[chan].volume = instrument->default_volume;
     }
-    reg_audio[chan*4+REG_VOLUME] = channelctrl[chan].volume;
+    update_channel_volume(chan);
 
+    // the envelope runs in hardware; all we need to do is open the gate now,
+    // and close it again after the note's gate time (if it has one)
+    channelctrl[chan].envelope = instrument->envelope;
+    channelctrl[chan].gate_time = note.volume;
+    audio_shadow_trigger(chan*AUDIO_VOICE_STRIDE+REG_ENVELOPE, channelctrl[chan].envelope | ENV_GATE);
   }
   // handle effects
   handle_effect_div(chan, &note);
@@ -185,25 +651,206 @@ void play_note_on_channel(int chan, struct songnote_expanded_t note) {
 
 
 
-  void divhandler() {
+  // music is turned down by the most ducking of the sound effects playing
+  static void update_duck() {
+    int32_t duck = 0;
+    for (int slot = 0; slot < SONGPLAYER_SFX_SLOTS; slot++) {
+      int32_t slot_duck = (sfx_slots[slot].sfx.duck > 7) ? 7 : sfx_slots[slot].sfx.duck;
+      if (sfx_slots[slot].active && slot_duck > duck) {
+        duck = slot_duck;
+      }
+    }
+    if (duck != globalctrl.duck) {
+      globalctrl.duck = duck;
+      for (int chan = 0; chan < SONGPLAYER_MUSIC_CHANNELS; chan++) {
+        update_channel_volume(chan);
+      }
+    }
+  }
+
+  static void stop_sfx(int slot) {
+    int chan = sfx_slot_channel[slot];
+    sfx_slots[slot].active = 0;
+    channel_sfx_slot[chan] = -1;
+
+    if (chan < SONGPLAYER_MUSIC_CHANNELS) {
+      // give the voice back to the music as it was, but still reading the current bar;
+      // the music's next note will open the gate again
+      const uint8_t *bar_data = channelctrl[chan].bar_data;
+      int32_t skip_rows = channelctrl[chan].skip_rows;
+      channelctrl[chan] = sfx_slots[slot].music;
+      channelctrl[chan].bar_data = bar_data;
+      channelctrl[chan].skip_rows = skip_rows;
+      channelctrl[chan].gate_time = 0;
+
+      if (channelctrl[chan].note.note.instrument != 0) {
+        set_channel_instrument(chan, channelctrl[chan].note.note.instrument);
+      } else {
+        update_channel_mix(chan);
+      }
+      audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_FREQ, note_to_freq[channelctrl[chan].note.note.new_note]);
+      audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_ENVELOPE, channelctrl[chan].envelope);
+      update_channel_volume(chan);
+    }
+    update_duck();
+  }
+
+  static void start_sfx(struct songplayer_sfx_t sfx) {
+    // a free slot (the sound effect channel's first), or else the lowest priority
+    // effect playing, if this one's priority is at least as high
+    int slot = -1;
+    for (int s = 0; s < SONGPLAYER_SFX_SLOTS && slot < 0; s++) {
+      if (!sfx_slots[s].active) {
+        slot = s;
+      }
+    }
+    if (slot < 0) {
+      for (int s = 0; s < SONGPLAYER_SFX_SLOTS; s++) {
+        if (sfx.priority >= sfx_slots[s].sfx.priority
+            && (slot < 0 || sfx_slots[s].sfx.priority < sfx_slots[slot].sfx.priority)) {
+          slot = s;
+        }
+      }
+      if (slot < 0) {
+        return;
+      }
+    }
+
+    struct sfx_slot_t *s = &sfx_slots[slot];
+    int chan = sfx_slot_channel[slot];
+    if (!s->active && chan < SONGPLAYER_MUSIC_CHANNELS) {
+      s->music = channelctrl[chan];   // steal the music channel
+    }
+    channel_sfx_slot[chan] = slot;
+    s->active = 1;
+    s->sfx = sfx;
+    s->row = 0;
+    s->skip = 0;
+    if (sfx.sound) {
+      // a clean voice for the sound; no notes or effects left from before
+      channelctrl[chan].note.raw = 0;
+      channelctrl[chan].gate_time = 0;
+      channelctrl[chan].instrument.sample = NULL;
+      channelctrl[chan].envelope = sfx.sound->envelope | ENV_ENABLE;
+      channelctrl[chan].volume = sfx.sound->volume;
+      channelctrl[chan].mix = 0;
+      channelctrl[chan].pan = PAN_CENTRE;
+      audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_WAVESELECT, (0x08<<24) /* enable voice */ + (sfx.sound->waveform<<16));
+      audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_LFO, 0);
+      update_channel_mix(chan);
+      update_channel_volume(chan);
+      s->repeats = sfx.sound->repeat;
+    } else {
+      s->data = bar_start(sfx.bar);
+    }
+    update_duck();
+  }
+
+  // start the effects triggered since the last tick (at most SONGPLAYER_SFX_QUEUE)
+  static void start_queued_sfx() {
+    while (sfx_queue_tail != sfx_queue_head) {
+      struct songplayer_sfx_t sfx = sfx_queue[sfx_queue_tail];
+      sfx_queue_tail = (sfx_queue_tail + 1) & (SONGPLAYER_SFX_QUEUE - 1);
+      if (sfx.sound || sfx.bar < player_song->num_bars) {
+        start_sfx(sfx);
+      }
+    }
+  }
+
+  // sounds are generated a tick at a time: (re)start with the gate open,
+  // sweep, close the gate after sound->length ticks, and stop after the tail
+  static void sound_tick(int slot) {
+    struct sfx_slot_t *s = &sfx_slots[slot];
+    const struct songplayer_sound_t *sound = s->sfx.sound;
+    int chan = sfx_slot_channel[slot];
+
+    if (s->row == 0) {
+      s->freq = sound->freq * 16;
+      s->slide = sound->slide * 16;
+      s->pulsewidth = sound->pulsewidth * 16;
+      audio_shadow_trigger(chan*AUDIO_VOICE_STRIDE+REG_ENVELOPE, channelctrl[chan].envelope | ENV_GATE);
+    } else {
+      s->freq += s->slide;
+      s->slide += sound->slide_change * 16;
+      s->pulsewidth += sound->pulsewidth_sweep;
+      if (s->freq < 0) s->freq = 0;
+      if (s->freq > 0xffffff) s->freq = 0xffffff;
+      if (s->pulsewidth < 0) s->pulsewidth = 0;
+      if (s->pulsewidth > 0xfff) s->pulsewidth = 0xfff;
+    }
+    audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_FREQ, s->freq);
+    audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_PULSEWIDTH, s->pulsewidth);
+
+    s->row++;
+    if (s->row == sound->length) {
+      audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_ENVELOPE, channelctrl[chan].envelope);  /* gate off; release */
+      if (s->repeats > 0) {
+        s->repeats--;
+        s->row = 0;
+        return;
+      }
+    }
+    if (s->row >= sound->length + sound->tail) {
+      stop_sfx(slot);
+    }
+  }
+
+  // (jumped = the song position was just changed by an effect)
+  void divhandler(int jumped) {
 
         int song_pattern = player_song->pattern_map[globalctrl.song_pos];
 
         // read in new note data
         if (globalctrl.active) {
-          for (int chan = 0; chan < 3; chan++) {
-            int current_bar_num = player_song->patterns[song_pattern].bar[chan];
-            struct songnote_expanded_t note = player_song->bars[current_bar_num].notes[globalctrl.song_row].note;
+          // (no multiplier; num_channels is small)
+          const uint8_t *pattern = player_song->patterns;
+          for (int i = 0; i < player_song->num_channels; i++) {
+            pattern += song_pattern;
+          }
 
-            play_note_on_channel(chan, note);
+          for (int chan = 0; chan < SONGPLAYER_MUSIC_CHANNELS; chan++) {
+            if (globalctrl.song_row == 0 || jumped) {
+              int current_bar_num = (chan < player_song->num_channels)
+                                    ? pattern[chan]
+                                    : player_song->num_bars;
+              channelctrl[chan].bar_data = bar_start(current_bar_num);
+              channelctrl[chan].skip_rows = 0;
+              for (int row = 0; row < globalctrl.song_row; row++) {   // (after a pattern break)
+                next_row(&channelctrl[chan].bar_data, &channelctrl[chan].skip_rows);
+              }
+            }
+            struct songnote_expanded_t note = next_row(&channelctrl[chan].bar_data, &channelctrl[chan].skip_rows);
+
+            int slot = channel_sfx_slot[chan];
+            if (slot < 0) {
+              play_note_on_channel(chan, note);
+            } else {
+              // a sound effect has this voice; keep up with the music's instrument for when it's done
+              if (note.instrument != 0) {
+                sfx_slots[slot].music.note.note.instrument = note.instrument;
+              }
+              handle_song_effect(note);
+            }
           }
 
         }
-        // deal with "sound fx" channel
-        if (globalctrl.sound_fx_row < 16) {
-          struct songnote_expanded_t note = player_song->bars[globalctrl.sound_fx_bar].notes[globalctrl.sound_fx_row].note;
-          play_note_on_channel(3, note);
-          globalctrl.sound_fx_row++;
+        // play the bar sound effects (each one is a bar long)
+        for (int slot = 0; slot < SONGPLAYER_SFX_SLOTS; slot++) {
+          struct sfx_slot_t *s = &sfx_slots[slot];
+          if (s->active && !s->sfx.sound) {
+            if (s->row >= player_song->rows_per_bar) {
+              stop_sfx(slot);
+            } else {
+              struct songnote_expanded_t note = next_row(&s->data, &s->skip);
+              // (a bar played as a sound effect mustn't move or retime the song)
+              if (is_song_effect(note.effect)) {
+                note.effect = 0;
+                note.effect_parameter = 0;
+              }
+              play_note_on_channel(sfx_slot_channel[slot], note);
+              s->row++;
+            }
+          }
         }
   }
 
@@ -211,32 +858,26 @@ void play_note_on_channel(int chan, struct songnote_expanded_t note) {
   void handle_percussion_tick(int chan, int instrument) {
     switch (instrument) {
       case 1: // kick drum
-        reg_audio[chan*4+REG_PULSEWIDTH]=2048;
+        audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_PULSEWIDTH, 2048);
         int kick_drum_note = 40-(channelctrl[chan].note_on_time << 2);
         if (kick_drum_note <= 27)
           kick_drum_note = 26;
-        reg_audio[chan*4+REG_FREQ]=note_to_freq[kick_drum_note];
-        reg_audio[chan*4+REG_WAVESELECT]=0x08040000;
+        audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_FREQ, note_to_freq[kick_drum_note]);
+        audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_WAVESELECT, 0x08040000);
     }
   }
 
   void tickhandler() {
-    for (int chan = 0; chan < 4; chan++) {
-
-      struct songnote_expanded_t note = channelctrl[chan].note.note;
-      struct song_instrument_t instrument = player_song->instruments[note.instrument];
+    for (int chan = 0; chan < SONGPLAYER_NUM_CHANNELS; chan++) {
 
       channelctrl[chan].note_on_time++;
-      if (instrument.envelope_enable) {
-        int env_point = channelctrl[chan].note_on_time;
-        if (env_point >= instrument.envelope->num_points) {
-          env_point = instrument.envelope->num_points-1;
+      if (channelctrl[chan].gate_time > 0) {
+        channelctrl[chan].gate_time--;
+        if (channelctrl[chan].gate_time == 0) {
+          audio_shadow_write(chan*AUDIO_VOICE_STRIDE+REG_ENVELOPE, channelctrl[chan].envelope);  /* gate off; release */
         }
-        channelctrl[chan].volume = instrument.envelope->points[env_point];
       }
 
-      reg_audio[chan*4+REG_VOLUME] = channelctrl[chan].volume;
-
       handle_percussion_tick(chan, channelctrl[chan].note.note.instrument);
       handle_effect_tick(chan);
   }
@@ -245,6 +886,10 @@ void play_note_on_channel(int chan, struct songnote_expanded_t note) {
 
 // audio interrupt routine -- call @ 50 times per second
 void songplayer_tick() {
+  int jumped = 0;
+
+  start_queued_sfx();
+
   globalctrl.tick_div_count++;
   if (globalctrl.tick_div_count < globalctrl.ticks_per_div) {
     tickhandler();
@@ -260,12 +905,26 @@ void songplayer_tick() {
       }
     }
 
+    // position jump / pattern break on the row just played
     if (globalctrl.next_pos_override != -1) {
-      globalctrl.song_pos = globalctrl.song_pos;
-      globalctrl.song_row = 0;
+      globalctrl.song_pos = globalctrl.next_pos_override;
+      globalctrl.song_row = globalctrl.next_row_override;
+      globalctrl.next_pos_override = -1;
+      globalctrl.next_row_override = 0;
+      jumped = 1;
     }
 
-    divhandler();
+    divhandler(jumped);
 
   }
+
+  // generated sounds play every tick, over whatever the handlers did
+  for (int slot = 0; slot < SONGPLAYER_SFX_SLOTS; slot++) {
+    if (sfx_slots[slot].active && sfx_slots[slot].sfx.sound) {
+      sound_tick(slot);
+    }
+  }
+
+  // only the registers that changed are written to the hardware
+  audio_shadow_flush();
 }
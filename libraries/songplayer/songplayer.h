@@ -3,25 +3,34 @@
 
 #include <stdint.h>
 
-#define FIRST_USER_INSTRUMENT 5  // 1,2,3,4 = percussion
+#include <audio/audio.h>
 
+#define FIRST_USER_INSTRUMENT 5  // 1,2,3,4 = percussion
 
-struct envelope_t {
-  int32_t num_points;
-  uint8_t points[];
-};
+// the last voice is kept for sound effects, the rest play music
+#define SONGPLAYER_NUM_CHANNELS AUDIO_NUM_VOICES
+#define SONGPLAYER_MUSIC_CHANNELS (SONGPLAYER_NUM_CHANNELS-1)
+#define SONGPLAYER_SFX_CHANNEL (SONGPLAYER_NUM_CHANNELS-1)
 
 struct song_instrument_t {
-  int32_t waveform_select :4;
+  uint32_t waveform_select :5;
+  uint32_t ringmod: 1;            /* ring modulate / hard sync with the previous channel */
+  uint32_t sync: 1;
   int32_t pulsewidth : 12;
-  int32_t pulsewidth_modulation_depth : 8;
-  int32_t pulsewidth_modulation_speed : 8;
-  int32_t vibrato_depth : 8;
-  int32_t vibrato_speed : 8;
-  int32_t default_volume: 8;
+  uint32_t pulsewidth_modulation_depth : 8;   /* hardware LFOs, see REG_LFO */
+  uint32_t pulsewidth_modulation_speed : 8;
+  uint32_t vibrato_depth : 8;
+  uint32_t vibrato_speed : 8;
+  uint32_t default_volume: 8;
   int32_t volume_rampdown_rate: 8;
-  int32_t envelope_enable: 1;
-  const struct envelope_t *envelope;
+  int32_t envelope_enable: 1;     /* use the hardware ADSR envelope (scales default_volume) */
+  uint32_t attack: 4;             /* ADSR envelope rates/level, see REG_ENVELOPE */
+  uint32_t decay: 4;
+  uint32_t sustain: 4;
+  uint32_t release: 4;
+  int32_t pan: 5;                 /* PAN_LEFT..PAN_RIGHT (0 = centre) */
+  const int8_t *wavetable;        /* loaded into the voice's wavetable, for WAVE_WAVETABLE */
+  const struct audio_sample_t *sample;  /* if set, notes play this sample on the PCM voice instead */
   //uint32_t tremolo_depth;
   //uint32_t tremolo_speed;
   //uint32_t effect;
@@ -31,12 +40,16 @@ struct globalctrl_t {
   int32_t active;
   int32_t ticks_per_div;
 
-  int32_t next_pos_override; /* override for next song position */
+  int32_t next_pos_override; /* override for next song position (-1 = none) */
+  int32_t next_row_override; /* and the row to start there */
   int32_t song_pos;
   int32_t song_row;
   int32_t tick_div_count;
-  int32_t sound_fx_bar;
-  int32_t sound_fx_row;
+  int32_t duck;               /* music volume is shifted down by this while sound effects play */
+
+  int32_t filter_cutoff;      /* state-variable filter, see REG_FILTER */
+  int32_t filter_resonance;
+  uint32_t filter_mode;
 };
 
 struct songnote_expanded_t {
@@ -61,21 +74,92 @@ union songnote_t {
   uint32_t raw;
 };
 
+// the parts of a channel's instrument needed after the instrument is
+// selected, decoded into RAM then, so that playing notes doesn't have to
+// read the song (which is usually in flash) again
+struct channel_instrument_t {
+  const struct audio_sample_t *sample;
+  uint32_t envelope;      /* REG_ENVELOPE value (without the gate), 0 if the envelope isn't used */
+  uint32_t lfo;           /* REG_LFO value */
+  uint8_t default_volume;
+};
+
 struct channelctrl_t {
   union songnote_t note;
+  struct channel_instrument_t instrument;   /* decoded note.instrument */
   int32_t note_on_time;
+  int32_t gate_time;      /* ticks left before the gate is turned off (0 = hold until next note) */
+  uint32_t envelope;      /* REG_ENVELOPE value for the current note */
+  uint32_t mix;           /* REG_MIX filter routing */
+  int32_t pan;            /* REG_MIX pan position */
+  uint32_t lfo;           /* REG_LFO value (the instrument's, changed by the LFO effects) */
+  int32_t pitch;          /* for portamento, in 1/16ths of a semitone */
+  int32_t porta_target;
+  int32_t porta_speed;
+  int32_t arpeggio;       /* arpeggio step (0-2) */
   int8_t volume;
+  const uint8_t *bar_data;  /* next row of the current bar (packed) */
+  int32_t skip_rows;        /* empty rows left before the next packed row */
+};
+
+
+// a sound generated on the fly from a few parameters, rather than played from
+// the song: the frequency and pulse width are swept every tick while the gate
+// is open, and the whole thing can be repeated.  Frequencies are REG_FREQ/16
+// (about 1Hz per step).
+struct songplayer_sound_t {
+  uint16_t freq;              /* start frequency */
+  int16_t slide;              /* added to the frequency every tick */
+  int8_t slide_change;        /* added to the slide every tick */
+  uint8_t waveform;           /* WAVE_* */
+  uint8_t pulsewidth;         /* start pulse width (REG_PULSEWIDTH/16) */
+  int8_t pulsewidth_sweep;    /* added to the pulse width every tick (REG_PULSEWIDTH units) */
+  uint16_t envelope;          /* ENV_ATTACK | ENV_DECAY | ENV_SUSTAIN | ENV_RELEASE */
+  uint8_t volume;
+  uint8_t length;             /* ticks the gate is open for, each time it plays (1-255) */
+  uint8_t repeat;             /* times it is played again after the first */
+  uint8_t tail;               /* ticks left for the release before the voice is given back */
+};
+
+// sound effects are bars of the song, played over the music.  Up to
+// SONGPLAYER_SFX_SLOTS play at once: the first on the sound effect channel,
+// the others by stealing music channels (from the last one down).  When
+// every slot is busy, a new effect replaces the lowest priority one playing,
+// as long as its own priority is at least as high.  An effect with a sound
+// plays that instead of its bar.
+#define SONGPLAYER_SFX_SLOTS 3
+#define SONGPLAYER_SFX_QUEUE 4    /* effects triggered between ticks */
+
+struct songplayer_sfx_t {
+  uint8_t bar;          /* bar of the song to play */
+  uint8_t priority;     /* higher priorities win */
+  uint8_t duck;         /* halve the music volume this many times while it plays (0-7) */
+  const struct songplayer_sound_t *sound;   /* if set, played instead of the bar */
 };
 
+struct sfx_slot_t {
+  int32_t active;
+  struct songplayer_sfx_t sfx;
+  int32_t row;                  /* row of the bar, or tick of the sound */
+  const uint8_t *data;          /* packed bar data */
+  int32_t skip;
+  int32_t freq;                 /* sound state */
+  int32_t slide;
+  int32_t pulsewidth;
+  int32_t repeats;
+  struct channelctrl_t music;   /* the music channel's state, while its voice is stolen */
+};
 
 struct song_bar_t {
   union songnote_t notes[16];
 };
 
 struct song_pattern_t {
-  uint32_t bar[4];
+  uint32_t bar[SONGPLAYER_MUSIC_CHANNELS];
 };
 
+// songs are written as a song_t, and converted into a packed_song_t
+// (see tools/songpack) to be played.
 struct song_t {
   int32_t rows_per_bar;
   int32_t song_length;
@@ -87,6 +171,34 @@ struct song_t {
   struct song_pattern_t patterns[256];
 };
 
+// a song_t packed for playback.  Bars are stored as a run-length encoded
+// stream of rows, each starting with a byte :
+//   SONG_ROW_SKIP | n  - n (1..127) empty rows
+//   SONG_END_OF_BAR    - the rest of the bar is empty
+//   otherwise, a set of SONG_ROW_* flags, followed by a byte for each field
+//   present (in the order instrument, note, volume, effect, effect parameter);
+//   missing fields are zero.
+// Identical bars share their data, but keep their bar numbers (so that
+// sound effects can still be triggered by bar number).
+#define SONG_END_OF_BAR     0x00
+#define SONG_ROW_INSTRUMENT 0x01
+#define SONG_ROW_NOTE       0x02
+#define SONG_ROW_VOLUME     0x04
+#define SONG_ROW_EFFECT     0x08      /* effect and effect parameter */
+#define SONG_ROW_SKIP       0x80
+
+struct packed_song_t {
+  uint8_t rows_per_bar;
+  uint8_t ticks_per_div;
+  uint8_t num_channels;           /* bars per pattern */
+  uint16_t song_length;           /* entries in pattern_map */
+  uint16_t num_bars;              /* entries in bar_offsets */
+  const struct song_instrument_t *instruments;   /* 16 instruments */
+  const uint8_t *pattern_map;
+  const uint8_t *patterns;        /* num_channels bar numbers for each pattern */
+  const uint16_t *bar_offsets;    /* start of each bar in bar_data */
+  const uint8_t *bar_data;
+};
 
 // instruments
 // drum instruments (0-8)
@@ -95,22 +207,26 @@ struct song_t {
 //  -
 // normal instruments (8-15)
 //
-// effects
-// - octave arpeggio
-// - normal arpeggio @ notes
-// - slide pulsewidth @ speed
-// - slide up  (flag for glissando)
-// - slide down
-// - slide to note
-// - slide + octave arpeggio
-// - key-on / key-off
-// - vol slide
-// - filter on/off for current channel
-// - global filter controls
-// - set ticks per div
+// effects (numbered as in MOD files, where there's an equivalent)
+//  0xy - arpeggio (note, note+x, note+y; 0Cx for an octave arpeggio)
+//  1xx - slide up xx semitones every tick
+//  2xx - slide down xx semitones every tick
+//  3xx - portamento to the note, xx/16 semitones every tick
+//  4xy - vibrato at speed x, depth y (hardware LFO)
+//  5xy - portamento and volume slide
+//  6xy - vibrato and volume slide
+//  7xy - pulse width modulation at speed x, depth y (hardware LFO)
+//  8xx - pan (00 = left, 80 = centre, ff = right)
+//  9xx - filter cutoff
+//  Axy - volume slide (up x, down y every tick)
+//  Bxx - position jump
+//  Cxx - set volume
+//  Dxx - pattern break (to row xx of the next position)
+//  E0x-E4x - filter routing/sweeps/resonance/mode, ECx - key off after x ticks
+//  Fxx - set ticks per div
 
 // call to load a new song into memory
-void songplayer_init(const struct song_t *song);
+void songplayer_init(const struct packed_song_t *song);
 
 // call to start playing the song (from the given position)
 void songplayer_start(int pos);
@@ -118,10 +234,18 @@ void songplayer_start(int pos);
 // call to stop playing the song
 void songplayer_stop();
 
-// this needs to be called @ 50Hz
+// this needs to be called @ 50Hz.  Register writes are coalesced through the
+// audio register shadow; audio_shadow_stats shows how many each tick saves.
 void songplayer_tick();
 
-// call this to trigger a "sound effect" from the given song bar (this is played on channel 4).
+// set the table of sound effects for songplayer_play_sfx
+void songplayer_set_sfx_table(const struct songplayer_sfx_t *table, uint32_t count);
+
+// queue a sound effect from the table, to start on the next tick (dropped if the queue is full).
+// Bars start on the next row, sounds straight away.
+void songplayer_play_sfx(uint32_t sfx);
+
+// call this to trigger a "sound effect" from the given song bar (at the lowest priority, without ducking).
 void songplayer_trigger_effect(uint32_t bar_num);
 
 #endif
@@ -2,6 +2,15 @@
 
 struct sprite_config_reg_t sprite_state[4];
 
+uint32_t tile_attributes = 0;
+
+uint32_t display_fade = 0;
+uint32_t display_off = 0;
+
+uint32_t bitmap_enable = 0;
+uint32_t bitmap_xpos = 0;
+uint32_t bitmap_ypos = 0;
+
 void vid_init()
 {
   for (int i=0; i<4; i++) {
@@ -63,6 +72,11 @@ void vid_write_sprite_memory(uint32_t image_num, const uint32_t *data)
   }
 }
 
+void vid_set_sprite_bank(uint32_t bank)
+{
+  reg_video_sprite_bank = bank & 0x01;
+}
+
 void vid_set_texture_pixel(uint32_t texnum, uint32_t x, uint32_t y, uint32_t pixel)
 {
   reg_video_texmem[(texnum << 6) + (y << 3) + x] = pixel;
@@ -84,6 +98,24 @@ void vid_set_tile(uint32_t x, uint32_t y, uint32_t texture)
   reg_video_tilemem[(y<<6)+x]=texture;
 }
 
+void vid_set_tile_attributes(uint32_t set, uint32_t attributes)
+{
+  uint32_t shift = (set & 0x03) << 2;
+  tile_attributes = (tile_attributes & ~(0x0f << shift)) | ((attributes & 0x0f) << shift);
+  reg_video_tile_attributes = tile_attributes;
+}
+
+// colours[] holds the 8 colours that texture colours 0-7 are remapped to
+// for tiles whose attribute set has TILE_PALETTE
+void vid_set_tile_palette(const uint32_t *colours)
+{
+  uint32_t palette = 0;
+  for (int i = 0; i < 8; i++) {
+    palette |= (colours[i] & 0x07) << (i << 2);
+  }
+  reg_video_tile_palette = palette;
+}
+
 void vid_set_x_ofs(uint32_t x)
 {
   reg_video_xofs = x;
@@ -93,3 +125,129 @@ void vid_set_y_ofs(uint32_t y)
 {
   reg_video_yofs = y;
 }
+
+static void vid_update_display_ctrl()
+{
+  reg_video_display_ctrl = (display_off << 8) | display_fade;
+}
+
+void vid_set_fade(uint32_t level)
+{
+  display_fade = (level > VID_FADE_MAX) ? VID_FADE_MAX : level;
+  vid_update_display_ctrl();
+}
+
+void vid_set_display_enable(uint32_t enable)
+{
+  display_off = (enable & 0x01) ^ 0x01;
+  vid_update_display_ctrl();
+}
+
+static void vid_update_bitmap_pos()
+{
+  reg_video_bitmap_pos = (bitmap_enable << 31) | (bitmap_ypos << 16) | bitmap_xpos;
+}
+
+void vid_enable_bitmap(uint32_t enable)
+{
+  bitmap_enable = enable & 0x01;
+  vid_update_bitmap_pos();
+}
+
+// position of the top-left corner of the bitmap window, in tile map pixels
+void vid_set_bitmap_pos(uint32_t x, uint32_t y)
+{
+  bitmap_xpos = x & 511;
+  bitmap_ypos = y & 511;
+  vid_update_bitmap_pos();
+}
+
+void vid_set_bitmap_palette(uint32_t colour1, uint32_t colour2, uint32_t colour3)
+{
+  reg_video_bitmap_palette = ((colour3 & 0x07) << 8) | ((colour2 & 0x07) << 4) | (colour1 & 0x07);
+}
+
+void vid_plot(uint32_t x, uint32_t y, uint32_t colour)
+{
+  if (x >= VID_BITMAP_WIDTH || y >= VID_BITMAP_HEIGHT) {
+    return;
+  }
+  reg_video_bitmapmem[(y << 7) + x] = colour;
+}
+
+void vid_hline(uint32_t x0, uint32_t x1, uint32_t y, uint32_t colour)
+{
+  if (x0 > x1) {
+    uint32_t t = x0;
+    x0 = x1;
+    x1 = t;
+  }
+  if (y >= VID_BITMAP_HEIGHT || x0 >= VID_BITMAP_WIDTH) {
+    return;
+  }
+  if (x1 >= VID_BITMAP_WIDTH) {
+    x1 = VID_BITMAP_WIDTH - 1;
+  }
+  volatile uint32_t *row = &reg_video_bitmapmem[y << 7];
+  for (uint32_t x = x0; x <= x1; x++) {
+    row[x] = colour;
+  }
+}
+
+void vid_clear_bitmap(uint32_t colour)
+{
+  for (int i = 0; i < VID_BITMAP_WIDTH * VID_BITMAP_HEIGHT; i++) {
+    reg_video_bitmapmem[i] = colour;
+  }
+}
+
+uint32_t vid_blit_busy()
+{
+  return reg_video_blit[BLIT_CMD] & 0x01;
+}
+
+void vid_blit_wait()
+{
+  while (vid_blit_busy()) { }
+}
+
+#define BLIT_XY(x, y) ((((y) & 0x3f) << 16) | ((x) & 0x7f))
+
+void vid_blit_fill(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t colour)
+{
+  vid_blit_wait();
+  reg_video_blit[BLIT_DST] = BLIT_XY(x, y);
+  reg_video_blit[BLIT_SIZE] = (height << 16) | width;
+  reg_video_blit[BLIT_COLOUR] = colour & 0x03;
+  reg_video_blit[BLIT_CMD] = BLIT_OP_FILL;
+}
+
+static void vid_blit_copy_with_colour(uint32_t src_x, uint32_t src_y, uint32_t dst_x, uint32_t dst_y, uint32_t width, uint32_t height, uint32_t colour_reg)
+{
+  vid_blit_wait();
+  reg_video_blit[BLIT_SRC] = BLIT_XY(src_x, src_y);
+  reg_video_blit[BLIT_DST] = BLIT_XY(dst_x, dst_y);
+  reg_video_blit[BLIT_SIZE] = (height << 16) | width;
+  reg_video_blit[BLIT_COLOUR] = colour_reg;
+  reg_video_blit[BLIT_CMD] = BLIT_OP_COPY;
+}
+
+void vid_blit_copy(uint32_t src_x, uint32_t src_y, uint32_t dst_x, uint32_t dst_y, uint32_t width, uint32_t height)
+{
+  vid_blit_copy_with_colour(src_x, src_y, dst_x, dst_y, width, height, 0);
+}
+
+// pixels of key_colour in the source are left untouched in the destination
+void vid_blit_copy_keyed(uint32_t src_x, uint32_t src_y, uint32_t dst_x, uint32_t dst_y, uint32_t width, uint32_t height, uint32_t key_colour)
+{
+  vid_blit_copy_with_colour(src_x, src_y, dst_x, dst_y, width, height, BLIT_COLOUR_KEY_ENABLE | ((key_colour & 0x03) << 8));
+}
+
+void vid_blit_line(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, uint32_t colour)
+{
+  vid_blit_wait();
+  reg_video_blit[BLIT_DST] = BLIT_XY(x0, y0);
+  reg_video_blit[BLIT_SRC] = BLIT_XY(x1, y1);
+  reg_video_blit[BLIT_COLOUR] = colour & 0x03;
+  reg_video_blit[BLIT_CMD] = BLIT_OP_LINE;
+}
@@ -14,16 +14,62 @@
 #define reg_video_xofs        (*(volatile uint32_t*)0x05000000)
 #define reg_video_yofs        (*(volatile uint32_t*)0x05000004)
 #define reg_video_spriteconfig ((volatile uint32_t*)0x05000008)
+#define reg_video_tile_palette (*(volatile uint32_t*)0x05000030)
+#define reg_video_display_ctrl (*(volatile uint32_t*)0x05000034)
+#define reg_video_sprite_bank  (*(volatile uint32_t*)0x05000038)
+#define reg_video_tile_attributes (*(volatile uint32_t*)0x0500003c)
+#define reg_video_bitmap_pos     (*(volatile uint32_t*)0x05000028)
+#define reg_video_bitmap_palette (*(volatile uint32_t*)0x0500002c)
+#define reg_video_bitmapmem    ((volatile uint32_t*)0x05400000)
+
+#define reg_video_blit         ((volatile uint32_t*)0x05500000)
+
+#define VID_BITMAP_WIDTH  128
+#define VID_BITMAP_HEIGHT 64
+
+// blitter registers (offsets into reg_video_blit)
+#define BLIT_SRC    0
+#define BLIT_DST    1
+#define BLIT_SIZE   2
+#define BLIT_COLOUR 3
+#define BLIT_CMD    4
+
+#define BLIT_OP_FILL 1
+#define BLIT_OP_COPY 2
+#define BLIT_OP_LINE 3
+
+#define BLIT_COLOUR_KEY_ENABLE (1 << 16)
 
 void vid_init();
 
 void vid_set_texture(uint32_t texnum, const uint32_t *data);
 void vid_set_texture_pixel(uint32_t texnum, uint32_t x, uint32_t y, uint32_t pixel);
 void vid_set_tile(uint32_t x, uint32_t y, uint32_t texture);
+void vid_set_tile_palette(const uint32_t *colours);
+
+// tile attribute sets; OR TILE_SET(n) into the texture number passed to
+// vid_set_tile() to give the tile attribute set n (0-3)
+#define TILE_SET(n)    ((n) << 6)
+
+// tile attributes, for vid_set_tile_attributes()
+#define TILE_FLIP_X    (1 << 0)   // mirror texture horizontally
+#define TILE_FLIP_Y    (1 << 1)   // mirror texture vertically
+#define TILE_PALETTE   (1 << 2)   // remap texture colours through the tile palette
+#define TILE_PRIORITY  (1 << 3)   // draw non-zero texture pixels in front of sprites
+
+// set the attributes of the tiles using attribute set n (all sets start with none)
+void vid_set_tile_attributes(uint32_t set, uint32_t attributes);
 
 void vid_set_x_ofs(uint32_t x);
 void vid_set_y_ofs(uint32_t y);
 
+#define VID_FADE_MAX 15
+
+// fade the whole screen towards black (0 = full brightness, 15 = darkest)
+void vid_set_fade(uint32_t level);
+// turn the display off (eg. while rebuilding tiles/textures) or back on
+void vid_set_display_enable(uint32_t enable);
+
 struct sprite_config_reg_t {
   uint32_t enable;
   uint32_t colour;
@@ -38,6 +84,30 @@ void vid_set_sprite_pos(uint32_t sprite_num, uint32_t x, uint32_t y);
 void vid_set_sprite_colour(uint32_t sprite_num, uint32_t sprite_colour);
 void vid_set_all_sprite_config(uint32_t sprite_num, struct sprite_config_reg_t *config);
 void vid_write_sprite_memory(uint32_t image_num, const uint32_t *data);
+
+// sprite image banks (only available when the hardware is built with -Dvga_sprite_banks)
+// images 64-127 passed to vid_write_sprite_memory() are stored in bank 1; the sprites'
+// image numbers (0-63) refer to the bank selected with vid_set_sprite_bank().
+#define VID_SPRITE_IMAGES_PER_BANK 64
+void vid_set_sprite_bank(uint32_t bank);
 void vid_random_init_sprite_memory();
 
+// bitmap layer (only available when the hardware is built with -Dvga_bitmap)
+void vid_enable_bitmap(uint32_t enable);
+void vid_set_bitmap_pos(uint32_t x, uint32_t y);
+void vid_set_bitmap_palette(uint32_t colour1, uint32_t colour2, uint32_t colour3);
+void vid_plot(uint32_t x, uint32_t y, uint32_t colour);
+void vid_hline(uint32_t x0, uint32_t x1, uint32_t y, uint32_t colour);
+void vid_clear_bitmap(uint32_t colour);
+
+// blitter (only available when the hardware is built with -Dvga_bitmap -Dvga_blitter)
+// each call waits for the previous blit to finish, but returns as soon as the new one has started.
+// completion is signalled on IRQ 6.
+uint32_t vid_blit_busy();
+void vid_blit_wait();
+void vid_blit_fill(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t colour);
+void vid_blit_copy(uint32_t src_x, uint32_t src_y, uint32_t dst_x, uint32_t dst_y, uint32_t width, uint32_t height);
+void vid_blit_copy_keyed(uint32_t src_x, uint32_t src_y, uint32_t dst_x, uint32_t dst_y, uint32_t width, uint32_t height, uint32_t key_colour);
+void vid_blit_line(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, uint32_t colour);
+
 #endif
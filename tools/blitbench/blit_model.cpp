@@ -0,0 +1,259 @@
+/*
+ * A clock-accurate model of blitter.v, and of what it shares with the video
+ * scan-out in video_vga.v - see blit_model.h.
+ */
+#include "blit_model.h"
+
+#define RESET_CLOCKS 4
+
+// VGASyncGen: active video starts 107 clocks into a line and 20 lines into a frame
+#define H_PIXELS 427
+#define V_LINES 500
+#define H_BLACK 107
+#define V_BLACK 20
+
+// video_vga's address decoding (offsets from 0x0500_0000)
+#define VIDEO_REGS 0x0
+#define BITMAP_MEM 0x4
+#define BLITTER 0x5
+#define REG_BITMAP_POS 10
+
+enum { REG_SRC, REG_DST, REG_SIZE, REG_COLOUR, REG_CMD };
+
+enum { STATE_IDLE, STATE_FILL, STATE_COPY_READ, STATE_COPY_LATCH, STATE_COPY_WRITE, STATE_LINE };
+
+// a 10 bit signed register
+static int32_t s10(int32_t v) {
+  return ((v & 0x3ff) ^ 0x200) - 0x200;
+}
+
+// whether the scan-out is leaving the read port free (blit_rd_ready)
+bool BlitModel::read_ready() const {
+  bool video_active = hc_ >= H_BLACK && vc_ >= V_BLACK;
+  // x_px/y_px are 0 outside active video, and the window is tested with
+  // the next pixel's x and the halved y (the scroll offsets are left at 0)
+  uint32_t x_px = video_active ? hc_ - H_BLACK : 0;
+  uint32_t y_px = video_active ? vc_ - V_BLACK : 0;
+  uint32_t next_x = ((x_px & 0x1ff) + 1) & 0x1ff;
+  uint32_t bitmap_x = (next_x - (window_ & 0x1ff)) & 0x1ff;
+  uint32_t bitmap_y = ((y_px >> 1) - ((window_ >> 16) & 0x1ff)) & 0x1ff;
+  bool in_window = (window_ >> 31) && bitmap_x < BITMAP_WIDTH && bitmap_y < BITMAP_HEIGHT;
+  return !(video_active && in_window);
+}
+
+bool BlitModel::clock(bool resetn, bool write, uint32_t offset, uint32_t value) {
+  uint32_t select = (offset >> 20) & 0xf;
+  uint32_t bank = (offset >> 2) & 0x7;
+  bool cmd_write = write && select == BLITTER && bank == REG_CMD;
+  bool cpu_write = write && select == BITMAP_MEM;
+
+  uint32_t src_x = regs_[REG_SRC] & 0x7f, src_y = (regs_[REG_SRC] >> 16) & 0x3f;
+  uint32_t dst_x = regs_[REG_DST] & 0x7f, dst_y = (regs_[REG_DST] >> 16) & 0x3f;
+  uint32_t width = regs_[REG_SIZE] & 0xff, height = (regs_[REG_SIZE] >> 16) & 0x7f;
+  uint8_t colour = regs_[REG_COLOUR] & 3, colour_key = (regs_[REG_COLOUR] >> 8) & 3;
+  bool colour_key_enable = (regs_[REG_COLOUR] >> 16) & 1;
+
+  // everything below is worked out from the registers before the clock edge
+  bool rd_ready = read_ready();
+  bool wr_ready = !cpu_write;
+
+  bool rect_last_x = rect_x_ == width - 1;
+  bool rect_last_y = rect_y_ == height - 1;
+  uint32_t rect_dst_x = dst_x + rect_x_, rect_dst_y = dst_y + rect_y_;
+  uint32_t rect_src_x = src_x + rect_x_, rect_src_y = src_y + rect_y_;
+  bool rect_dst_visible = rect_dst_x < BITMAP_WIDTH && rect_dst_y < BITMAP_HEIGHT;
+  bool rect_src_visible = rect_src_x < BITMAP_WIDTH && rect_src_y < BITMAP_HEIGHT;
+
+  int32_t line_e2 = line_err_ * 2;
+  bool line_move_x = line_e2 >= line_dy_;
+  bool line_move_y = line_e2 <= line_dx_;
+  bool line_done = line_x_ == src_x && line_y_ == src_y;
+
+  bool mem_wen = (state_ == STATE_FILL) ? rect_dst_visible
+               : (state_ == STATE_COPY_WRITE) ? rect_dst_visible && copy_pixel_visible_
+                                                && !(colour_key_enable && copy_pixel_ == colour_key)
+               : (state_ == STATE_LINE);
+  uint32_t mem_waddr = (state_ == STATE_LINE) ? (line_y_ << 7) | line_x_
+                                              : ((rect_dst_y & 0x3f) << 7) | (rect_dst_x & 0x7f);
+  uint8_t mem_wdata = (state_ == STATE_COPY_WRITE) ? copy_pixel_ : colour;
+  bool blit_read = state_ == STATE_COPY_READ && rd_ready;
+
+  // the bitmap memory (the scan-out's own reads are left out: the blitter
+  // only looks at the read data on the clock after one of its reads)
+  uint8_t rdata = rdata_;
+  if (blit_read) {
+    rdata_ = bitmap_[((rect_src_y & 0x3f) << 7) | (rect_src_x & 0x7f)];
+  }
+  if (cpu_write) {
+    bitmap_[(offset >> 2) & 0x1fff] = value & 3;
+  } else if (mem_wen) {
+    bitmap_[mem_waddr] = mem_wdata;
+  }
+
+  // the blit state machine
+  switch (state_) {
+    case STATE_IDLE:
+      if (cmd_write) {
+        uint32_t dx = (src_x >= dst_x) ? src_x - dst_x : dst_x - src_x;
+        uint32_t dy = (src_y >= dst_y) ? src_y - dst_y : dst_y - src_y;
+        rect_x_ = 0;
+        rect_y_ = 0;
+        line_x_ = dst_x;
+        line_y_ = dst_y;
+        line_step_x_ = src_x < dst_x;
+        line_step_y_ = src_y < dst_y;
+        line_dx_ = s10(dx);
+        line_dy_ = s10(-(int32_t)dy);
+        line_err_ = s10((int32_t)dx - (int32_t)dy);
+        switch (value & 3) {
+          case BLIT_FILL: state_ = (width && height) ? STATE_FILL : STATE_IDLE; break;
+          case BLIT_COPY: state_ = (width && height) ? STATE_COPY_READ : STATE_IDLE; break;
+          case BLIT_LINE: state_ = STATE_LINE; break;
+          default: break;
+        }
+      }
+      break;
+
+    case STATE_FILL:
+    case STATE_COPY_WRITE:
+      if (wr_ready) {
+        state_ = (state_ == STATE_FILL) ? STATE_FILL : STATE_COPY_READ;
+        rect_x_ = (rect_x_ + 1) & 0xff;
+        if (rect_last_x) {
+          rect_x_ = 0;
+          rect_y_ = (rect_y_ + 1) & 0x7f;
+          if (rect_last_y) {
+            state_ = STATE_IDLE;
+          }
+        }
+      }
+      break;
+
+    case STATE_COPY_READ:
+      if (rd_ready) {
+        copy_pixel_visible_ = rect_src_visible;
+        state_ = STATE_COPY_LATCH;
+      }
+      break;
+
+    case STATE_COPY_LATCH:
+      copy_pixel_ = rdata;
+      state_ = STATE_COPY_WRITE;
+      break;
+
+    case STATE_LINE:
+      if (wr_ready) {
+        if (line_done) {
+          state_ = STATE_IDLE;
+        } else {
+          if (line_move_x) line_x_ = (line_step_x_ ? line_x_ - 1 : line_x_ + 1) & 0x7f;
+          if (line_move_y) line_y_ = (line_step_y_ ? line_y_ - 1 : line_y_ + 1) & 0x3f;
+          line_err_ = s10(line_err_ + (line_move_x ? line_dy_ : 0) + (line_move_y ? line_dx_ : 0));
+        }
+      }
+      break;
+  }
+  if (!resetn) {
+    state_ = STATE_IDLE;
+  }
+
+  // the registers
+  if (write && select == BLITTER && bank < REG_CMD) {
+    regs_[bank] = value;
+  }
+  if (write && select == VIDEO_REGS && ((offset >> 2) & 0xf) == REG_BITMAP_POS) {
+    window_ = value;
+  }
+  if (!resetn) {
+    window_ = 0;
+  }
+
+  // the beam
+  if (++hc_ == H_PIXELS) {
+    hc_ = 0;
+    vc_ = (vc_ + 1) % V_LINES;
+  }
+
+  return state_ != STATE_IDLE;
+}
+
+uint8_t blit_pattern(int x, int y) {
+  return (x * 7 + y * 3 + (x >> 3) * (y >> 2)) & 3;
+}
+
+std::vector<Blit> blit_runs() {
+  // (the copies go first, while there's still a pattern to copy)
+  static const Blit blits[] = {
+    { "copy 128x64", BLIT_COPY, 0, 0, 0, 0, 128, 64, 0 },
+    { "copy 32x32", BLIT_COPY, 0, 0, 64, 16, 32, 32, 0 },
+    { "copy 16x16, colour keyed", BLIT_COPY, 8, 8, 100, 40, 16, 16, 0x10000 },
+    { "fill 128x64", BLIT_FILL, 0, 0, 0, 0, 128, 64, 2 },
+    { "fill 16x16", BLIT_FILL, 0, 0, 40, 20, 16, 16, 1 },
+    { "fill 32x32, half clipped", BLIT_FILL, 0, 0, 112, 48, 32, 32, 3 },
+    { "line 128 across", BLIT_LINE, 127, 10, 0, 10, 0, 0, 1 },
+    { "line 64 down", BLIT_LINE, 30, 63, 30, 0, 0, 0, 2 },
+    { "line 128x64 diagonal", BLIT_LINE, 0, 0, 127, 63, 0, 0, 3 },
+    { "line 10x12", BLIT_LINE, 14, 14, 4, 2, 0, 0, 1 },
+    { "line 12x10, up and left", BLIT_LINE, 88, 40, 100, 50, 0, 0, 3 },
+  };
+  std::vector<Blit> runs;
+  for (Blit blit : blits) {
+    blit.window = false;
+    blit.start_phase = 0;
+    runs.push_back(blit);
+    blit.window = true;
+    for (int i = 0; i < BLIT_PHASES; i++) {
+      blit.start_phase = (uint32_t)((uint64_t)FRAME_CLOCKS * i / BLIT_PHASES);
+      runs.push_back(blit);
+    }
+  }
+  return runs;
+}
+
+std::vector<uint32_t> blit_time(const BlitClock &clock, const std::vector<Blit> &runs,
+                                const std::function<void(const Blit &blit)> &after_blit) {
+  uint64_t clocks = 0;
+  auto write = [&](uint32_t offset, uint32_t value) {
+    clocks++;
+    return clock(true, true, offset, value);
+  };
+  auto idle = [&]() {
+    clocks++;
+    return clock(true, false, 0, 0);
+  };
+
+  for (int i = 0; i < RESET_CLOCKS; i++) {
+    clocks++;
+    clock(false, false, 0, 0);
+  }
+  for (int y = 0; y < BITMAP_HEIGHT; y++) {
+    for (int x = 0; x < BITMAP_WIDTH; x++) {
+      write((BITMAP_MEM << 20) | ((y * BITMAP_WIDTH + x) << 2), blit_pattern(x, y));
+    }
+  }
+
+  std::vector<uint32_t> times;
+  for (const Blit &blit : runs) {
+    write((VIDEO_REGS << 20) | (REG_BITMAP_POS << 2), blit.window ? 0x80000000 : 0);
+    write((BLITTER << 20) | (REG_SRC << 2), (blit.src_y << 16) | blit.src_x);
+    write((BLITTER << 20) | (REG_DST << 2), (blit.dst_y << 16) | blit.dst_x);
+    write((BLITTER << 20) | (REG_SIZE << 2), (blit.height << 16) | blit.width);
+    write((BLITTER << 20) | (REG_COLOUR << 2), blit.colour);
+    while (clocks % FRAME_CLOCKS != blit.start_phase) {
+      idle();
+    }
+    // the clocks it's busy for, after the one the command is written on
+    uint32_t time = 0;
+    if (write((BLITTER << 20) | (REG_CMD << 2), blit.op)) {
+      while (idle()) {
+        time++;
+      }
+      time++;
+    }
+    times.push_back(time);
+    if (after_blit) {
+      after_blit(blit);
+    }
+  }
+  return times;
+}
@@ -0,0 +1,87 @@
+/*
+ * A clock-accurate model of the blitter (hdl/picosoc/video/blitter.v) as
+ * video_vga.v connects it: to the bitmap memory, whose read port it can
+ * only use while the beam isn't inside the bitmap window (so the model
+ * runs VGASyncGen's beam too), and whose write port it always gets here
+ * (blitbench never writes the bitmap from the CPU).
+ *
+ * Also the blits blitbench and blit_tb.cpp time, and the bus sequence that
+ * starts each one and waits for it, so the two count exactly the same clocks.
+ */
+#ifndef BLIT_MODEL_H
+#define BLIT_MODEL_H
+
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+#define BITMAP_WIDTH 128
+#define BITMAP_HEIGHT 64
+
+#define BLIT_FILL 1
+#define BLIT_COPY 2
+#define BLIT_LINE 3
+
+// the beam: VGASyncGen's 427 clocks a line, 500 lines a frame
+#define FRAME_CLOCKS (427 * 500)
+
+// each blit is timed with the bitmap window hidden, then shown (at the top
+// left of the screen) and started at this many points through a frame
+#define BLIT_PHASES 8
+
+class BlitModel {
+ public:
+  // one clock, with an optional write to the video peripheral (offset from
+  // 0x0500_0000, as video_vga decodes it); returns busy after the clock edge
+  bool clock(bool resetn, bool write, uint32_t offset, uint32_t value);
+
+  uint8_t pixel(int x, int y) const { return bitmap_[y * BITMAP_WIDTH + x]; }
+  void set_pixel(int x, int y, uint8_t colour) { bitmap_[y * BITMAP_WIDTH + x] = colour; }
+
+ private:
+  bool read_ready() const;
+
+  // the beam
+  uint32_t hc_ = 0, vc_ = 0;
+  uint32_t window_ = 0;                       // video register 10
+
+  // blitter.v
+  uint32_t regs_[4] = {};
+  int state_ = 0;
+  uint32_t rect_x_ = 0, rect_y_ = 0;
+  uint8_t copy_pixel_ = 0;
+  bool copy_pixel_visible_ = false;
+  uint32_t line_x_ = 0, line_y_ = 0;
+  bool line_step_x_ = false, line_step_y_ = false;
+  int32_t line_dx_ = 0, line_dy_ = 0, line_err_ = 0;
+
+  // bitmap memory
+  uint8_t bitmap_[BITMAP_WIDTH * BITMAP_HEIGHT] = {};
+  uint8_t rdata_ = 0;
+};
+
+struct Blit {
+  const char *name;
+  int op;
+  int src_x, src_y, dst_x, dst_y, width, height;
+  int colour;
+  bool window;                                // the bitmap window shown, so copies share its read port
+  uint32_t start_phase;                       // where the beam is in the frame when the blit is started
+};
+
+// the blits timed, each at a few start phases
+std::vector<Blit> blit_runs();
+
+// what's in the bitmap before the first blit
+uint8_t blit_pattern(int x, int y);
+
+// one clock of whatever is being timed: optional write, returns busy after the edge
+typedef std::function<bool(bool resetn, bool write, uint32_t offset, uint32_t value)> BlitClock;
+
+// resets, fills the bitmap with blit_pattern, then starts each blit and waits
+// for it; returns the clocks each is busy for, after the clock its command is
+// written on.  after_blit (if set) is called once each is done.
+std::vector<uint32_t> blit_time(const BlitClock &clock, const std::vector<Blit> &runs,
+                                const std::function<void(const Blit &blit)> &after_blit = nullptr);
+
+#endif
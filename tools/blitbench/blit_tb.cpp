@@ -0,0 +1,67 @@
+/*
+ * Checks blitbench's model against video_vga.v (built with the bitmap and
+ * the blitter): runs the same register writes and blits through both in
+ * Verilator, comparing the busy flag every clock, and prints the clocks
+ * the Verilog blitter takes over each one.
+ *
+ * Built and run by "make verify".
+ */
+#include <stdio.h>
+#include <algorithm>
+
+#include "Vvideo_vga.h"
+#include "verilated.h"
+#include "blit_model.h"
+
+#define VIDEO_BASE 0x05000000
+#define MAX_MISMATCHES_SHOWN 10
+
+int main(int argc, char **argv) {
+  Verilated::commandArgs(argc, argv);
+
+  Vvideo_vga *tb = new Vvideo_vga;
+  BlitModel model;
+  uint64_t clocks = 0, mismatches = 0;
+
+  std::vector<Blit> runs = blit_runs();
+  std::vector<uint32_t> times = blit_time(
+    [&](bool resetn, bool write, uint32_t offset, uint32_t value) {
+      tb->resetn = resetn;
+      tb->iomem_valid = write;
+      tb->iomem_wstrb = write ? 0xf : 0;
+      tb->iomem_addr = VIDEO_BASE | offset;
+      tb->iomem_wdata = value;
+      tb->clk = 0;
+      tb->eval();
+      tb->clk = 1;
+      tb->eval();
+      bool busy = tb->iomem_rdata & 1;
+      if (model.clock(resetn, write, offset, value) != busy) {
+        if (mismatches++ < MAX_MISMATCHES_SHOWN) {
+          printf("clock %llu: video_vga.v busy %d, model %d\n", (unsigned long long)clocks, busy, !busy);
+        }
+      }
+      clocks++;
+      return busy;
+    },
+    runs);
+
+  printf("Clocks video_vga.v's blitter takes, with the bitmap window hidden, and shown\n\n");
+  printf("| Blit                      | Hidden | Shown           |\n");
+  printf("|---------------------------|--------|-----------------|\n");
+  for (size_t i = 0; i < runs.size(); i += 1 + BLIT_PHASES) {
+    uint32_t fastest = *std::min_element(times.begin() + i + 1, times.begin() + i + 1 + BLIT_PHASES);
+    uint32_t slowest = *std::max_element(times.begin() + i + 1, times.begin() + i + 1 + BLIT_PHASES);
+    printf("| %-25s | %6u | %7u-%-7u |\n", runs[i].name, times[i], fastest, slowest);
+  }
+  printf("\n");
+
+  tb->final();
+  delete tb;
+  if (mismatches) {
+    printf("%llu clocks where the model's busy flag was wrong\n", (unsigned long long)mismatches);
+    return 1;
+  }
+  printf("the model matched video_vga.v for all %llu clocks\n", (unsigned long long)clocks);
+  return 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * blitbench - counts the clocks the blitter takes over fills, copies and
+ * lines, on a clock-accurate model of blitter.v and the bitmap memory's
+ * shared read port (blit_model.cpp, which "make verify" checks against
+ * video_vga.v), eg.
+ *
+ *   blitbench
+ *
+ * Each blit is run with the bitmap window hidden, and then shown, at
+ * the top left of the screen, where copies have to wait for the beam to
+ * leave it before they can read a pixel.  With the window shown, each is
+ * started at BLIT_PHASES points through a frame, and the quickest and
+ * slowest are printed.  The model's bitmap is checked against the same
+ * blits drawn in C after every one.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#include "blit_model.h"
+
+#define CLOCK_MHZ 16
+
+static uint8_t reference[BITMAP_HEIGHT][BITMAP_WIDTH];
+
+static bool on_bitmap(int x, int y) {
+  return x >= 0 && x < BITMAP_WIDTH && y >= 0 && y < BITMAP_HEIGHT;
+}
+
+// draws the blit into reference; returns the pixels it covers (clipped or not)
+static int draw(const Blit &blit) {
+  switch (blit.op) {
+    case BLIT_FILL:
+    case BLIT_COPY:
+      for (int y = 0; y < blit.height; y++) {
+        for (int x = 0; x < blit.width; x++) {
+          int dx = blit.dst_x + x, dy = blit.dst_y + y, sx = blit.src_x + x, sy = blit.src_y + y;
+          if (blit.op == BLIT_FILL) {
+            if (on_bitmap(dx, dy)) {
+              reference[dy][dx] = blit.colour & 3;
+            }
+          } else if (on_bitmap(dx, dy) && on_bitmap(sx, sy)) {
+            uint8_t pixel = reference[sy][sx];
+            if (!((blit.colour >> 16) & 1) || pixel != ((blit.colour >> 8) & 3)) {
+              reference[dy][dx] = pixel;
+            }
+          }
+        }
+      }
+      return blit.width * blit.height;
+
+    default: {
+      // from the destination to the source
+      int x = blit.dst_x, y = blit.dst_y;
+      int dx = abs(blit.src_x - x), dy = -abs(blit.src_y - y);
+      int step_x = (x < blit.src_x) ? 1 : -1, step_y = (y < blit.src_y) ? 1 : -1;
+      int err = dx + dy, pixels = 0;
+      for (;;) {
+        reference[y][x] = blit.colour & 3;
+        pixels++;
+        if (x == blit.src_x && y == blit.src_y) {
+          return pixels;
+        }
+        int e2 = 2 * err;
+        if (e2 >= dy) {
+          err += dy;
+          x += step_x;
+        }
+        if (e2 <= dx) {
+          err += dx;
+          y += step_y;
+        }
+      }
+    }
+  }
+}
+
+int main() {
+  BlitModel model;
+  for (int y = 0; y < BITMAP_HEIGHT; y++) {
+    for (int x = 0; x < BITMAP_WIDTH; x++) {
+      reference[y][x] = blit_pattern(x, y);
+    }
+  }
+
+  std::vector<Blit> runs = blit_runs();
+  std::vector<int> pixels;
+  bool drawn = true;
+  std::vector<uint32_t> times = blit_time(
+    [&model](bool resetn, bool write, uint32_t offset, uint32_t value) {
+      return model.clock(resetn, write, offset, value);
+    },
+    runs,
+    [&](const Blit &blit) {
+      pixels.push_back(draw(blit));
+      for (int y = 0; y < BITMAP_HEIGHT; y++) {
+        for (int x = 0; x < BITMAP_WIDTH; x++) {
+          if (model.pixel(x, y) != reference[y][x] && drawn) {
+            printf("%s: pixel (%d, %d) is %d, should be %d\n", blit.name, x, y, model.pixel(x, y), reference[y][x]);
+            drawn = false;
+          }
+        }
+      }
+    });
+
+  printf("Blitter clocks (at %dMHz), with the bitmap window hidden, and shown\n\n", CLOCK_MHZ);
+  printf("| Blit                      | Pixels | Hidden: clocks | a pixel | time     | Shown: clocks   | a pixel   |\n");
+  printf("|---------------------------|--------|----------------|---------|----------|-----------------|-----------|\n");
+  for (size_t i = 0; i < runs.size(); i += 1 + BLIT_PHASES) {
+    uint32_t hidden = times[i];
+    uint32_t fastest = *std::min_element(times.begin() + i + 1, times.begin() + i + 1 + BLIT_PHASES);
+    uint32_t slowest = *std::max_element(times.begin() + i + 1, times.begin() + i + 1 + BLIT_PHASES);
+    double n = pixels[i];
+    printf("| %-25s | %6d | %14u | %7.2f | %6.1fus | %7u-%-7u | %4.2f-%-4.2f |\n", runs[i].name, pixels[i], hidden,
+           hidden / n, (double)hidden / CLOCK_MHZ, fastest, slowest, fastest / n, slowest / n);
+  }
+  printf("\n");
+  if (!drawn) {
+    printf("the model drew something different\n");
+    return 1;
+  }
+  return 0;
+}
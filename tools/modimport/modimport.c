@@ -0,0 +1,823 @@
+/*
+ * modimport - converts a tracker module (a ProTracker MOD, with 4 channels,
+ * or up to SONGPLAYER_MUSIC_CHANNELS with an xCHN tag) into a packed_song_t
+ * for the song player, written to stdout as C source (as songpack does).
+ *
+ * Each MOD pattern becomes a song pattern of 64 row bars, one per channel.
+ * Identical bars, and identical patterns, are merged, and patterns the song
+ * doesn't play are dropped.
+ *
+ * The samples are mapped onto instruments:
+ *  - samples named like drums (kick, snare, hi-hat) use the player's
+ *    percussion instruments (1-4)
+ *  - pitched samples play one cycle of their waveform, as a wavetable (or the
+ *    nearest of the square/sawtooth/triangle waves, with -c), transposed so
+ *    that they play at the pitch they had in the MOD
+ *  - unpitched samples play noise (or, with -p, the sample itself, on the PCM voice)
+ * with an envelope that holds looped samples, and fades the others out over
+ * about the length of the sample.  Identical instruments are merged.
+ *
+ * The effects are mapped onto the player's where there is one (see
+ * songplayer.h); the others are dropped, and listed at the end.  The player's
+ * tick rate is fixed at 50Hz (125 BPM), so tempo changes change the speed instead.
+ *
+ * See the Makefile for how to run it.
+ */
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <songplayer/songplayer.h>
+
+#include "../songpack/encode.h"
+
+#define MOD_SAMPLES 31
+#define MOD_ROWS 64
+#define MOD_ORDERS 128
+#define MOD_HEADER_SIZE 1084
+
+#define C2_RATE 8287.14       /* a sample's playback rate at C-2 (period 428, PAL) */
+#define C2_NOTE 61            /* C-2 plays as middle C (C 3 in note_to_freq) */
+#define C2_HZ 261.63
+
+#define MAX_BARS 256
+#define FLASH_SIZE (1024 * 1024)
+
+// sizes on the (32 bit) target, for the flash used
+#define PACKED_SONG_SIZE 28
+#define INSTRUMENT_SIZE 20
+#define AUDIO_SAMPLE_SIZE 20
+
+struct mod_sample_t {
+  char name[23];
+  const int8_t *data;
+  uint32_t length;          /* in bytes */
+  uint32_t loop_start;
+  uint32_t loop_length;     /* 0 if it doesn't loop */
+  int finetune;             /* eighths of a semitone */
+  int volume;               /* 0-64 */
+};
+
+// an instrument of the imported song
+struct import_instrument_t {
+  struct song_instrument_t in;
+  int used;
+  int has_wavetable;
+  int8_t wavetable[AUDIO_WAVETABLE_SIZE];
+  const struct mod_sample_t *pcm;   /* played on the PCM voice */
+};
+
+static struct mod_sample_t samples[MOD_SAMPLES + 1];
+static int num_channels;
+static int song_length;
+static uint8_t order[MOD_ORDERS];
+static const uint8_t *mod_patterns;
+
+static struct import_instrument_t instruments[16];
+static int sample_instrument[MOD_SAMPLES + 1];
+static int sample_transpose[MOD_SAMPLES + 1];   /* semitones */
+
+static int use_pcm = 0;
+static int use_wavetables = 1;
+
+// the converted song
+static int pattern_number[MOD_ORDERS];            /* song pattern for each MOD pattern (-1 = not converted yet) */
+static uint8_t song_patterns[MOD_ORDERS][SONGPLAYER_MUSIC_CHANNELS];
+static int num_song_patterns = 0;
+static struct songpack_bar_data_t bar_data;
+static int bar_offsets[MAX_BARS];
+static int bar_lengths[MAX_BARS];
+static int num_bars = 0;
+static int dropped_effects[16];
+static int dropped_extended[16];
+
+static uint32_t read_be16(const uint8_t *p) {
+  return (p[0] << 8) | p[1];
+}
+
+static void fail(const char *message, const char *detail) {
+  fprintf(stderr, "modimport: %s%s\n", message, detail);
+  exit(1);
+}
+
+static uint8_t *read_file(const char *name, long *length) {
+  FILE *f = fopen(name, "rb");
+  if (!f) {
+    perror(name);
+    exit(1);
+  }
+  fseek(f, 0, SEEK_END);
+  *length = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  uint8_t *data = malloc(*length + 1);
+  if (!data || fread(data, 1, *length, f) != (size_t)*length) {
+    fail("can't read ", name);
+  }
+  fclose(f);
+  return data;
+}
+
+static void load_mod(const char *name) {
+  long length;
+  const uint8_t *mod = read_file(name, &length);
+  if (length < MOD_HEADER_SIZE) {
+    fail("too short to be a MOD: ", name);
+  }
+
+  const char *tag = (const char *)&mod[1080];
+  if (!memcmp(tag, "M.K.", 4) || !memcmp(tag, "M!K!", 4) || !memcmp(tag, "FLT4", 4) || !memcmp(tag, "4CHN", 4)) {
+    num_channels = 4;
+  } else if (isdigit((unsigned char)tag[0]) && !memcmp(tag + 1, "CHN", 3)) {
+    num_channels = tag[0] - '0';
+  } else {
+    fail("not a 31 sample MOD (M.K., FLT4 or xCHN): ", name);
+  }
+  if (num_channels < 1 || num_channels > SONGPLAYER_MUSIC_CHANNELS) {
+    fail("too many channels for the song player: ", name);
+  }
+
+  song_length = mod[950];
+  if (song_length < 1 || song_length > MOD_ORDERS) {
+    fail("bad song length in ", name);
+  }
+  int num_mod_patterns = 0;
+  for (int pos = 0; pos < MOD_ORDERS; pos++) {
+    order[pos] = mod[952 + pos];
+    if (order[pos] + 1 > num_mod_patterns) {
+      num_mod_patterns = order[pos] + 1;
+    }
+  }
+  mod_patterns = &mod[MOD_HEADER_SIZE];
+
+  // the sample data follows the patterns
+  long offset = MOD_HEADER_SIZE + (long)num_mod_patterns * MOD_ROWS * num_channels * 4;
+  if (offset > length) {
+    fail("patterns missing from ", name);
+  }
+  for (int s = 1; s <= MOD_SAMPLES; s++) {
+    const uint8_t *header = &mod[20 + (s - 1) * 30];
+    struct mod_sample_t *sample = &samples[s];
+    memcpy(sample->name, header, 22);
+    sample->name[22] = 0;
+    sample->length = read_be16(&header[22]) * 2;
+    sample->finetune = (header[24] & 0x0f) - ((header[24] & 0x08) ? 16 : 0);
+    sample->volume = (header[25] > 64) ? 64 : header[25];
+    sample->loop_start = read_be16(&header[26]) * 2;
+    sample->loop_length = read_be16(&header[28]) * 2;
+    sample->data = (const int8_t *)&mod[offset];
+    if (offset + sample->length > length) {
+      sample->length = length - offset;    // (truncated modules are common enough)
+    }
+    offset += sample->length;
+    if (sample->loop_length <= 2 || sample->loop_start + sample->loop_length > sample->length) {
+      sample->loop_length = 0;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////
+// instruments
+///////////////////////////////////////////////////////////////////////
+
+// the sample's waveform, taken from the loop (repeated) if it has one, or
+// else from after the attack: up to length values, returning how many
+static int sample_waveform(const struct mod_sample_t *sample, double *x, int length) {
+  int n = 0;
+  if (sample->loop_length) {
+    for (n = 0; n < length; n++) {
+      x[n] = sample->data[sample->loop_start + n % sample->loop_length];
+    }
+  } else {
+    uint32_t start = sample->length / 8;
+    for (n = 0; n < length && start + n < sample->length; n++) {
+      x[n] = sample->data[start + n];
+    }
+  }
+  double mean = 0;
+  for (int i = 0; i < n; i++) {
+    mean += x[i];
+  }
+  for (int i = 0; i < n; i++) {
+    x[i] -= mean / n;
+  }
+  return n;
+}
+
+// the length of one cycle of the waveform, by autocorrelation (0 if it isn't pitched)
+static double find_cycle(const double *x, int n) {
+  static double r[2048];
+  int max_lag = n / 2;
+  double best = 0;
+  for (int lag = 2; lag < max_lag; lag++) {
+    double xy = 0, xx = 0, yy = 0;
+    for (int i = 0; i + lag < n; i++) {
+      xy += x[i] * x[i + lag];
+      xx += x[i] * x[i];
+      yy += x[i + lag] * x[i + lag];
+    }
+    r[lag] = (xx > 0 && yy > 0) ? xy / sqrt(xx * yy) : 0;
+    if (r[lag] > best) {
+      best = r[lag];
+    }
+  }
+  if (best < 0.6) {
+    return 0;
+  }
+  // the first peak nearly as high as the best, so as not to pick a multiple of the cycle
+  for (int lag = 3; lag < max_lag - 1; lag++) {
+    if (r[lag] >= 0.9 * best && r[lag] >= r[lag - 1] && r[lag] >= r[lag + 1]) {
+      double a = r[lag - 1], b = r[lag], c = r[lag + 1];
+      double denominator = a - 2 * b + c;
+      return lag + ((denominator != 0) ? 0.5 * (a - c) / denominator : 0);
+    }
+  }
+  return 0;
+}
+
+// the nearest envelope rate to a time (in ms), from the tables in the audio README
+static int envelope_rate(double ms) {
+  static const double decay_ms[16] = {
+    6, 24, 48, 72, 114, 168, 204, 240, 300, 750, 1500, 2400, 3000, 9000, 15000, 24000
+  };
+  int rate = 0;
+  for (int i = 1; i < 16; i++) {
+    if (fabs(log(decay_ms[i] / ms)) < fabs(log(decay_ms[rate] / ms))) {
+      rate = i;
+    }
+  }
+  return rate;
+}
+
+static int contains(const char *name, const char *word) {
+  return strstr(name, word) != NULL;
+}
+
+// the percussion instrument for a sample named like a drum, or 0
+static int percussion_instrument(const struct mod_sample_t *sample) {
+  char name[23];
+  for (int i = 0; i < 23; i++) {
+    name[i] = tolower((unsigned char)sample->name[i]);
+  }
+  if (contains(name, "kick") || contains(name, "bd") || contains(name, "bassdrum") || contains(name, "bass drum")) {
+    return 1;
+  }
+  if (contains(name, "snare") || contains(name, "snr") || contains(name, "sd") || contains(name, "clap")) {
+    return 4;
+  }
+  if (contains(name, "hat") || contains(name, "hh") || contains(name, "cymbal")) {
+    return contains(name, "open") || contains(name, "oh") ? 3 : 2;
+  }
+  return 0;
+}
+
+// the nearest of the hardware's waveforms to one cycle of a sample
+static int classic_waveform(const double *x, int cycle, int *pulsewidth) {
+  double peak = 0, max_step = 0;
+  int extreme = 0, high = 0;
+  for (int i = 0; i < cycle; i++) {
+    peak = fmax(peak, fabs(x[i]));
+  }
+  for (int i = 0; i < cycle; i++) {
+    extreme += fabs(x[i]) > 0.7 * peak;
+    high += x[i] > 0;
+    max_step = fmax(max_step, fabs(x[(i + 1) % cycle] - x[i]));
+  }
+  if (extreme >= cycle * 6 / 10) {
+    *pulsewidth = high * 4095 / cycle;
+    return WAVE_SQUARE;
+  }
+  *pulsewidth = 2048;
+  return (max_step > peak) ? WAVE_SAWTOOTH : WAVE_TRIANGLE;
+}
+
+// map a sample onto an instrument (and the transpose for its notes)
+static void import_sample(int s, struct import_instrument_t *instrument) {
+  const struct mod_sample_t *sample = &samples[s];
+  static double x[4096];
+  int n = sample_waveform(sample, x, 4096);
+  double cycle = find_cycle(x, n);
+  double seconds = sample->length / C2_RATE;
+
+  memset(instrument, 0, sizeof(*instrument));
+  instrument->in.default_volume = (sample->volume * 4 > 255) ? 255 : sample->volume * 4;
+  instrument->in.pulsewidth = 2048;
+  instrument->in.envelope_enable = 1;
+  if (sample->loop_length) {
+    instrument->in.sustain = 15;
+    instrument->in.release = envelope_rate(50);
+  } else {
+    instrument->in.decay = envelope_rate(seconds * 1000);
+    instrument->in.release = instrument->in.decay;
+  }
+  sample_transpose[s] = 0;
+
+  if (cycle == 0) {
+    if (use_pcm) {
+      instrument->pcm = sample;
+    } else {
+      // noise, clocking the LFSR at about twice the rate the sample crosses zero
+      int crossings = 0;
+      for (int i = 1; i < n; i++) {
+        crossings += (x[i - 1] < 0) != (x[i] < 0);
+      }
+      double hz = (n > 1 && crossings) ? crossings * C2_RATE / (n - 1) / 16 : C2_HZ;
+      instrument->in.waveform_select = WAVE_NOISE;
+      sample_transpose[s] = (int)lround(12 * log2(hz / C2_HZ));
+    }
+    return;
+  }
+
+  // pitched: one cycle of the waveform, at the sample's pitch
+  sample_transpose[s] = (int)lround(12 * log2(C2_RATE / cycle / C2_HZ) + sample->finetune / 8.0);
+  if (use_wavetables) {
+    instrument->in.waveform_select = WAVE_WAVETABLE;
+    instrument->has_wavetable = 1;
+    for (int i = 0; i < AUDIO_WAVETABLE_SIZE; i++) {
+      double pos = i * cycle / AUDIO_WAVETABLE_SIZE;
+      int i0 = (int)pos;
+      double value = x[i0] + (x[i0 + 1] - x[i0]) * (pos - i0);
+      instrument->wavetable[i] = (int8_t)fmax(-128, fmin(127, lround(value)));
+    }
+  } else {
+    int pulsewidth;
+    instrument->in.waveform_select = classic_waveform(x, (int)lround(cycle), &pulsewidth);
+    instrument->in.pulsewidth = pulsewidth;
+  }
+}
+
+static int same_instrument(const struct import_instrument_t *a, const struct import_instrument_t *b) {
+  return a->in.waveform_select == b->in.waveform_select && a->in.pulsewidth == b->in.pulsewidth
+         && a->in.default_volume == b->in.default_volume && a->in.envelope_enable == b->in.envelope_enable
+         && a->in.attack == b->in.attack && a->in.decay == b->in.decay
+         && a->in.sustain == b->in.sustain && a->in.release == b->in.release
+         && a->has_wavetable == b->has_wavetable
+         && (!a->has_wavetable || !memcmp(a->wavetable, b->wavetable, sizeof(a->wavetable)))
+         && a->pcm == b->pcm;
+}
+
+// the samples the song plays
+static void find_used_samples(int *used) {
+  for (int pos = 0; pos < song_length; pos++) {
+    const uint8_t *pattern = &mod_patterns[order[pos] * MOD_ROWS * num_channels * 4];
+    for (int i = 0; i < MOD_ROWS * num_channels; i++) {
+      int s = (pattern[i * 4] & 0xf0) | (pattern[i * 4 + 2] >> 4);
+      if (s >= 1 && s <= MOD_SAMPLES) {
+        used[s] = 1;
+      }
+    }
+  }
+}
+
+static void import_instruments() {
+  int used[MOD_SAMPLES + 1] = { 0 };
+  find_used_samples(used);
+
+  int next_instrument = FIRST_USER_INSTRUMENT;
+  for (int s = 1; s <= MOD_SAMPLES; s++) {
+    sample_instrument[s] = 0;
+    if (!used[s] || samples[s].length < 4) {
+      continue;
+    }
+    struct import_instrument_t instrument;
+    import_sample(s, &instrument);
+
+    int percussion = percussion_instrument(&samples[s]);
+    if (percussion && !instrument.pcm) {
+      // (the player sets the percussion's waveform and pitch itself)
+      if (!instruments[percussion].used) {
+        instruments[percussion] = instrument;
+        instruments[percussion].in.waveform_select = WAVE_NONE;
+        instruments[percussion].has_wavetable = 0;
+      }
+      sample_instrument[s] = percussion;
+      continue;
+    }
+
+    int match = 0;
+    for (int i = FIRST_USER_INSTRUMENT; i < next_instrument && !match; i++) {
+      if (same_instrument(&instruments[i], &instrument)) {
+        match = i;
+      }
+    }
+    if (!match && next_instrument < 16) {
+      match = next_instrument++;
+      instruments[match] = instrument;
+    } else if (!match) {
+      // out of instruments; share one with the same waveform (or else the first)
+      match = FIRST_USER_INSTRUMENT;
+      for (int i = next_instrument - 1; i >= FIRST_USER_INSTRUMENT; i--) {
+        if (instruments[i].in.waveform_select == instrument.in.waveform_select) {
+          match = i;
+        }
+      }
+      fprintf(stderr, "modimport: out of instruments; sample %d (%s) shares instrument %d\n",
+              s, samples[s].name, match);
+    }
+    instruments[match].used = 1;
+    sample_instrument[s] = match;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////
+// patterns
+///////////////////////////////////////////////////////////////////////
+
+// the channels' state, as the song is played through in order
+struct channel_state_t {
+  int sample;
+  double period;        /* of the note playing (0 if none yet) */
+  int pitch;            /* song note of it, in 1/16ths of a semitone */
+};
+
+static struct channel_state_t channels[SONGPLAYER_MUSIC_CHANNELS];
+static int speed = 6;           /* ticks per row */
+static int tempo = 125;         /* BPM; the player's ticks are always at 125 BPM */
+
+static int clamp(int value, int min, int max) {
+  return (value < min) ? min : (value > max) ? max : value;
+}
+
+// song note for a period, before the sample's transpose (in 1/16ths of a semitone)
+static int period_pitch(double period) {
+  return (int)lround(16 * (12 * log2(428.0 / period) + C2_NOTE));
+}
+
+// semitones (in 1/16ths) a period slide of amount moves, at a period
+static int slide_pitch(double period, int amount) {
+  if (period - amount <= 0) {
+    return 255;
+  }
+  return (int)lround(16 * 12 * log2(period / (period - amount)));
+}
+
+// volume slides: the player's volumes are 4 times the MOD's
+static int volume_slide_param(int param) {
+  int up = clamp((param >> 4) * 4, 0, 15), down = clamp((param & 0x0f) * 4, 0, 15);
+  return (up << 4) | down;
+}
+
+static int scaled_speed() {
+  return clamp((speed * 125 + tempo / 2) / tempo, 1, 31);
+}
+
+// convert one row of one channel
+static struct songnote_expanded_t convert_row(struct channel_state_t *ch, const uint8_t *cell) {
+  struct songnote_expanded_t note = { 0 };
+  int period = ((cell[0] & 0x0f) << 8) | cell[1];
+  int s = (cell[0] & 0xf0) | (cell[2] >> 4);
+  int effect = cell[2] & 0x0f;
+  int param = cell[3];
+
+  if (s >= 1 && s <= MOD_SAMPLES) {
+    ch->sample = s;
+    note.instrument = sample_instrument[s];
+  }
+  int transpose = sample_transpose[ch->sample] * 16;
+  if (period) {
+    int pitch = period_pitch(period) + transpose;
+    note.new_note = clamp((pitch + 8) >> 4, 1, 127);
+    if (effect != 0x3 && effect != 0x5) {
+      ch->period = period;
+      ch->pitch = note.new_note << 4;
+    }
+  }
+
+  switch (effect) {
+    case 0x0:   // arpeggio
+      if (param) {
+        note.effect = 0x0;
+        note.effect_parameter = param;
+      }
+      break;
+    case 0x1:   // portamento up/down (by periods, every tick)
+    case 0x2: {
+      if (param == 0) {
+        break;
+      }
+      double base = ch->period ? ch->period : 428;
+      int step = slide_pitch(base, (effect == 0x1) ? param : -param);
+      step = (step < 0) ? -step : step;
+      if (period || !ch->period) {
+        // a note as well: the player can only slide in whole semitones
+        if (step >= 8) {
+          note.effect = effect;
+          note.effect_parameter = clamp((step + 8) >> 4, 1, 255);
+        } else {
+          dropped_effects[effect]++;
+        }
+      } else {
+        // slide to where it would have got to by the end of the row, with a portamento
+        int ticks = speed - 1;
+        int target = ch->pitch + ((effect == 0x1) ? step : -step) * ticks;
+        target = clamp(target, 16, 127 * 16);
+        note.new_note = (target + 8) >> 4;
+        note.effect = 0x3;
+        note.effect_parameter = clamp(step, 1, 255);
+        ch->period = ch->period * pow(2, (ch->pitch - target) / (16.0 * 12));
+        ch->pitch = target;
+      }
+      break;
+    }
+    case 0x3:   // tone portamento
+    case 0x5:   // ... and volume slide
+      if (period) {
+        ch->period = period;
+        ch->pitch = note.new_note << 4;
+      }
+      note.effect = effect;
+      if (effect == 0x3) {
+        note.effect_parameter = param ? clamp(slide_pitch(ch->period ? ch->period : 428, param), 1, 255) : 0;
+      } else {
+        note.effect_parameter = volume_slide_param(param);
+      }
+      break;
+    case 0x4:   // vibrato (the LFO's speed and depth are close to the MOD's)
+      note.effect = 0x4;
+      note.effect_parameter = param;
+      break;
+    case 0x6:   // vibrato and volume slide
+    case 0xa:   // volume slide
+      note.effect = effect;
+      note.effect_parameter = volume_slide_param(param);
+      break;
+    case 0x8:   // pan
+      note.effect = 0x8;
+      note.effect_parameter = param;
+      break;
+    case 0xb:   // position jump
+      if (param < song_length) {
+        note.effect = 0xb;
+        note.effect_parameter = param;
+      }
+      break;
+    case 0xc:   // volume
+      note.effect = 0xc;
+      note.effect_parameter = clamp(param * 4, 0, 255);
+      break;
+    case 0xd:   // pattern break (to a row given in decimal)
+      note.effect = 0xd;
+      note.effect_parameter = clamp((param >> 4) * 10 + (param & 0x0f), 0, MOD_ROWS - 1);
+      break;
+    case 0xe:   // extended: only note cut (as a key off)
+      if ((param >> 4) == 0xc) {
+        note.effect = 0xe;
+        note.effect_parameter = param;
+      } else {
+        dropped_extended[param >> 4]++;
+      }
+      break;
+    case 0xf:   // speed (ticks per row), or tempo (BPM) from 32 up
+      if (param == 0) {
+        dropped_effects[effect]++;
+        break;
+      }
+      if (param < 32) {
+        speed = param;
+      } else {
+        tempo = param;
+      }
+      note.effect = 0xf;
+      note.effect_parameter = scaled_speed();
+      break;
+    default:    // tremolo, sample offset
+      dropped_effects[effect]++;
+      break;
+  }
+  return note;
+}
+
+// the bar number for a packed bar: an identical bar's, or a new one (sharing
+// the data of any bar it is part of)
+static int add_bar(const uint8_t *buf, int length) {
+  for (int bar = 0; bar < num_bars; bar++) {
+    if (bar_lengths[bar] == length && !memcmp(&bar_data.data[bar_offsets[bar]], buf, length)) {
+      return bar;
+    }
+  }
+  if (num_bars == MAX_BARS) {
+    fail("too many different bars for the song player (at most 256)", "");
+  }
+  int offset = songpack_add_bar_data(&bar_data, buf, length);
+  if (offset < 0) {
+    fail("too much bar data for the song player's 16 bit bar offsets", "");
+  }
+  bar_offsets[num_bars] = offset;
+  bar_lengths[num_bars] = length;
+  return num_bars++;
+}
+
+// convert the patterns, in the order the song plays them, merging identical ones
+static void import_patterns() {
+  for (int p = 0; p < MOD_ORDERS; p++) {
+    pattern_number[p] = -1;
+  }
+  for (int pos = 0; pos < song_length; pos++) {
+    int p = order[pos];
+    if (pattern_number[p] >= 0) {
+      continue;
+    }
+    const uint8_t *pattern = &mod_patterns[p * MOD_ROWS * num_channels * 4];
+    struct songnote_expanded_t notes[SONGPLAYER_MUSIC_CHANNELS][MOD_ROWS];
+    for (int row = 0; row < MOD_ROWS; row++) {
+      for (int chan = 0; chan < num_channels; chan++) {
+        notes[chan][row] = convert_row(&channels[chan], &pattern[(row * num_channels + chan) * 4]);
+      }
+    }
+
+    uint8_t bars[SONGPLAYER_MUSIC_CHANNELS];
+    for (int chan = 0; chan < num_channels; chan++) {
+      uint8_t buf[SONGPACK_MAX_BAR_BYTES(MOD_ROWS)];
+      bars[chan] = add_bar(buf, songpack_pack_bar(notes[chan], MOD_ROWS, buf));
+    }
+    int match = -1;
+    for (int i = 0; i < num_song_patterns && match < 0; i++) {
+      if (!memcmp(song_patterns[i], bars, num_channels)) {
+        match = i;
+      }
+    }
+    if (match < 0) {
+      match = num_song_patterns++;
+      memcpy(song_patterns[match], bars, num_channels);
+    }
+    pattern_number[p] = match;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////
+// output
+///////////////////////////////////////////////////////////////////////
+
+static void print_field(const char *name, int value) {
+  if (value) {
+    printf(" %s = %d,", name, value);
+  }
+}
+
+static void print_bytes(const uint8_t *data, int length) {
+  for (int i = 0; i < length; i++) {
+    printf("%s0x%02x,", (i % 16) ? " " : "\n  ", data[i]);
+  }
+  printf("\n");
+}
+
+static void print_signed(const int8_t *data, int length) {
+  for (int i = 0; i < length; i++) {
+    printf("%s%d,", (i % 16) ? " " : "\n  ", data[i]);
+  }
+  printf("\n");
+}
+
+// writes the song, returning the flash it uses
+static int print_song(const char *name, const char *source) {
+  int flash = PACKED_SONG_SIZE + 16 * INSTRUMENT_SIZE + song_length
+              + num_song_patterns * num_channels + num_bars * sizeof(uint16_t) + bar_data.length;
+
+  printf("// imported from %s by tools/modimport - do not edit\n", source);
+  printf("#include <stddef.h>\n#include <songplayer/songplayer.h>\n\n");
+
+  for (int i = 0; i < 16; i++) {
+    const struct import_instrument_t *in = &instruments[i];
+    if (in->has_wavetable) {
+      printf("static const int8_t wavetable_%d[AUDIO_WAVETABLE_SIZE] = {", i);
+      print_signed(in->wavetable, AUDIO_WAVETABLE_SIZE);
+      printf("};\n\n");
+      flash += AUDIO_WAVETABLE_SIZE;
+    }
+    if (in->pcm) {
+      // (PCM samples are read a word at a time, so are word aligned and padded)
+      uint32_t length = (in->pcm->length + 3) & ~3;
+      int8_t *data = calloc(length, 1);
+      memcpy(data, in->pcm->data, in->pcm->length);
+      printf("static const int8_t sample_%d_data[%u] __attribute__((aligned(4))) = {", i, length);
+      print_signed(data, length);
+      printf("};\n\n");
+      printf("static const struct audio_sample_t sample_%d = {\n", i);
+      printf("  .data = sample_%d_data,\n  .length = %u,\n  .loop_start = 0,\n  .flags = 0,\n", i, length);
+      printf("  .rate = PCM_HZ_TO_RATE(%d)\n};\n\n", (int)lround(C2_RATE));
+      free(data);
+      flash += length + AUDIO_SAMPLE_SIZE;
+    }
+  }
+
+  printf("static const struct song_instrument_t instruments[16] = {\n");
+  for (int i = 0; i < 16; i++) {
+    const struct song_instrument_t *in = &instruments[i].in;
+    // (only the non-zero fields)
+    printf("  {");
+    print_field(".waveform_select", in->waveform_select);
+    print_field(".pulsewidth", in->pulsewidth);
+    print_field(".default_volume", in->default_volume);
+    print_field(".envelope_enable", in->envelope_enable ? 1 : 0);
+    print_field(".attack", in->attack);
+    print_field(".decay", in->decay);
+    print_field(".sustain", in->sustain);
+    print_field(".release", in->release);
+    if (instruments[i].has_wavetable) {
+      printf(" .wavetable = wavetable_%d,", i);
+    }
+    if (instruments[i].pcm) {
+      printf(" .sample = &sample_%d,", i);
+    }
+    printf(" },   // %d\n", i);
+  }
+  printf("};\n\n");
+
+  printf("static const uint8_t pattern_map[] = {");
+  for (int pos = 0; pos < song_length; pos++) {
+    printf("%s%d", pos ? ", " : " ", pattern_number[order[pos]]);
+  }
+  printf(" };\n\n");
+
+  printf("static const uint8_t patterns[] = {\n");
+  for (int pattern = 0; pattern < num_song_patterns; pattern++) {
+    printf(" ");
+    for (int chan = 0; chan < num_channels; chan++) {
+      printf(" %u,", song_patterns[pattern][chan]);
+    }
+    printf("   // %d\n", pattern);
+  }
+  printf("};\n\n");
+
+  printf("static const uint16_t bar_offsets[] = {");
+  for (int bar = 0; bar < num_bars; bar++) {
+    printf("%s%d,", (bar % 16) ? " " : "\n  ", bar_offsets[bar]);
+  }
+  printf("\n};\n\n");
+
+  printf("static const uint8_t bar_data[] = {");
+  print_bytes(bar_data.data, bar_data.length);
+  printf("};\n\n");
+
+  printf("const struct packed_song_t %s = {\n", name);
+  printf("  .rows_per_bar = %d,\n", MOD_ROWS);
+  printf("  .ticks_per_div = %d,\n", 6);
+  printf("  .num_channels = %d,\n", num_channels);
+  printf("  .song_length = %d,\n", song_length);
+  printf("  .num_bars = %d,\n", num_bars);
+  printf("  .instruments = instruments,\n");
+  printf("  .pattern_map = pattern_map,\n");
+  printf("  .patterns = patterns,\n");
+  printf("  .bar_offsets = bar_offsets,\n");
+  printf("  .bar_data = bar_data\n");
+  printf("};\n");
+  return flash;
+}
+
+static void usage(const char *name) {
+  fprintf(stderr, "usage: %s [-n song name] [-p] [-c] module.mod > song_packed.c\n"
+                  "  -p  play unpitched samples on the PCM voice, rather than as noise\n"
+                  "  -c  use the square/sawtooth/triangle waves, rather than wavetables\n", name);
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  const char *name = "song_mod";
+  int opt;
+  while ((opt = getopt(argc, argv, "n:pc")) != -1) {
+    switch (opt) {
+      case 'n': name = optarg; break;
+      case 'p': use_pcm = 1; break;
+      case 'c': use_wavetables = 0; break;
+      default: usage(argv[0]);
+    }
+  }
+  if (optind != argc - 1) {
+    usage(argv[0]);
+  }
+  const char *source = argv[optind];
+  const char *base = strrchr(source, '/');
+  base = base ? base + 1 : source;
+
+  load_mod(source);
+  import_instruments();
+  import_patterns();
+  int flash = print_song(name, base);
+
+  int num_instruments = 0;
+  for (int i = 1; i < 16; i++) {
+    num_instruments += instruments[i].used;
+  }
+  int num_mod_patterns = 0;
+  for (int p = 0; p < MOD_ORDERS; p++) {
+    num_mod_patterns += pattern_number[p] >= 0;
+  }
+  fprintf(stderr, "modimport: %s: %d channels, %d positions, %d patterns (from %d), %d bars (%d bytes of bar data), %d instruments\n",
+          name, num_channels, song_length, num_song_patterns, num_mod_patterns, num_bars, bar_data.length, num_instruments);
+  for (int effect = 0; effect < 16; effect++) {
+    if (dropped_effects[effect]) {
+      fprintf(stderr, "modimport: dropped %d %Xxx effects\n", dropped_effects[effect], effect);
+    }
+    if (dropped_extended[effect]) {
+      fprintf(stderr, "modimport: dropped %d E%Xx effects\n", dropped_extended[effect], effect);
+    }
+  }
+  fprintf(stderr, "modimport: %s uses %d bytes of flash (%.1f%% of 1MB)\n", name, flash, flash * 100.0 / FLASH_SIZE);
+  if (flash > FLASH_SIZE) {
+    fail("the song doesn't fit in flash", "");
+  }
+  return 0;
+}
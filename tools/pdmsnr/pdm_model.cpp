@@ -0,0 +1,128 @@
+#include "pdm_model.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <complex>
+#include <vector>
+
+#define CLOCK_HZ 16000000.0
+#define SAMPLE_CLOCKS 16          // the mixer's 1MHz sample rate
+#define DECIMATION 64             // 16MHz -> 250kHz, through a sinc^3 filter
+#define FFT_POINTS 65536          // at 250kHz, so 3.8Hz a bin
+#define SINE_BIN 262              // 999.5Hz, a whole number of cycles in the FFT
+#define BAND_HZ 15000.0
+#define WARMUP_CLOCKS 65536
+
+#define INTEGRATOR_BITS (PDM_SAMPLE_BITS + 4)
+#define INTEGRATOR_MAX ((1 << (INTEGRATOR_BITS - 1)) - 1)
+#define INTEGRATOR_MIN (-(1 << (INTEGRATOR_BITS - 1)))
+
+static int32_t saturate(int32_t x) {
+  return x > INTEGRATOR_MAX ? INTEGRATOR_MAX : x < INTEGRATOR_MIN ? INTEGRATOR_MIN : x;
+}
+
+int PdmModel::step(int32_t din) {
+  if (order_ == 2) {
+    int32_t feedback = out_bit_ ? PDM_FULL_SCALE : -PDM_FULL_SCALE;
+    integrator1_ = saturate(integrator1_ + din - feedback);
+    integrator2_ = saturate(integrator2_ + integrator1_ - feedback);
+    out_bit_ = integrator2_ >= 0;
+    return out_bit_;
+  }
+  uint32_t unsigned_din = (uint32_t)(din ^ PDM_FULL_SCALE) & ((1 << PDM_SAMPLE_BITS) - 1);
+  accumulator_ = (accumulator_ & ((1 << PDM_SAMPLE_BITS) - 1)) + unsigned_din;
+  return (accumulator_ >> PDM_SAMPLE_BITS) & 1;
+}
+
+double pdm_sine_hz() {
+  return SINE_BIN * CLOCK_HZ / DECIMATION / FFT_POINTS;
+}
+
+double pdm_band_hz() {
+  return BAND_HZ;
+}
+
+uint64_t pdm_warmup_clocks() {
+  return WARMUP_CLOCKS;
+}
+
+int32_t pdm_sine_input(double level, int sample_bits, uint64_t clock) {
+  uint64_t sample = clock / SAMPLE_CLOCKS;
+  double x = level * sin(2 * M_PI * pdm_sine_hz() * sample * SAMPLE_CLOCKS / CLOCK_HZ);
+  int32_t value = (int32_t)lround(x * ((1 << (sample_bits - 1)) - 1));
+  return value << (PDM_SAMPLE_BITS - sample_bits);    // eg. { 12 bit sample, 2'b0 }, as audio.v does
+}
+
+SnrMeter::SnrMeter() {
+  decimated_.reserve(FFT_POINTS);
+}
+
+// sinc^3 decimator (a CIC filter), in wrapping integer arithmetic
+void SnrMeter::add(int32_t sample) {
+  if (done()) {
+    return;
+  }
+  integrator_[0] += (uint64_t)(int64_t)sample;
+  integrator_[1] += integrator_[0];
+  integrator_[2] += integrator_[1];
+  if (++phase_ < DECIMATION) {
+    return;
+  }
+  phase_ = 0;
+  uint64_t x = integrator_[2];
+  for (int i = 0; i < 3; i++) {
+    uint64_t y = x - comb_[i];
+    comb_[i] = x;
+    x = y;
+  }
+  if (filled_ < 3) {
+    filled_++;                    // still filling the filter
+    return;
+  }
+  decimated_.push_back((double)(int64_t)x / ((double)PDM_FULL_SCALE * DECIMATION * DECIMATION * DECIMATION));
+}
+
+bool SnrMeter::done() const {
+  return decimated_.size() == FFT_POINTS;
+}
+
+static void fft(std::vector<std::complex<double>> &a) {
+  size_t n = a.size();
+  for (size_t i = 1, j = 0; i < n; i++) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) {
+      j ^= bit;
+    }
+    j ^= bit;
+    if (i < j) {
+      std::swap(a[i], a[j]);
+    }
+  }
+  for (size_t len = 2; len <= n; len <<= 1) {
+    std::complex<double> w = std::polar(1.0, -2 * M_PI / len);
+    for (size_t i = 0; i < n; i += len) {
+      std::complex<double> wn(1);
+      for (size_t k = 0; k < len / 2; k++) {
+        std::complex<double> u = a[i + k], v = a[i + k + len / 2] * wn;
+        a[i + k] = u + v;
+        a[i + k + len / 2] = u - v;
+        wn *= w;
+      }
+    }
+  }
+}
+
+// the sine is a whole number of cycles, so it falls in a single bin
+double SnrMeter::snr_db() const {
+  std::vector<std::complex<double>> a(decimated_.begin(), decimated_.end());
+  fft(a);
+  int band_bins = (int)(BAND_HZ * DECIMATION * FFT_POINTS / CLOCK_HZ);
+  double signal = std::norm(a[SINE_BIN]);
+  double noise = 0;
+  for (int i = 1; i <= band_bins; i++) {
+    if (i != SINE_BIN) {
+      noise += std::norm(a[i]);
+    }
+  }
+  return 10 * log10(signal / noise);
+}
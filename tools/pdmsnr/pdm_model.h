@@ -0,0 +1,59 @@
+/*
+ * Bit-accurate models of pdm_dac.v's two modulators, and the measurement
+ * pdmsnr makes of them: signal to noise ratio of a sine wave in the audio
+ * band, after decimating the 16MHz bitstream with a sinc filter.
+ */
+#ifndef PDM_MODEL_H
+#define PDM_MODEL_H
+
+#include <stdint.h>
+#include <vector>
+
+#define PDM_SAMPLE_BITS 14        // as audio.v drives them
+#define PDM_FULL_SCALE (1 << (PDM_SAMPLE_BITS - 1))
+
+// the DAC's input at a clock, for a sine at level (of full scale) : a
+// sample_bits sample (12 from the mixer), in the top of the DAC's 14 bits,
+// changing at 1MHz (every 16 clocks)
+int32_t pdm_sine_input(double level, int sample_bits, uint64_t clock);
+
+class PdmModel {
+ public:
+  explicit PdmModel(int order) : order_(order) {}
+
+  // clocks din in, and returns dout after the clock edge
+  int step(int32_t din);
+
+ private:
+  int order_;
+  uint32_t accumulator_ = 0;      // ORDER = 1
+  int32_t integrator1_ = 0;       // ORDER = 2
+  int32_t integrator2_ = 0;
+  int out_bit_ = 0;
+};
+
+// measures the SNR of a sine wave from samples at 16MHz, in +/- PDM_FULL_SCALE:
+// add() one every clock (after pdm_warmup_clocks()) until done()
+class SnrMeter {
+ public:
+  SnrMeter();
+  void add(int32_t sample);
+  bool done() const;
+  double snr_db() const;          // noise and distortion in the band, against the sine
+
+ private:
+  uint64_t integrator_[3] = {0, 0, 0};
+  uint64_t comb_[3] = {0, 0, 0};
+  uint32_t phase_ = 0;
+  uint32_t filled_ = 0;
+  std::vector<double> decimated_;
+};
+
+// clocks to let the modulators settle before measuring
+uint64_t pdm_warmup_clocks();
+
+// the sine's frequency, and the band the noise is measured in
+double pdm_sine_hz();
+double pdm_band_hz();
+
+#endif
@@ -0,0 +1,15 @@
+//
+// pdmsnr's testbench top: both of pdm_dac's modulators, fed the same samples,
+// for pdm_tb.cpp to check against the models in pdm_model.cpp.
+//
+
+module pdm_tb (
+  input clk,
+  input [13:0] din,
+  output dout_first_order,
+  output dout_second_order);
+
+  pdm_dac #(.SAMPLE_BITS(14), .ORDER(1)) first_order (.din(din), .clk(clk), .dout(dout_first_order));
+  pdm_dac #(.SAMPLE_BITS(14), .ORDER(2)) second_order (.din(din), .clk(clk), .dout(dout_second_order));
+
+endmodule
@@ -0,0 +1,74 @@
+/*
+ * pdmsnr - measures the signal to noise ratio of pdm_dac's first and
+ * second-order modulators (on bit-accurate models of them, pdm_model.cpp),
+ * for a 1kHz sine wave at a few levels, in a 15kHz band.
+ *
+ * The DACs are fed as audio.v feeds them: 12 bit samples from the mixer at
+ * 1MHz, in the top of the DACs' 14 bits (-b changes the sample size, up to
+ * 14 bits, to see the modulators on their own).  The "input" column is those
+ * samples measured the same way, without a modulator, which is the best any
+ * DAC could do with them.  The bitstream (or the input) is decimated by a
+ * sinc^3 filter to 250kHz, and the noise is everything but the sine in the
+ * band (so it includes any distortion and idle tones).
+ *
+ * See the Makefile for how to run it, and pdm_tb.cpp for checking the models
+ * against pdm_dac.v.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+
+#include "pdm_model.h"
+
+static const double default_levels[] = { 0.5, 0.1, 0.01, 0.001 };
+
+// order 0 measures the input itself
+static double measure(int order, double level, int sample_bits) {
+  PdmModel dac(order);
+  SnrMeter meter;
+  for (uint64_t clock = 0; !meter.done(); clock++) {
+    int32_t din = pdm_sine_input(level, sample_bits, clock);
+    int32_t out = order ? (dac.step(din) ? PDM_FULL_SCALE : -PDM_FULL_SCALE) : din;
+    if (clock >= pdm_warmup_clocks()) {
+      meter.add(out);
+    }
+  }
+  return meter.snr_db();
+}
+
+static void usage(const char *name) {
+  fprintf(stderr, "usage: %s [-b sample bits] [-l level]...\n", name);
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  std::vector<double> levels;
+  int sample_bits = 12;
+  int opt;
+  while ((opt = getopt(argc, argv, "b:l:")) != -1) {
+    switch (opt) {
+      case 'b': sample_bits = atoi(optarg); break;
+      case 'l': levels.push_back(atof(optarg)); break;
+      default: usage(argv[0]);
+    }
+  }
+  if (sample_bits < 2 || sample_bits > PDM_SAMPLE_BITS) {
+    usage(argv[0]);
+  }
+  if (levels.empty()) {
+    levels.assign(default_levels, default_levels + sizeof(default_levels) / sizeof(default_levels[0]));
+  }
+
+  printf("SNR of a %.1fHz sine in a %.0fHz band, from %d bit samples\n\n", pdm_sine_hz(), pdm_band_hz(), sample_bits);
+  printf("| Level (of full scale) | Input    | First-order | Second-order |\n");
+  printf("|-----------------------|----------|-------------|--------------|\n");
+  for (double level : levels) {
+    if (level <= 0 || level > 1) {
+      usage(argv[0]);
+    }
+    printf("| %-21g | %6.1fdB | %9.1fdB | %10.1fdB |\n", level,
+           measure(0, level, sample_bits), measure(1, level, sample_bits), measure(2, level, sample_bits));
+  }
+  return 0;
+}
@@ -0,0 +1,55 @@
+/*
+ * The packed bar encoder, shared by songpack and modimport (see encode.h).
+ */
+#include <string.h>
+
+#include "encode.h"
+
+int songpack_pack_bar(const struct songnote_expanded_t *notes, int rows, uint8_t *buf) {
+  int length = 0;
+  int empty_rows = 0;
+
+  for (int row = 0; row < rows; row++) {
+    const struct songnote_expanded_t *note = &notes[row];
+    uint8_t flags = 0;
+    if (note->instrument) flags |= SONG_ROW_INSTRUMENT;
+    if (note->new_note) flags |= SONG_ROW_NOTE;
+    if (note->volume) flags |= SONG_ROW_VOLUME;
+    if (note->effect || note->effect_parameter) flags |= SONG_ROW_EFFECT;
+
+    if (flags == 0) {
+      empty_rows++;
+      continue;
+    }
+    while (empty_rows > 0) {
+      int n = empty_rows > 127 ? 127 : empty_rows;
+      buf[length++] = SONG_ROW_SKIP | n;
+      empty_rows -= n;
+    }
+
+    buf[length++] = flags;
+    if (flags & SONG_ROW_INSTRUMENT) buf[length++] = note->instrument;
+    if (flags & SONG_ROW_NOTE) buf[length++] = note->new_note;
+    if (flags & SONG_ROW_VOLUME) buf[length++] = note->volume;
+    if (flags & SONG_ROW_EFFECT) {
+      buf[length++] = note->effect;
+      buf[length++] = note->effect_parameter;
+    }
+  }
+  buf[length++] = SONG_END_OF_BAR;
+  return length;
+}
+
+int songpack_add_bar_data(struct songpack_bar_data_t *bar_data, const uint8_t *buf, int length) {
+  for (int ofs = 0; ofs + length <= bar_data->length; ofs++) {
+    if (memcmp(&bar_data->data[ofs], buf, length) == 0) {
+      return ofs;
+    }
+  }
+  if (bar_data->length > SONGPACK_MAX_OFFSET) {
+    return -1;
+  }
+  memcpy(&bar_data->data[bar_data->length], buf, length);
+  bar_data->length += length;
+  return bar_data->length - length;
+}
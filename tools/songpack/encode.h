@@ -0,0 +1,34 @@
+/*
+ * The packed bar encoder, shared by songpack and modimport: packs bars into
+ * the row format the song player reads (see packed_song_t in songplayer.h),
+ * and collects them into the song's bar_data.
+ */
+#ifndef __SONGPACK_ENCODE_H__
+#define __SONGPACK_ENCODE_H__
+
+#include <stdint.h>
+
+#include <songplayer/songplayer.h>
+
+// the longest a bar of so many rows can pack to (6 bytes a row, and the end of bar)
+#define SONGPACK_MAX_BAR_BYTES(rows) ((rows) * 6 + 1)
+
+// bar_offsets are 16 bits, so bars have to start in the first 64KB of bar_data
+#define SONGPACK_MAX_OFFSET 0xffff
+#define SONGPACK_MAX_BAR_DATA (SONGPACK_MAX_OFFSET + 1 + SONGPACK_MAX_BAR_BYTES(255))
+
+struct songpack_bar_data_t {
+  uint8_t data[SONGPACK_MAX_BAR_DATA];
+  int length;
+};
+
+// pack a bar of rows notes into buf (SONGPACK_MAX_BAR_BYTES(rows) long),
+// returning its length in bytes
+int songpack_pack_bar(const struct songnote_expanded_t *notes, int rows, uint8_t *buf);
+
+// add a packed bar to bar_data, sharing the data of an identical bar (or
+// any run of bar data that matches) if there is one; returns its offset, or
+// -1 if it would start beyond SONGPACK_MAX_OFFSET
+int songpack_add_bar_data(struct songpack_bar_data_t *bar_data, const uint8_t *buf, int length);
+
+#endif
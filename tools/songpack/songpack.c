@@ -0,0 +1,177 @@
+/*
+ * songpack - converts a song_t (as written in a song .c file) into the
+ * packed_song_t format played by the song player.
+ *
+ * The song source is compiled into this program (with SONG defined as the
+ * name of the song_t variable), and the packed song is written to stdout
+ * as C source, with the same variable name.
+ *
+ * See the Makefile for how to run it.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <songplayer/songplayer.h>
+
+#include "encode.h"
+
+#ifndef SONG
+#error "SONG must be defined as the name of the song_t to convert"
+#endif
+
+#define STRINGIFY(x) #x
+#define TOSTRING(x) STRINGIFY(x)
+
+extern const struct song_t SONG;
+
+#define MAX_BARS 256
+
+static struct songpack_bar_data_t bar_data;
+static int bar_offsets[MAX_BARS];
+
+// add a bar to bar_data, returning its offset
+static int add_bar(const struct song_bar_t *bar) {
+  struct songnote_expanded_t notes[16];
+  uint8_t buf[SONGPACK_MAX_BAR_BYTES(16)];
+  for (int row = 0; row < 16; row++) {
+    notes[row] = bar->notes[row].note;
+  }
+  int offset = songpack_add_bar_data(&bar_data, buf, songpack_pack_bar(notes, 16, buf));
+  if (offset < 0) {
+    fprintf(stderr, "songpack: too much bar data for 16 bit bar offsets\n");
+    exit(1);
+  }
+  return offset;
+}
+
+static int bar_is_empty(const struct song_bar_t *bar) {
+  for (int row = 0; row < 16; row++) {
+    if (bar->notes[row].raw) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static void print_field(const char *name, int value) {
+  if (value) {
+    printf(" %s = %d,", name, value);
+  }
+}
+
+static void print_bytes(const uint8_t *data, int length) {
+  for (int i = 0; i < length; i++) {
+    printf("%s0x%02x,", (i % 16) ? " " : "\n  ", data[i]);
+  }
+  printf("\n");
+}
+
+int main(int argc, char **argv) {
+  const struct song_t *song = &SONG;
+  const char *name = TOSTRING(SONG);
+  const char *source = (argc > 1) ? argv[1] : "a song_t";
+
+  // patterns used by the song, and bars used by them (or by sound effects;
+  // every bar up to the last non-empty one is kept)
+  int num_patterns = 0;
+  for (int pos = 0; pos < song->song_length; pos++) {
+    if (song->pattern_map[pos] + 1 > num_patterns) {
+      num_patterns = song->pattern_map[pos] + 1;
+    }
+  }
+  int num_bars = 0;
+  for (int bar = 0; bar < MAX_BARS; bar++) {
+    if (!bar_is_empty(&song->bars[bar])) {
+      num_bars = bar + 1;
+    }
+  }
+  for (int pattern = 0; pattern < num_patterns; pattern++) {
+    for (int chan = 0; chan < SONGPLAYER_MUSIC_CHANNELS; chan++) {
+      if (song->patterns[pattern].bar[chan] + 1 > num_bars) {
+        num_bars = song->patterns[pattern].bar[chan] + 1;
+      }
+    }
+  }
+  for (int bar = 0; bar < num_bars; bar++) {
+    bar_offsets[bar] = add_bar(&song->bars[bar]);
+  }
+
+  printf("// packed from %s by tools/songpack - do not edit\n", source);
+  printf("#include <stddef.h>\n#include <songplayer/songplayer.h>\n\n");
+
+  printf("static const struct song_instrument_t instruments[16] = {\n");
+  for (int i = 0; i < 16; i++) {
+    const struct song_instrument_t *in = &song->instruments[i];
+    if (in->sample || in->wavetable) {
+      fprintf(stderr, "songpack: instrument %d uses a sample or wavetable; set it in the packed song by hand\n", i);
+    }
+    // (only the non-zero fields)
+    printf("  {");
+    print_field(".waveform_select", in->waveform_select);
+    print_field(".ringmod", in->ringmod);
+    print_field(".sync", in->sync);
+    print_field(".pulsewidth", in->pulsewidth);
+    print_field(".pulsewidth_modulation_depth", in->pulsewidth_modulation_depth);
+    print_field(".pulsewidth_modulation_speed", in->pulsewidth_modulation_speed);
+    print_field(".vibrato_depth", in->vibrato_depth);
+    print_field(".vibrato_speed", in->vibrato_speed);
+    print_field(".default_volume", in->default_volume);
+    print_field(".volume_rampdown_rate", in->volume_rampdown_rate);
+    print_field(".envelope_enable", in->envelope_enable ? 1 : 0);
+    print_field(".attack", in->attack);
+    print_field(".decay", in->decay);
+    print_field(".sustain", in->sustain);
+    print_field(".release", in->release);
+    print_field(".pan", in->pan);
+    printf(" },   // %d\n", i);
+  }
+  printf("};\n\n");
+
+  printf("static const uint8_t pattern_map[] = {");
+  for (int pos = 0; pos < song->song_length; pos++) {
+    printf("%s%d", pos ? ", " : " ", song->pattern_map[pos]);
+  }
+  printf(" };\n\n");
+
+  printf("static const uint8_t patterns[] = {\n");
+  for (int pattern = 0; pattern < num_patterns; pattern++) {
+    printf(" ");
+    for (int chan = 0; chan < SONGPLAYER_MUSIC_CHANNELS; chan++) {
+      printf(" %u,", song->patterns[pattern].bar[chan]);
+    }
+    printf("   // %d\n", pattern);
+  }
+  printf("};\n\n");
+
+  printf("static const uint16_t bar_offsets[] = {");
+  for (int bar = 0; bar < num_bars; bar++) {
+    printf("%s%d,", (bar % 16) ? " " : "\n  ", bar_offsets[bar]);
+  }
+  printf("\n};\n\n");
+
+  printf("static const uint8_t bar_data[] = {");
+  print_bytes(bar_data.data, bar_data.length);
+  printf("};\n\n");
+
+  printf("const struct packed_song_t %s = {\n", name);
+  printf("  .rows_per_bar = %d,\n", song->rows_per_bar);
+  printf("  .ticks_per_div = %d,\n", song->ticks_per_div);
+  printf("  .num_channels = %d,\n", SONGPLAYER_MUSIC_CHANNELS);
+  printf("  .song_length = %d,\n", song->song_length);
+  printf("  .num_bars = %d,\n", num_bars);
+  printf("  .instruments = instruments,\n");
+  printf("  .pattern_map = pattern_map,\n");
+  printf("  .patterns = patterns,\n");
+  printf("  .bar_offsets = bar_offsets,\n");
+  printf("  .bar_data = bar_data\n");
+  printf("};\n");
+
+  int packed_size = sizeof(struct packed_song_t) + 16 * sizeof(struct song_instrument_t)
+                    + song->song_length + num_patterns * SONGPLAYER_MUSIC_CHANNELS
+                    + num_bars * sizeof(uint16_t) + bar_data.length;
+  fprintf(stderr, "songpack: %s: %d bars (%d bytes of bar data), %d patterns; %d bytes, down from %d\n",
+          name, num_bars, bar_data.length, num_patterns, packed_size, (int)sizeof(struct song_t));
+  return 0;
+}
@@ -0,0 +1,377 @@
+/*
+ * Bit-accurate model of hdl/picosoc/audio/audio.v; see audio_model.h.
+ * Names follow the Verilog, and each pipeline step is done in the same
+ * order as the hardware does it.
+ */
+#include "audio_model.h"
+
+// sign extend the low bits of x
+static inline int32_t sext(uint32_t x, int bits) {
+  return (int32_t)(x << (32 - bits)) >> (32 - bits);
+}
+
+static int clog2(int n) {
+  int bits = 0;
+  while ((1 << bits) < n) {
+    bits++;
+  }
+  return bits;
+}
+
+// attack: time taken to ramp from 0 to full scale (2ms .. 8s)
+static const uint32_t attack_step[16] = {
+  8389, 2097, 1049, 699, 442, 300, 247, 210, 168, 67, 34, 21, 17, 6, 3, 2
+};
+
+// decay/release: time taken to fall from full scale to 0 (6ms .. 24s)
+static const uint32_t decay_step[16] = {
+  2796, 699, 350, 233, 147, 100, 82, 70, 56, 22, 11, 7, 6, 2, 1, 1
+};
+
+// integer part of a filter state, saturated to a 12 bit sample
+static int32_t filter_sample(int32_t state) {
+  int32_t top = state >> 19;
+  if (top == 0 || top == -1) {
+    return sext((uint32_t)state >> 8, 12);
+  }
+  return (state < 0) ? -2048 : 2047;
+}
+
+// a scaled mix, saturated to 12 bits
+static int32_t saturate_mix(int32_t sum) {
+  return (sum < -2048) ? -2048 : (sum > 2047) ? 2047 : sum;
+}
+
+// LFO triangle wave from its phase, as -1024..1023
+static int32_t lfo_wave(uint32_t phase) {
+  uint32_t triangle = (phase >> 7) & 0x7ff;
+  if (phase & (1 << 18)) {
+    triangle ^= 0x7ff;
+  }
+  return (int32_t)triangle - 1024;
+}
+
+AudioModel::AudioModel(const Options &options)
+  : options(options), num_voices(options.num_voices < MAX_VOICES ? options.num_voices : MAX_VOICES) {
+  mix_bits = 12 + clog2(num_voices + (options.pcm ? 1 : 0));
+  pan_mix_bits = mix_bits + 1;
+
+  bank[num_voices * 8 + REG_GLOBAL_VOLUME] = 0xff;
+  for (int voice = 0; voice < num_voices; voice++) {
+    lfsr[voice] = 0x3724ab;   // 23'b01101110010010000101011
+    env_state[voice] = ENV_RELEASE;
+  }
+}
+
+void AudioModel::write(uint32_t offset, uint32_t value, uint32_t bytes) {
+  pending.push_back({ offset, value, bytes });
+}
+
+uint32_t AudioModel::read(uint32_t offset) const {
+  bool global_addr = offset & 0x200;
+  if (offset & 0x800 || (offset & 0x600) == 0x600) {
+    return 0;   // (the sequencer isn't modelled)
+  }
+  if ((offset & 0x600) == 0x400 || ((offset >> 2) & 7) != REG_STATUS) {
+    return 0;
+  }
+  if (global_addr) {
+    return ((uint32_t)(mixed_right & 0xffff) << 16) | (mixed_left & 0xffff);
+  }
+  int voice = (offset >> 5) & 15;
+  if (voice >= num_voices) {
+    return 0;
+  }
+  uint32_t gate = (bank[voice * 8 + REG_ENVELOPE] >> 17) & 1;
+  return ((accumulator[voice] >> 8) << 16) | (gate << 15)
+         | (env_state[voice] << 8) | (env_level[voice] >> 16);
+}
+
+void AudioModel::apply(const Write &write) {
+  uint32_t offset = write.offset & 0xfff;
+  uint32_t lane = offset & 3;
+  uint32_t strobe = (write.bytes == 4) ? 0xf : (write.bytes == 2) ? (3 << (lane & 2)) : (1 << lane);
+  uint32_t data = (write.bytes == 4) ? write.value
+                : (write.bytes == 2) ? (write.value & 0xffff) * 0x00010001
+                : (write.value & 0xff) * 0x01010101;
+
+  if (on_write) {
+    on_write(step_count, write);
+  }
+
+  if (offset & 0x800 || (offset & 0x600) == 0x600) {
+    return;   // sequencer (or unmapped)
+  }
+  if ((offset & 0x600) == 0x400) {
+    if (options.wavetable) {
+      wavetable[offset & 0x1ff] = (data >> (8 * lane)) & 0xff;
+    }
+    return;
+  }
+
+  bool global_addr = offset & 0x200;
+  uint32_t reg = global_addr ? num_voices * 8 + ((offset >> 2) & 7) : (offset >> 2) & 0x7f;
+  bool valid = global_addr ? ((offset >> 2) & 7) < (uint32_t)NUM_GLOBAL_REGS : reg < (uint32_t)num_voices * 8;
+  if (!valid) {
+    return;
+  }
+  for (int byte = 0; byte < 4; byte++) {
+    if (strobe & (1 << byte)) {
+      bank[reg] = (bank[reg] & ~(0xffu << (8 * byte))) | (data & (0xffu << (8 * byte)));
+    }
+  }
+
+  if (!global_addr && (reg & 7) == REG_ENVELOPE && (strobe & 4) && (data & (1 << 17))) {
+    env_trigger[reg >> 3] ^= 1;
+  }
+  if (global_addr && reg == (uint32_t)num_voices * 8 + REG_PCM_CTRL && (strobe & 4) && (data & (1 << 16)) && options.pcm) {
+    // (re)start the sample
+    uint32_t length = global(REG_PCM_LENGTH) & 0xfffffc;
+    bool pcm_4bit = global(REG_PCM_CTRL) & (1 << 8);
+    pcm_play_remaining = pcm_4bit ? length << 1 : length;
+    pcm_position = 0;
+    pcm_phase = 0;
+    pcm_sample = 0;
+    pcm_playing = (length != 0);
+  }
+}
+
+// one voice's sample (before panning), and its accumulator, LFSR, sync and envelope updates
+int32_t AudioModel::voice_step(int voice, uint8_t wavetable_sample) {
+  const uint32_t *regs = &bank[voice * 8];
+  uint32_t acc = accumulator[voice];
+  uint32_t wave_params = regs[REG_WAVEPARAMS];
+  int source = (voice == 0) ? num_voices - 1 : voice - 1;
+
+  uint32_t freq_increment = (regs[REG_FREQ] + (uint32_t)lfo_vibrato_offset[voice]) & 0xffffff;
+  int32_t pulse_width_modulated = (int32_t)(regs[REG_PULSEWIDTH] & 0xfff) + lfo_pwm_offset[voice];
+  uint32_t pulse_width = (pulse_width_modulated < 0) ? 0 : (pulse_width_modulated > 0xfff) ? 0xfff : pulse_width_modulated;
+  bool ringmod_enable = wave_params & (1 << 24);
+  bool sync_enable = wave_params & (1 << 25);
+
+  // tone generation: the AND of the selected waveforms
+  uint32_t wave = 0xfff;
+  if (wave_params & (1 << 20)) {
+    wave &= ((wavetable_sample ^ 0x80) & 0xff) << 4;
+  }
+  if (wave_params & (1 << 19)) {
+    uint32_t l = lfsr[voice];
+    wave &= (((l >> 22) & 1) << 11) | (((l >> 20) & 1) << 10) | (((l >> 16) & 1) << 9) | (((l >> 13) & 1) << 8)
+          | (((l >> 11) & 1) << 7) | (((l >> 7) & 1) << 6) | (((l >> 4) & 1) << 5) | (((l >> 2) & 1) << 4);
+  }
+  if (wave_params & (1 << 18)) {
+    wave &= ((acc >> 12) <= pulse_width) ? 0xfff : 0;
+  }
+  if (wave_params & (1 << 17)) {
+    wave &= acc >> 12;
+  }
+  if (wave_params & (1 << 16)) {
+    bool invert = ((acc >> 23) & 1) ^ (ringmod_enable && ringmod_bit[source]);
+    uint32_t triangle = (acc >> 11) & 0xfff;
+    wave &= invert ? triangle ^ 0xfff : triangle;
+  }
+  int32_t unscaled = sext(wave ^ 0x800, 12);
+
+  uint32_t envelope_params = regs[REG_ENVELOPE];
+  bool envelope_enable = envelope_params & (1 << 16);
+  int32_t volume = envelope_enable ? env_volume[voice] : (regs[REG_VOLUME] & 0xff);
+  int32_t scaled = (unscaled * volume) >> 8;
+
+  // accumulator (or reset, if synced to a source that has just wrapped)
+  uint32_t next = (acc + freq_increment) & 0xffffff;
+  if ((acc & (1 << 19)) && !(prev_accumulator[voice] & (1 << 19))) {
+    uint32_t l = lfsr[voice];
+    lfsr[voice] = ((l << 1) | (((l >> 22) ^ (l >> 17)) & 1)) & 0x7fffff;
+  }
+  prev_accumulator[voice] = acc;
+  accumulator[voice] = (sync_enable && sync_bit[source]) ? 0 : next;
+  ringmod_bit[voice] = (acc >> 23) & 1;
+  sync_bit[voice] = !((acc >> 23) & 1) && ((next >> 23) & 1);
+
+  // envelope
+  uint32_t level = env_level[voice];
+  uint32_t sustain = (envelope_params >> 8) & 0xf;
+  uint32_t sustain_level = (sustain << 20) | (sustain << 16);
+  uint32_t release_step = decay_step[(envelope_params >> 12) & 0xf];
+  uint32_t voice_decay_step = decay_step[(envelope_params >> 4) & 0xf];
+  bool gate = envelope_params & (1 << 17);
+
+  if (env_trigger[voice] != env_trigger_ack[voice]) {
+    env_trigger_ack[voice] = env_trigger[voice];
+    env_state[voice] = ENV_ATTACK;
+  } else if (!gate || env_state[voice] == ENV_RELEASE) {
+    env_state[voice] = ENV_RELEASE;
+    env_level[voice] = (level > release_step) ? level - release_step : 0;
+  } else {
+    switch (env_state[voice]) {
+      case ENV_ATTACK: {
+        uint32_t attack_level = level + attack_step[envelope_params & 0xf];
+        if (attack_level & (1 << 24)) {
+          env_level[voice] = 0xffffff;
+          env_state[voice] = ENV_DECAY;
+        } else {
+          env_level[voice] = attack_level;
+        }
+        break;
+      }
+      case ENV_DECAY:
+        if (level <= sustain_level + voice_decay_step) {
+          env_level[voice] = sustain_level;
+          env_state[voice] = ENV_SUSTAIN;
+        } else {
+          env_level[voice] = level - voice_decay_step;
+        }
+        break;
+      default:
+        env_level[voice] = sustain_level;
+        break;
+    }
+  }
+  return scaled;
+}
+
+// add a sample to the filter input, or (panned) to the left/right mix
+void AudioModel::mix(int32_t sample, bool filter_route, uint32_t pan) {
+  sample = sext(sample, mix_bits);
+  if (filter_route) {
+    tmp_filter_input = sext(tmp_filter_input + sample, mix_bits);
+    return;
+  }
+  // right gets sample * (8 + pan) / 8, saturated; left the remainder
+  uint32_t right_gain = (pan & 0x10) ? (((pan & 0xf) < 8) ? 0 : (pan + 8) & 0x1f)
+                                     : ((pan & 0x8) ? 16 : pan + 8);
+  int32_t right = sext((sample * (int32_t)right_gain) >> 3, pan_mix_bits);
+  int32_t left = sext((sample << 1) - right, pan_mix_bits);
+  tmp_mixed_left = sext(tmp_mixed_left + left, pan_mix_bits);
+  tmp_mixed_right = sext(tmp_mixed_right + right, pan_mix_bits);
+}
+
+void AudioModel::pcm_step() {
+  uint32_t ctrl = global(REG_PCM_CTRL);
+  bool pcm_enable = ctrl & (1 << 16);
+  bool pcm_4bit = ctrl & (1 << 8);
+  int32_t volume = (pcm_playing && pcm_enable) ? (ctrl & 0xff) : 0;
+  mix((sext(pcm_sample << 4, 12) * volume) >> 8, options.filter && (ctrl & (1 << 9)), (ctrl >> 24) & 0x1f);
+
+  if (pcm_playing && pcm_enable) {
+    uint32_t next_phase = pcm_phase + (global(REG_PCM_RATE) & 0xffff);
+    pcm_phase = next_phase & 0xffff;
+    if (next_phase & 0x10000) {
+      uint32_t start = global(REG_PCM_START) & 0xfffffc;
+      uint32_t length = global(REG_PCM_LENGTH) & 0xfffffc;
+      uint32_t loop_start = global(REG_PCM_LOOP) & 0xfffffc;
+      bool loop_enable = (global(REG_PCM_LOOP) & 0x80000000) && loop_start < length;
+
+      // the FIFO holds the sample data from the start, then from the loop start over and over
+      uint32_t byte = pcm_position >> 1;
+      if (loop_enable && byte >= length) {
+        byte = loop_start + (byte - length) % (length - loop_start);
+      }
+      uint8_t data = flash_read ? flash_read((start + byte) & 0xffffff) : 0;
+      if (pcm_4bit) {
+        pcm_sample = (((pcm_position & 1) ? data >> 4 : data) & 0x0f) << 4;
+        pcm_position += 1;
+      } else {
+        pcm_sample = data;
+        pcm_position += 2;
+      }
+      if (!loop_enable) {
+        pcm_play_remaining--;
+        if (pcm_play_remaining == 0) {
+          pcm_playing = false;
+        }
+      }
+    }
+  }
+}
+
+// Chamberlin state-variable filter, on the voices routed through it
+void AudioModel::filter_steps() {
+  uint32_t filter = global(REG_FILTER);
+  int32_t cutoff = filter & 0xff;
+  int32_t damping = (255 - ((filter >> 8) & 0xf) * 14) & 0xff;
+  int32_t filter_input = saturate_mix(tmp_filter_input >> MIX_SHIFT);
+
+  filter_lowpass = sext(filter_lowpass + ((filter_sample(filter_bandpass) * cutoff) >> 4), 22);
+  filter_highpass = sext((filter_input << 8) - filter_lowpass - ((filter_sample(filter_bandpass) * damping) << 1), 22);
+  filter_bandpass = sext(filter_bandpass + ((filter_sample(filter_highpass) * cutoff) >> 4), 22);
+}
+
+// envelope volume and LFOs, for one voice a step at a time
+void AudioModel::aux_step_run() {
+  const uint32_t *regs = &bank[aux_voice * 8];
+  uint32_t lfo = regs[REG_LFO];
+
+  switch (aux_step) {
+    case AUX_ENVELOPE:
+      env_volume[aux_voice] = (((env_level[aux_voice] >> 16) & 0xff) * (regs[REG_VOLUME] & 0xff)) >> 8;
+      break;
+    case AUX_VIBRATO_DEPTH:
+      lfo_vibrato_mod = sext((lfo_wave(lfo_vibrato_phase[aux_voice]) * (int32_t)(lfo & 0xff)) >> 10, 9);
+      lfo_vibrato_phase[aux_voice] = (lfo_vibrato_phase[aux_voice] + ((lfo >> 8) & 0xff)) & 0x7ffff;
+      break;
+    case AUX_VIBRATO: {
+      uint32_t freq = regs[REG_FREQ] & 0xffffff;
+      int32_t freq_scaled = (freq >> 18) ? 0x7ff : (freq >> 7) & 0x7ff;
+      lfo_vibrato_offset[aux_voice] = sext((freq_scaled * lfo_vibrato_mod) >> 4, 17);
+      break;
+    }
+    default:
+      lfo_pwm_offset[aux_voice] = sext((lfo_wave(lfo_pwm_phase[aux_voice]) * (int32_t)((lfo >> 16) & 0xff)) >> 7, 12);
+      lfo_pwm_phase[aux_voice] = (lfo_pwm_phase[aux_voice] + (lfo >> 24)) & 0x7ffff;
+      aux_voice = (aux_voice == num_voices - 1) ? 0 : aux_voice + 1;
+      break;
+  }
+  aux_step = (aux_step + 1) & 3;
+}
+
+// the mix (and filter output), scaled by the global volume
+int32_t AudioModel::global_step(int32_t tmp_mixed) {
+  int32_t filter_output = 0;
+  if (options.filter) {
+    uint32_t filter = global(REG_FILTER);
+    int32_t filter_mix = ((filter & (1 << 16)) ? filter_lowpass : 0)
+                       + ((filter & (1 << 17)) ? filter_bandpass : 0)
+                       + ((filter & (1 << 18)) ? filter_highpass : 0);
+    filter_output = filter_sample(sext(filter_mix, 22));
+  }
+  int32_t sum = (tmp_mixed >> MIX_SHIFT) + filter_output;
+  int32_t scaled = (saturate_mix(sum) * (int32_t)(global(REG_GLOBAL_VOLUME) & 0xff)) >> 8;
+  return sext((scaled & 0xfff) << 2, 14);
+}
+
+void AudioModel::step() {
+  // a write landing in the idle clock; the wavetable read for voice 0 has
+  // already been made by then
+  uint8_t wavetable_sample = wavetable[accumulator[0] >> 19];
+  if (!pending.empty()) {
+    apply(pending.front());
+    pending.pop_front();
+  }
+
+  tmp_mixed_left = 0;
+  tmp_mixed_right = 0;
+  tmp_filter_input = 0;
+
+  for (int voice = 0; voice < num_voices; voice++) {
+    // (the next voice's wavetable sample is read while this one is processed)
+    uint8_t next_wavetable_sample = (voice + 1 < num_voices) ? wavetable[((voice + 1) << 5) | (accumulator[voice + 1] >> 19)] : 0;
+    if (!options.wavetable) {
+      wavetable_sample = 0;
+    }
+    int32_t sample = voice_step(voice, wavetable_sample);
+    uint32_t mix_reg = bank[voice * 8 + REG_MIX];
+    mix(sample, options.filter && (mix_reg & 1), (mix_reg >> 8) & 0x1f);
+    wavetable_sample = next_wavetable_sample;
+  }
+  if (options.pcm) {
+    pcm_step();
+  }
+  if (options.filter) {
+    filter_steps();
+  }
+  aux_step_run();
+  mixed_left = global_step(tmp_mixed_left);
+  mixed_right = global_step(tmp_mixed_right);
+  step_count++;
+}
@@ -0,0 +1,118 @@
+/*
+ * A bit-accurate model of the audio peripheral (hdl/picosoc/audio/audio.v),
+ * stepped one accumulator clock (1us, one pass of the voice pipeline) at a
+ * time: the accumulators, noise LFSRs, the AND of the selected waveforms,
+ * ring modulation and sync, the ADSR envelopes and LFOs (in the aux step),
+ * volume scaling, panning, the state-variable filter and the global volume,
+ * all with the hardware's widths, rounding and saturation.
+ *
+ * Register writes are queued, and land one per microsecond in the pipeline's
+ * idle clock, as they would from the CPU.  The sequencer isn't modelled, and
+ * the PCM voice reads its samples straight from flash_read (the hardware's
+ * FIFO never runs dry at the rates it supports, so this doesn't change what
+ * it plays).
+ */
+#ifndef __AUDIO_MODEL_H__
+#define __AUDIO_MODEL_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <functional>
+
+class AudioModel {
+public:
+  // the hardware options (see DEFINES in hdl/Makefile)
+  struct Options {
+    int num_voices = 8;
+    bool pcm = true;          // audio_pcm
+    bool filter = true;       // audio_filter
+    bool wavetable = true;    // audio_wavetable
+  };
+
+  struct Write {
+    uint32_t offset;          // byte offset into the peripheral
+    uint32_t value;
+    uint32_t bytes;           // 4, 2 for a half word write, or 1 for a byte write
+  };
+
+  AudioModel() : AudioModel(Options()) {}
+  explicit AudioModel(const Options &options);
+
+  void write(uint32_t offset, uint32_t value, uint32_t bytes);
+  uint32_t read(uint32_t offset) const;
+
+  // run the voice pipeline once (1us), after the next queued write (if any)
+  void step();
+
+  // the samples sent to the DACs by the last step (14 bit signed)
+  int32_t left() const { return mixed_left; }
+  int32_t right() const { return mixed_right; }
+
+  uint64_t steps() const { return step_count; }
+  size_t writes_pending() const { return pending.size(); }
+
+  // called with each write as it lands, and the step it lands before
+  std::function<void(uint64_t step, const Write &write)> on_write;
+
+  // the PCM voice's view of the SPI flash
+  std::function<uint8_t(uint32_t address)> flash_read;
+
+private:
+  enum { REG_FREQ, REG_PULSEWIDTH, REG_WAVEPARAMS, REG_VOLUME, REG_ENVELOPE, REG_LFO, REG_MIX, REG_STATUS };
+  enum { REG_GLOBAL_VOLUME, REG_PCM_START, REG_PCM_LENGTH, REG_PCM_LOOP, REG_PCM_RATE, REG_PCM_CTRL, REG_FILTER };
+  enum { ENV_ATTACK, ENV_DECAY, ENV_SUSTAIN, ENV_RELEASE };
+  enum { AUX_ENVELOPE, AUX_VIBRATO_DEPTH, AUX_VIBRATO, AUX_PWM };
+  static const int NUM_GLOBAL_REGS = 7;
+  static const int MAX_VOICES = 16;
+  static const int MIX_SHIFT = 2;     // the mix is scaled down as the original 4 voice mixer's was
+
+  void apply(const Write &write);
+  uint32_t global(int reg) const { return bank[num_voices * 8 + reg]; }
+  int32_t voice_step(int voice, uint8_t wavetable_sample);
+  void pcm_step();
+  void mix(int32_t sample, bool filter_route, uint32_t pan);
+  void filter_steps();
+  void aux_step_run();
+  int32_t global_step(int32_t tmp_mixed);
+
+  Options options;
+  int num_voices;
+  int mix_bits;
+  int pan_mix_bits;
+
+  std::deque<Write> pending;
+  uint64_t step_count = 0;
+
+  uint32_t bank[MAX_VOICES * 8 + NUM_GLOBAL_REGS] = {};
+  uint8_t wavetable[512] = {};
+
+  // voices
+  uint32_t accumulator[MAX_VOICES] = {}, prev_accumulator[MAX_VOICES] = {}, lfsr[MAX_VOICES] = {};
+  uint8_t ringmod_bit[MAX_VOICES] = {}, sync_bit[MAX_VOICES] = {};
+  uint32_t env_level[MAX_VOICES] = {};
+  uint8_t env_state[MAX_VOICES] = {}, env_volume[MAX_VOICES] = {}, env_trigger[MAX_VOICES] = {}, env_trigger_ack[MAX_VOICES] = {};
+
+  // LFOs
+  uint32_t lfo_vibrato_phase[MAX_VOICES] = {}, lfo_pwm_phase[MAX_VOICES] = {};
+  int32_t lfo_vibrato_offset[MAX_VOICES] = {}, lfo_pwm_offset[MAX_VOICES] = {};
+  int32_t lfo_vibrato_mod = 0;
+  int aux_voice = 0;
+  int aux_step = AUX_ENVELOPE;
+
+  // PCM voice
+  bool pcm_playing = false;
+  int32_t pcm_sample = 0;
+  uint32_t pcm_phase = 0;
+  uint32_t pcm_play_remaining = 0;
+  uint32_t pcm_position = 0;          // in nibbles, from the start of the sample
+
+  // filter (14.8 fixed point)
+  int32_t filter_lowpass = 0, filter_bandpass = 0, filter_highpass = 0;
+
+  // mixer
+  int32_t tmp_mixed_left = 0, tmp_mixed_right = 0, tmp_filter_input = 0;
+  int32_t mixed_left = 0, mixed_right = 0;
+};
+
+#endif
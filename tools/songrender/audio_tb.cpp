@@ -0,0 +1,165 @@
+/*
+ * Checks the audio model against audio.v: plays a songrender trace (-t)
+ * into audio.v in Verilator, landing each register write in the idle clock
+ * before the pipeline pass the model applied it in, and compares the
+ * samples sent to the DACs after every pass with the ones the model made.
+ *
+ * Built and run by "make verify".
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <vector>
+
+#include "Vaudio_tb.h"
+#include "verilated.h"
+
+// pipeline steps with 8 voices, the PCM voice and the filter
+#define STEP_GLOBAL_RIGHT 14
+#define STEP_IDLE 15
+
+#define MAX_MISMATCHES_SHOWN 10
+
+struct TraceWrite {
+  uint64_t step;
+  uint32_t offset, value, bytes;
+};
+
+struct TraceSample {
+  int32_t left, right;
+};
+
+static std::map<uint32_t, uint8_t> flash;
+static std::vector<TraceWrite> writes;
+static std::vector<TraceSample> samples;
+
+static int32_t sext14(uint32_t x) {
+  return (int32_t)(x << 18) >> 18;
+}
+
+static bool read_trace(const char *name) {
+  FILE *f = fopen(name, "r");
+  if (!f) {
+    perror(name);
+    return false;
+  }
+  char line[64];
+  int c;
+  while ((c = fgetc(f)) != EOF) {
+    if (c == 'f') {
+      uint32_t address, byte;
+      if (fscanf(f, "%x", &address) != 1) {
+        break;
+      }
+      while ((c = fgetc(f)) == ' ' && fscanf(f, "%x", &byte) == 1) {
+        flash[address++] = byte;
+      }
+    } else if (c == 'w') {
+      TraceWrite write;
+      unsigned long long step;
+      if (fscanf(f, "%llu %x %x %u", &step, &write.offset, &write.value, &write.bytes) != 4) {
+        break;
+      }
+      write.step = step;
+      writes.push_back(write);
+    } else if (c == 's') {
+      unsigned long long step;
+      TraceSample sample;
+      if (fscanf(f, "%llu %d %d", &step, &sample.left, &sample.right) != 3 || step != samples.size()) {
+        break;
+      }
+      samples.push_back(sample);
+    } else if (c != '\n' && !fgets(line, sizeof(line), f)) {
+      break;
+    }
+  }
+  fclose(f);
+  return true;
+}
+
+static uint32_t flash_word(uint32_t address) {
+  uint32_t word = 0;
+  for (int i = 0; i < 4; i++) {
+    auto byte = flash.find(address + i);
+    word |= (uint32_t)(byte == flash.end() ? 0 : byte->second) << (8 * i);
+  }
+  return word;
+}
+
+int main(int argc, char **argv) {
+  Verilated::commandArgs(argc, argv);
+  if (argc < 2 || !read_trace(argv[argc - 1])) {
+    fprintf(stderr, "usage: %s trace\n", argv[0]);
+    return 1;
+  }
+
+  Vaudio_tb *tb = new Vaudio_tb;
+  tb->resetn = 0;
+  for (int i = 0; i < 32; i++) {
+    tb->clk = 0;
+    tb->eval();
+    tb->clk = 1;
+    tb->eval();
+  }
+  tb->resetn = 1;
+
+  uint64_t passes = 0, mismatches = 0;
+  size_t next_write = 0;
+  int prev_step = tb->pipeline_step;
+  bool dma_pending = false;
+  uint32_t dma_address = 0;
+
+  while (passes < samples.size()) {
+    tb->clk = 0;
+    if (!tb->iomem_valid && !tb->iomem_ready && tb->pipeline_step == STEP_IDLE
+        && next_write < writes.size() && writes[next_write].step == passes) {
+      const TraceWrite &write = writes[next_write];
+      uint32_t lane = write.offset & 3;
+      tb->iomem_valid = 1;
+      tb->iomem_addr = 0x04000000 | (write.offset & ~3);
+      tb->iomem_wstrb = (write.bytes == 4) ? 0xf : (write.bytes == 2) ? (3 << (lane & 2)) : (1 << lane);
+      tb->iomem_wdata = (write.bytes == 4) ? write.value
+                      : (write.bytes == 2) ? (write.value & 0xffff) * 0x00010001
+                      : (write.value & 0xff) * 0x01010101;
+    }
+    // flash reads are answered a clock after they start
+    tb->dma_ready = dma_pending;
+    tb->dma_rdata = dma_pending ? flash_word(dma_address) : 0;
+    tb->eval();
+    tb->clk = 1;
+    tb->eval();
+
+    if (tb->iomem_valid && tb->iomem_ready) {
+      tb->iomem_valid = 0;
+      tb->iomem_wstrb = 0;
+      next_write++;
+    }
+    if (dma_pending) {
+      dma_pending = false;
+    } else if (tb->dma_valid) {
+      dma_pending = true;
+      dma_address = tb->dma_addr;
+    }
+
+    if (prev_step == STEP_GLOBAL_RIGHT && tb->pipeline_step == STEP_IDLE) {
+      int32_t left = sext14(tb->mixed_left), right = sext14(tb->mixed_right);
+      const TraceSample &expected = samples[passes];
+      if (left != expected.left || right != expected.right) {
+        if (mismatches < MAX_MISMATCHES_SHOWN) {
+          printf("step %llu: audio.v %d %d, model %d %d\n", (unsigned long long)passes,
+                 left, right, expected.left, expected.right);
+        }
+        mismatches++;
+      }
+      passes++;
+    }
+    prev_step = tb->pipeline_step;
+  }
+
+  printf("%llu steps, %zu writes: %llu mismatched\n", (unsigned long long)passes, next_write,
+         (unsigned long long)mismatches);
+  tb->final();
+  delete tb;
+  return mismatches ? 1 : 0;
+}
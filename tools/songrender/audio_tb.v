@@ -0,0 +1,45 @@
+//
+// songrender's testbench top: the audio peripheral, with the pipeline step
+// and the samples sent to the DACs brought out for audio_tb.cpp to check.
+//
+
+module audio_tb (
+  input resetn,
+  input clk,
+  input iomem_valid,
+  input [3:0] iomem_wstrb,
+  input [31:0] iomem_addr,
+  input [31:0] iomem_wdata,
+  output iomem_ready,
+  output [31:0] iomem_rdata,
+  output dma_valid,
+  output [23:0] dma_addr,
+  input dma_ready,
+  input [31:0] dma_rdata,
+  output [4:0] pipeline_step,
+  output [13:0] mixed_left,
+  output [13:0] mixed_right);
+
+  wire audio_out_left, audio_out_right;
+
+  audio #(.NUM_VOICES(8)) dut (
+    .resetn(resetn),
+    .clk(clk),
+    .iomem_valid(iomem_valid),
+    .iomem_wstrb(iomem_wstrb),
+    .iomem_addr(iomem_addr),
+    .iomem_wdata(iomem_wdata),
+    .iomem_ready(iomem_ready),
+    .iomem_rdata(iomem_rdata),
+    .audio_out_left(audio_out_left),
+    .audio_out_right(audio_out_right),
+    .dma_valid(dma_valid),
+    .dma_addr(dma_addr),
+    .dma_ready(dma_ready),
+    .dma_rdata(dma_rdata));
+
+  assign pipeline_step = dut.pipeline_step;
+  assign mixed_left = dut.mixed_left;
+  assign mixed_right = dut.mixed_right;
+
+endmodule
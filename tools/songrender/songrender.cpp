@@ -0,0 +1,222 @@
+/*
+ * songrender - plays a song through the song player and a bit-accurate
+ * model of the audio peripheral (audio_model.cpp), much faster than real
+ * time, and writes it to a WAV file.
+ *
+ * songplayer.c and audio.c are built for the host with AUDIO_HOST defined,
+ * so their register accesses come here instead of going to the hardware.
+ * The song source is compiled in, as for songpack (SONG is the name of its
+ * packed_song_t).  It also reports how many register writes the song
+ * player makes, and can write a trace of them (with the samples the model
+ * produced) for checking the model against audio.v in Verilator (see
+ * audio_tb.cpp).
+ *
+ * See the Makefile for how to run it.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <vector>
+
+#include "audio_model.h"
+
+extern "C" {
+#include <audio/audio.h>
+#include <songplayer/songplayer.h>
+}
+
+#ifndef SONG
+#error "SONG must be defined as the name of the packed_song_t to render"
+#endif
+
+extern "C" const struct packed_song_t SONG;
+
+#define STRINGIFY(x) #x
+#define TOSTRING(x) STRINGIFY(x)
+
+#define TICK_US 20000     // songplayer_tick @ 50Hz
+
+static AudioModel model;
+
+// the PCM samples the song uses, where the peripheral sees them in flash
+struct FlashRegion {
+  uint32_t address;
+  const uint8_t *data;
+  uint32_t length;
+};
+static std::vector<FlashRegion> flash;
+
+extern "C" void audio_host_write(uint32_t offset, uint32_t value, uint32_t bytes) {
+  model.write(offset, value, bytes);
+}
+
+extern "C" uint32_t audio_host_read(uint32_t offset) {
+  return model.read(offset);
+}
+
+static uint8_t flash_read(uint32_t address) {
+  for (const FlashRegion &region : flash) {
+    if (address - region.address < region.length) {
+      return region.data[address - region.address];
+    }
+  }
+  return 0;
+}
+
+static void add_flash_region(const struct audio_sample_t *sample) {
+  uint32_t address = (uint32_t)(uintptr_t)sample->data & 0xffffff;
+  for (const FlashRegion &region : flash) {
+    if (region.address == address) {
+      return;
+    }
+  }
+  flash.push_back({ address, (const uint8_t *)sample->data, sample->length });
+}
+
+static void put_le(FILE *f, uint32_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    fputc((value >> (8 * i)) & 0xff, f);
+  }
+}
+
+static void write_wav_header(FILE *f, uint32_t rate, uint32_t frames) {
+  uint32_t data_bytes = frames * 4;
+  fwrite("RIFF", 1, 4, f);
+  put_le(f, 36 + data_bytes, 4);
+  fwrite("WAVEfmt ", 1, 8, f);
+  put_le(f, 16, 4);
+  put_le(f, 1, 2);            // PCM
+  put_le(f, 2, 2);            // stereo
+  put_le(f, rate, 4);
+  put_le(f, rate * 4, 4);
+  put_le(f, 4, 2);
+  put_le(f, 16, 2);
+  fwrite("data", 1, 4, f);
+  put_le(f, data_bytes, 4);
+}
+
+static void usage(const char *name) {
+  fprintf(stderr, "usage: %s [-o out.wav] [-s seconds] [-r sample rate] [-t trace]\n", name);
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  const char *wav_name = "song.wav";
+  const char *trace_name = NULL;
+  double seconds = 60;
+  uint32_t rate = 44100;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "o:s:r:t:")) != -1) {
+    switch (opt) {
+      case 'o': wav_name = optarg; break;
+      case 's': seconds = atof(optarg); break;
+      case 'r': rate = atoi(optarg); break;
+      case 't': trace_name = optarg; break;
+      default: usage(argv[0]);
+    }
+  }
+  if (seconds <= 0 || rate == 0 || rate > 1000000) {
+    usage(argv[0]);
+  }
+
+  FILE *wav = fopen(wav_name, "wb");
+  if (!wav) {
+    perror(wav_name);
+    return 1;
+  }
+  FILE *trace = NULL;
+  if (trace_name) {
+    trace = fopen(trace_name, "w");
+    if (!trace) {
+      perror(trace_name);
+      return 1;
+    }
+  }
+
+  for (int i = 0; i < 16; i++) {
+    if (SONG.instruments[i].sample) {
+      add_flash_region(SONG.instruments[i].sample);
+    }
+  }
+  model.flash_read = flash_read;
+  if (trace) {
+    // flash contents for the testbench: "f address byte..."
+    for (const FlashRegion &region : flash) {
+      fprintf(trace, "f %06x", region.address);
+      for (uint32_t i = 0; i < region.length; i++) {
+        fprintf(trace, " %02x", region.data[i]);
+      }
+      fprintf(trace, "\n");
+    }
+    model.on_write = [trace](uint64_t step, const AudioModel::Write &write) {
+      fprintf(trace, "w %llu %03x %08x %u\n", (unsigned long long)step, write.offset & 0xfff, write.value, write.bytes);
+    };
+  }
+
+  uint64_t total_steps = (uint64_t)(seconds * 1000000);
+  uint32_t frames = 0;
+  write_wav_header(wav, rate, 0);
+
+  uint32_t total_writes = 0, max_tick_writes = 0, ticks = 0;
+  size_t max_pending = 0;
+  int64_t sum_left = 0, sum_right = 0;
+  uint32_t summed = 0;
+  uint64_t frame_end = 1000000 / rate, frame_fraction = 1000000 % rate;
+
+  songplayer_init(&SONG);
+  songplayer_start(0);
+  audio_shadow_stats = {};
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t step = 0; step < total_steps; step++) {
+    if (step % TICK_US == 0) {
+      size_t before = model.writes_pending();
+      songplayer_tick();
+      uint32_t tick_writes = model.writes_pending() - before;
+      total_writes += tick_writes;
+      max_tick_writes = (tick_writes > max_tick_writes) ? tick_writes : max_tick_writes;
+      max_pending = (model.writes_pending() > max_pending) ? model.writes_pending() : max_pending;
+      ticks++;
+    }
+
+    model.step();
+    if (trace) {
+      fprintf(trace, "s %llu %d %d\n", (unsigned long long)step, model.left(), model.right());
+    }
+
+    // resample by averaging the 1MHz samples making up each output frame
+    sum_left += model.left();
+    sum_right += model.right();
+    summed++;
+    if (step + 1 >= frame_end) {
+      put_le(wav, (uint16_t)(int16_t)((sum_left << 2) / summed), 2);
+      put_le(wav, (uint16_t)(int16_t)((sum_right << 2) / summed), 2);
+      frames++;
+      sum_left = sum_right = 0;
+      summed = 0;
+      frame_fraction += 1000000;
+      frame_end += frame_fraction / rate;
+      frame_fraction %= rate;
+    }
+  }
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  fseek(wav, 0, SEEK_SET);
+  write_wav_header(wav, rate, frames);
+  fclose(wav);
+  if (trace) {
+    fclose(trace);
+  }
+
+  printf("rendered %.1fs of %s to %s in %.2fs (%.0fx real time)\n",
+         seconds, TOSTRING(SONG), wav_name, elapsed, elapsed > 0 ? seconds / elapsed : 0.0);
+  printf("register writes: %u (%.0f/s), at most %u in a tick (%u ticks)\n",
+         total_writes, total_writes / seconds, max_tick_writes, ticks);
+  printf("shadowed writes: %u requested, %u written\n",
+         audio_shadow_stats.requested, audio_shadow_stats.written);
+  printf("write queue: at most %zu writes waiting (one lands per microsecond)\n", max_pending);
+  return 0;
+}
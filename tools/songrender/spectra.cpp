@@ -0,0 +1,228 @@
+/*
+ * spectra - checks the harmonic content of ring modulation and hard sync,
+ * played through the audio model (audio_model.cpp, which "make verify"
+ * checks against audio.v), against ideal references.
+ *
+ * Voice 0 is the (silent) source, and voice 1 plays, at full volume:
+ *
+ * - ring modulation: voice 1's triangle, inverted while voice 0's
+ *   accumulator MSB is set, is the triangle times voice 0's square wave.
+ *   So its partials are at the sums and differences of the triangle's and
+ *   the square's (odd) harmonics, and there's nothing at either frequency
+ *   on its own.
+ * - hard sync: voice 1's sawtooth, restarted every time voice 0 wraps, so
+ *   everything is a harmonic of voice 0's frequency, with the strongest
+ *   ones around voice 1's own frequency.
+ *
+ * The references are the same waveforms worked out in floating point, from
+ * the voices' phases at each microsecond.  Every frequency is a whole
+ * number of cycles in the 2^18 samples measured, so each partial falls in
+ * a single bin.  The partials are compared in dB from the strongest one, and
+ * the run fails if any differs by more than TOLERANCE_DB, or if anything
+ * that should be missing isn't at least MISSING_DB down.  Each is also
+ * played with its modulation off, which the checks have to fail.
+ *
+ * Built and run by "make spectra".
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "audio_model.h"
+
+extern "C" {
+#include <audio/audio.h>
+}
+
+#define POINTS (1 << 18)            // 0.26s at 1MHz, so 3.8Hz a bin
+#define BIN_FREQ 64                 // REG_FREQ for 1 bin (2^24 / POINTS)
+#define SETTLE_STEPS 1000           // for the writes to land
+
+#define TOLERANCE_DB 1.0
+#define MISSING_DB (-40.0)
+#define COMPARED_DB (-40.0)         // partials weaker than this in the reference aren't compared
+
+// ring modulation: voice 0 square at 256 bins (977Hz), voice 1 triangle at 1447 (5520Hz)
+#define RING_SOURCE_BIN 256
+#define RING_CARRIER_BIN 1447
+
+// sync: voice 0 at 256 bins (977Hz, so exactly 1024 samples a cycle), voice 1 sawtooth at 691 (2636Hz)
+#define SYNC_MASTER_BIN 256
+#define SYNC_BIN 691
+
+static std::vector<double> cos_table, sin_table;
+
+// |X[bin]|^2 of the whole of x
+static double bin_power(const std::vector<double> &x, uint32_t bin) {
+  double re = 0, im = 0;
+  for (uint32_t n = 0; n < POINTS; n++) {
+    uint32_t i = (uint32_t)(((uint64_t)bin * n) % POINTS);
+    re += x[n] * cos_table[i];
+    im -= x[n] * sin_table[i];
+  }
+  return re * re + im * im;
+}
+
+static double db(double power, double reference) {
+  return (power > 0) ? 10 * log10(power / reference) : -999;
+}
+
+// voice 1's output through the model, with voice 0 as its source
+static std::vector<double> play(uint32_t source_freq, uint32_t freq, uint32_t waveform, uint32_t modulation) {
+  AudioModel model;
+  auto write = [&model](uint32_t reg, uint32_t value) {
+    model.write(reg << 2, value, 4);
+  };
+  write(REG_GLOBAL_VOLUME, 255);
+  write(REG_FREQ, source_freq);
+  write(REG_WAVESELECT, WAVE_SQUARE << 16);
+  write(REG_PULSEWIDTH, 0x7ff);
+  write(REG_VOLUME, 0);
+  write(AUDIO_VOICE_STRIDE + REG_FREQ, freq);
+  write(AUDIO_VOICE_STRIDE + REG_WAVESELECT, (waveform << 16) | modulation);
+  write(AUDIO_VOICE_STRIDE + REG_VOLUME, 255);
+  for (int i = 0; i < SETTLE_STEPS; i++) {
+    model.step();
+  }
+  std::vector<double> x(POINTS);
+  for (uint32_t n = 0; n < POINTS; n++) {
+    model.step();
+    x[n] = model.left();
+  }
+  return x;
+}
+
+static double phase(uint32_t bin, uint32_t n) {
+  return (double)(((uint64_t)bin * n) % POINTS) / POINTS;
+}
+
+static std::vector<double> ring_reference() {
+  std::vector<double> x(POINTS);
+  for (uint32_t n = 0; n < POINTS; n++) {
+    double triangle = 1 - 4 * fabs(phase(RING_CARRIER_BIN, n) - 0.5);
+    double square = (phase(RING_SOURCE_BIN, n) < 0.5) ? 1 : -1;
+    x[n] = triangle * square;
+  }
+  return x;
+}
+
+static std::vector<double> sync_reference() {
+  std::vector<double> x(POINTS);
+  uint32_t period = POINTS / SYNC_MASTER_BIN;
+  for (uint32_t n = 0; n < POINTS; n++) {
+    double p = (double)SYNC_BIN * (n % period) / POINTS;
+    x[n] = 2 * (p - floor(p)) - 1;
+  }
+  return x;
+}
+
+struct Partial {
+  const char *name;
+  uint32_t bin;
+};
+
+// compares the partials of x with the reference's; returns whether they all match
+static bool compare(const char *title, const std::vector<double> &x, const std::vector<double> &reference,
+                    const std::vector<Partial> &partials) {
+  std::vector<double> power(partials.size()), reference_power(partials.size());
+  double peak = 0, reference_peak = 0;
+  for (size_t i = 0; i < partials.size(); i++) {
+    power[i] = bin_power(x, partials[i].bin);
+    reference_power[i] = bin_power(reference, partials[i].bin);
+    peak = fmax(peak, power[i]);
+    reference_peak = fmax(reference_peak, reference_power[i]);
+  }
+
+  printf("%s\n\n", title);
+  printf("| Partial           | Hz      | Reference | Model    |\n");
+  printf("|-------------------|---------|-----------|----------|\n");
+  bool ok = true;
+  for (size_t i = 0; i < partials.size(); i++) {
+    double level = db(power[i], peak), reference_level = db(reference_power[i], reference_peak);
+    bool missing = reference_level < MISSING_DB;
+    bool match = missing ? level < MISSING_DB
+               : reference_level < COMPARED_DB || fabs(level - reference_level) <= TOLERANCE_DB;
+    ok = ok && match;
+    printf("| %-17s | %7.1f | %7.1fdB | %6.1fdB |%s\n", partials[i].name, partials[i].bin * 1000000.0 / POINTS,
+           reference_level, level, match ? "" : " <- wrong");
+  }
+  printf("\n");
+  return ok;
+}
+
+// the share of x's power (other than DC) that isn't at a harmonic of bin
+static double inharmonic_db(const std::vector<double> &x, uint32_t bin) {
+  double mean = 0, total = 0, harmonic = 0;
+  for (double v : x) {
+    mean += v;
+  }
+  mean /= POINTS;
+  for (double v : x) {
+    total += (v - mean) * (v - mean);
+  }
+  total *= POINTS;                  // (Parseval)
+  for (uint32_t b = bin; b <= POINTS / 2; b += bin) {
+    harmonic += bin_power(x, b) * ((b == POINTS / 2) ? 1 : 2);
+  }
+  return db(fmax(total - harmonic, 0), total);
+}
+
+static bool check_ring(bool modulation) {
+  std::vector<Partial> partials = {
+    { "fc - fs", RING_CARRIER_BIN - RING_SOURCE_BIN },
+    { "fc + fs", RING_CARRIER_BIN + RING_SOURCE_BIN },
+    { "fc - 3fs", RING_CARRIER_BIN - 3 * RING_SOURCE_BIN },
+    { "fc + 3fs", RING_CARRIER_BIN + 3 * RING_SOURCE_BIN },
+    { "fc - 5fs", RING_CARRIER_BIN - 5 * RING_SOURCE_BIN },
+    { "fc + 5fs", RING_CARRIER_BIN + 5 * RING_SOURCE_BIN },
+    { "3fc - fs", 3 * RING_CARRIER_BIN - RING_SOURCE_BIN },
+    { "3fc + fs", 3 * RING_CARRIER_BIN + RING_SOURCE_BIN },
+    { "fc (missing)", RING_CARRIER_BIN },
+    { "3fc (missing)", 3 * RING_CARRIER_BIN },
+    { "fs (missing)", RING_SOURCE_BIN },
+  };
+  return compare(modulation ? "Ring modulation" : "Ring modulation off (should fail)",
+                 play(RING_SOURCE_BIN * BIN_FREQ, RING_CARRIER_BIN * BIN_FREQ, WAVE_TRIANGLE, modulation ? WAVE_RINGMOD : 0),
+                 ring_reference(), partials);
+}
+
+static bool check_sync(bool modulation) {
+  std::vector<Partial> partials;
+  static const char *names[] = { "f0", "2f0", "3f0", "4f0", "5f0", "6f0", "7f0", "8f0", "9f0", "10f0" };
+  for (uint32_t h = 1; h <= 10; h++) {
+    partials.push_back({ names[h - 1], h * SYNC_MASTER_BIN });
+  }
+  partials.push_back({ "voice 1 (missing)", SYNC_BIN });
+  std::vector<double> x = play(SYNC_MASTER_BIN * BIN_FREQ, SYNC_BIN * BIN_FREQ, WAVE_SAWTOOTH, modulation ? WAVE_SYNC : 0);
+  bool ok = compare(modulation ? "Hard sync" : "Hard sync off (should fail)", x, sync_reference(), partials);
+  double inharmonic = inharmonic_db(x, SYNC_MASTER_BIN);
+  bool periodic = inharmonic < MISSING_DB;
+  if (inharmonic > -999) {
+    printf("power not at a harmonic of f0: %.1fdB%s\n\n", inharmonic, periodic ? "" : " <- wrong");
+  } else {
+    printf("power not at a harmonic of f0: none\n\n");
+  }
+  return ok && periodic;
+}
+
+int main() {
+  cos_table.resize(POINTS);
+  sin_table.resize(POINTS);
+  for (uint32_t i = 0; i < POINTS; i++) {
+    cos_table[i] = cos(2 * M_PI * i / POINTS);
+    sin_table[i] = sin(2 * M_PI * i / POINTS);
+  }
+
+  bool ring = check_ring(true);
+  bool sync = check_sync(true);
+  bool ring_off = check_ring(false);
+  bool sync_off = check_sync(false);
+
+  printf("ring modulation: %s, hard sync: %s\n", ring ? "ok" : "FAILED", sync ? "ok" : "FAILED");
+  if (ring_off || sync_off) {
+    printf("the checks passed with the modulation off, so they can't tell\n");
+    return 1;
+  }
+  return (ring && sync) ? 0 : 1;
+}
@@ -0,0 +1,643 @@
+/*
+ * songseq - converts a packed song into a program for the audio sequencer
+ * (hdl/picosoc/audio/audio_sequencer.v), so it can play from flash without
+ * any CPU time.  Written to stdout as C source (an audio_sequence_t).
+ *
+ * The song player runs on the host (built with AUDIO_HOST, as for
+ * songrender), one 50Hz tick at a time, and the register writes each tick
+ * makes become sequencer writes, with a SEQ_WAIT between ticks.  Writes are
+ * narrowed to the bytes that change (SEQ_WRITE_BYTE / SEQ_WRITE_HALF take one
+ * word instead of two), except that a write with the envelope gate or PCM
+ * play bit set always writes the byte that triggers them.
+ *
+ * The song is played until its position repeats.  The sequence then plays
+ * the start of the song once, and loops over one pass of the part that
+ * repeats; the pass is only used once the next pass has made exactly the same
+ * writes (and left the registers the same), so the loop plays the same as the
+ * song player would, forever.
+ *
+ * -e bar adds a sound effect: the bar played (as songplayer_trigger_effect
+ * would) on the sound effect voice, for a sequencer track of its own.
+ *
+ * -c seconds plays the sequences through a model of the sequencer, and
+ * checks that they leave the registers (and trigger the envelopes and the
+ * PCM voice) exactly as the song player does, after every tick.
+ *
+ * See the Makefile for how to run it.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <map>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <audio/audio.h>
+#include <songplayer/songplayer.h>
+}
+
+#ifndef SONG
+#error "SONG must be defined as the name of the packed_song_t to convert"
+#endif
+
+extern "C" const struct packed_song_t SONG;
+extern "C" struct globalctrl_t globalctrl;
+extern "C" struct channelctrl_t channelctrl[SONGPLAYER_NUM_CHANNELS];
+extern "C" struct sfx_slot_t sfx_slots[SONGPLAYER_SFX_SLOTS];
+
+#define STRINGIFY(x) #x
+#define TOSTRING(x) STRINGIFY(x)
+
+#define TICK_HZ 50
+#define MAX_TICKS (30 * 60 * TICK_HZ)   // give up looking for the loop after 30 minutes
+#define MAX_EFFECT_TICKS (60 * TICK_HZ)
+#define MAX_PASSES 6                    // passes of the loop to compare
+#define MAX_WAIT 0xffff
+
+// the sequencer can write the voice and global registers, and the wavetables
+#define SEQ_SPACE 0x600
+#define PCM_REGS_START (REG_PCM_START << 2)
+#define PCM_REGS_END ((REG_PCM_CTRL + 1) << 2)
+
+struct Write {
+  uint32_t offset;      // byte offset into the peripheral
+  uint32_t value;
+  uint32_t bytes;       // 4, or 1 for a byte write
+};
+
+typedef std::vector<Write> Tick;
+
+static Tick *recording = nullptr;
+
+extern "C" void audio_host_write(uint32_t offset, uint32_t value, uint32_t bytes) {
+  if (recording) {
+    recording->push_back({ offset & 0xfff, value, bytes });
+  }
+}
+
+extern "C" uint32_t audio_host_read(uint32_t offset) {
+  return 0;
+}
+
+static void fail(const char *message) {
+  fprintf(stderr, "songseq: %s\n", message);
+  exit(1);
+}
+
+// a write as byte strobes, and the data for the whole word
+static void write_lanes(const Write &write, uint32_t *word, uint32_t *strobe, uint32_t *data) {
+  uint32_t lane = write.offset & 3;
+  *word = write.offset & ~3u;
+  *strobe = (write.bytes == 4) ? 0xf : (write.bytes == 2) ? (3 << (lane & 2)) : (1 << lane);
+  *data = (write.bytes == 4) ? write.value
+        : (write.bytes == 2) ? (write.value & 0xffff) * 0x00010001
+        : (write.value & 0xff) * 0x01010101;
+}
+
+// the byte strobe that triggers an envelope (gate bit) or the PCM voice (play bit), if this write does
+static uint32_t trigger_strobe(uint32_t word, uint32_t strobe, uint32_t data) {
+  if (!(strobe & 4)) {
+    return 0;
+  }
+  if (word < (REG_GLOBAL_VOLUME << 2) && ((word >> 2) & (AUDIO_VOICE_STRIDE - 1)) == REG_ENVELOPE
+      && (data & ENV_GATE)) {
+    return 4;
+  }
+  if (word == (REG_PCM_CTRL << 2) && (data & PCM_PLAY)) {
+    return 4;
+  }
+  return 0;
+}
+
+// what the peripheral's writable bytes hold, as far as the sequence knows
+struct Registers {
+  uint8_t value[SEQ_SPACE] = {};
+  uint8_t known[SEQ_SPACE] = {};
+
+  bool operator==(const Registers &other) const {
+    return memcmp(value, other.value, sizeof(value)) == 0 && memcmp(known, other.known, sizeof(known)) == 0;
+  }
+};
+
+// builds a program, narrowing the writes to the bytes that change
+class Encoder {
+public:
+  std::vector<uint32_t> program;
+  Registers registers;
+  uint32_t writes = 0, dropped = 0;
+
+  void tick(const Tick &tick) {
+    for (const Write &write : tick) {
+      encode(write);
+    }
+    wait_ticks++;
+  }
+
+  void flush_wait() {
+    while (wait_ticks > 0) {
+      uint32_t ticks = (wait_ticks > MAX_WAIT) ? MAX_WAIT : wait_ticks;
+      program.push_back(SEQ_WAIT(ticks));
+      wait_ticks -= ticks;
+    }
+  }
+
+  void drop_wait() {
+    wait_ticks = 0;
+  }
+
+private:
+  uint32_t wait_ticks = 0;
+
+  void encode(const Write &write) {
+    uint32_t word, strobe, data;
+    write_lanes(write, &word, &strobe, &data);
+    if (word >= SEQ_SPACE) {
+      dropped++;
+      return;
+    }
+
+    uint32_t changed = trigger_strobe(word, strobe, data);
+    for (int byte = 0; byte < 4; byte++) {
+      uint8_t b = data >> (8 * byte);
+      if ((strobe & (1 << byte)) && (!registers.known[word + byte] || registers.value[word + byte] != b)) {
+        changed |= 1 << byte;
+      }
+    }
+    if (changed == 0) {
+      return;
+    }
+    for (int byte = 0; byte < 4; byte++) {
+      if (changed & (1 << byte)) {
+        registers.value[word + byte] = data >> (8 * byte);
+        registers.known[word + byte] = 1;
+      }
+    }
+
+    flush_wait();
+    writes++;
+    if ((changed & (changed - 1)) == 0) {
+      int byte = __builtin_ctz(changed);
+      program.push_back(SEQ_WRITE_BYTE(word + byte, data >> (8 * byte)));
+    } else if ((changed & 0xc) == 0) {
+      program.push_back(SEQ_WRITE_HALF(word, data));
+    } else if ((changed & 0x3) == 0) {
+      program.push_back(SEQ_WRITE_HALF(word + 2, data >> 16));
+    } else {
+      // (the unchanged bytes are rewritten with what they already hold)
+      uint32_t value = 0;
+      for (int byte = 0; byte < 4; byte++) {
+        value |= (uint32_t)registers.value[word + byte] << (8 * byte);
+      }
+      program.push_back(SEQ_WRITE(word));
+      program.push_back(value);
+    }
+  }
+};
+
+struct Sequence {
+  std::string name;
+  std::string comment;
+  std::vector<uint32_t> program;
+  int loop = -1;        // word index of the loop, or -1 to stop at SEQ_END
+  uint32_t writes = 0;
+};
+
+// start the song player as it would be after a reset (songplayer_init
+// leaves the sound effect channel as it was)
+static void reset_player() {
+  memset(channelctrl, 0, sizeof(channelctrl));
+  audio_shadow_invalidate();
+}
+
+// the song, a tick at a time (the first "tick" is songplayer_init's writes)
+static std::vector<Tick> record_song(uint32_t ticks, std::vector<uint32_t> *row_keys) {
+  std::vector<Tick> song(ticks + 1);
+  recording = &song[0];
+  reset_player();
+  songplayer_init(&SONG);
+  songplayer_start(0);
+  for (uint32_t t = 1; t <= ticks; t++) {
+    recording = &song[t];
+    songplayer_tick();
+    if (row_keys) {
+      // (the position each row is played from, or ~0 between rows)
+      row_keys->push_back(globalctrl.tick_div_count == 0
+                          ? ((uint32_t)globalctrl.song_pos << 16) | ((uint32_t)globalctrl.song_row << 8)
+                            | (uint32_t)globalctrl.ticks_per_div
+                          : ~0u);
+    }
+  }
+  recording = nullptr;
+  return song;
+}
+
+static Sequence convert_song(const std::string &name) {
+  // play until the position comes round again, then for enough passes to compare
+  std::vector<uint32_t> keys;
+  std::vector<Tick> song = record_song(MAX_TICKS, &keys);
+
+  std::map<uint32_t, uint32_t> first_seen;
+  std::vector<uint32_t> passes;     // the ticks where each pass starts
+  for (uint32_t t = 0; t < keys.size() && passes.size() < MAX_PASSES + 1; t++) {
+    if (keys[t] == ~0u) {
+      continue;
+    }
+    if (passes.empty()) {
+      auto seen = first_seen.find(keys[t]);
+      if (seen == first_seen.end()) {
+        first_seen[keys[t]] = t;
+      } else {
+        passes.push_back(seen->second + 1);
+        passes.push_back(t + 1);
+      }
+    } else if (keys[t] == keys[passes[0] - 1]) {
+      passes.push_back(t + 1);
+    }
+  }
+
+  // the registers (as the sequence leaves them) where each pass starts
+  std::vector<Registers> pass_registers;
+  Encoder dry_run;
+  for (uint32_t t = 0, p = 0; t < song.size() && p < passes.size(); t++) {
+    if (t == passes[p]) {
+      pass_registers.push_back(dry_run.registers);
+      p++;
+    }
+    dry_run.tick(song[t]);
+  }
+
+  // the first pass that the next one repeats exactly
+  int loop_pass = -1;
+  for (uint32_t p = 0; p + 2 < pass_registers.size() && loop_pass < 0; p++) {
+    uint32_t length = passes[p + 1] - passes[p];
+    if (passes[p + 2] - passes[p + 1] != length || !(pass_registers[p] == pass_registers[p + 1])) {
+      continue;
+    }
+    bool same = true;
+    for (uint32_t t = 0; t < length && same; t++) {
+      const Tick &a = song[passes[p] + t], &b = song[passes[p + 1] + t];
+      same = a.size() == b.size();
+      for (size_t w = 0; w < a.size() && same; w++) {
+        same = a[w].offset == b[w].offset && a[w].value == b[w].value && a[w].bytes == b[w].bytes;
+      }
+    }
+    if (same) {
+      loop_pass = p;
+    }
+  }
+
+  Sequence sequence;
+  sequence.name = name;
+  Encoder encoder;
+  char comment[160];
+  if (loop_pass < 0) {
+    fprintf(stderr, "songseq: warning: %s doesn't repeat within %d minutes; the sequence stops there\n",
+            TOSTRING(SONG), MAX_TICKS / TICK_HZ / 60);
+    for (const Tick &tick : song) {
+      encoder.tick(tick);
+    }
+    snprintf(comment, sizeof(comment), "%s, played for %d minutes", TOSTRING(SONG), MAX_TICKS / TICK_HZ / 60);
+  } else {
+    uint32_t loop_start = passes[loop_pass], loop_end = passes[loop_pass + 1];
+    for (uint32_t t = 0; t < loop_end; t++) {
+      if (t == loop_start) {
+        encoder.flush_wait();
+        sequence.loop = encoder.program.size();
+      }
+      encoder.tick(song[t]);
+    }
+    encoder.flush_wait();
+    snprintf(comment, sizeof(comment), "%s: %u ticks, then a loop of %u ticks (%.1fs)", TOSTRING(SONG),
+             loop_start - 1, loop_end - loop_start, (double)(loop_end - loop_start) / TICK_HZ);
+  }
+  encoder.program.push_back(SEQ_END);
+  sequence.comment = comment;
+  sequence.program = encoder.program;
+  sequence.writes = encoder.writes;
+  if (encoder.dropped) {
+    fprintf(stderr, "songseq: warning: %u writes outside the registers and wavetables were dropped\n", encoder.dropped);
+  }
+  return sequence;
+}
+
+// the writes a bar makes as a sound effect, on the sound effect voice
+static bool effect_write(const Write &write) {
+  uint32_t voice = SONGPLAYER_SFX_CHANNEL;
+  uint32_t regs = voice * AUDIO_VOICE_STRIDE * 4;
+  uint32_t wavetable = AUDIO_WAVETABLE_OFFSET + voice * AUDIO_WAVETABLE_SIZE;
+  return (write.offset >= regs && write.offset < regs + AUDIO_VOICE_STRIDE * 4)
+         || (write.offset >= wavetable && write.offset < wavetable + AUDIO_WAVETABLE_SIZE)
+         || (write.offset >= PCM_REGS_START && write.offset < PCM_REGS_END);
+}
+
+static std::vector<Tick> record_effect(uint32_t bar) {
+  std::vector<Tick> effect;
+  reset_player();
+  songplayer_init(&SONG);
+  songplayer_stop();
+  audio_shadow_invalidate();
+  songplayer_trigger_effect(bar);
+  for (uint32_t t = 0; t < MAX_EFFECT_TICKS; t++) {
+    effect.emplace_back();
+    recording = &effect.back();
+    songplayer_tick();
+    recording = nullptr;
+    if (!sfx_slots[0].active) {
+      break;
+    }
+  }
+  return effect;
+}
+
+static Sequence convert_effect(const std::string &name, uint32_t bar) {
+  if (bar >= SONG.num_bars) {
+    fail("the effect's bar isn't in the song");
+  }
+  std::vector<Tick> effect = record_effect(bar);
+  uint32_t others = 0;
+  for (Tick &tick : effect) {
+    size_t kept = 0;
+    for (const Write &write : tick) {
+      if (effect_write(write)) {
+        tick[kept++] = write;
+      }
+    }
+    others += tick.size() - kept;
+    tick.resize(kept);
+  }
+  if (others) {
+    fprintf(stderr, "songseq: warning: bar %u's %u writes to other voices (or global registers) were dropped\n",
+            bar, others);
+  }
+
+  Encoder encoder;
+  for (const Tick &tick : effect) {
+    encoder.tick(tick);
+  }
+  encoder.drop_wait();
+  encoder.program.push_back(SEQ_END);
+
+  Sequence sequence;
+  char comment[160];
+  snprintf(comment, sizeof(comment), "bar %u of %s, on voice %d: %zu ticks", bar, TOSTRING(SONG),
+           SONGPLAYER_SFX_CHANNEL, effect.size());
+  sequence.name = name;
+  sequence.comment = comment;
+  sequence.program = encoder.program;
+  sequence.writes = encoder.writes;
+  return sequence;
+}
+
+////////////////////////////////////////////////////////////////////
+// Checking
+////////////////////////////////////////////////////////////////////
+
+// the registers, and how many times each envelope (and the PCM voice) was triggered
+struct Peripheral {
+  uint8_t value[SEQ_SPACE] = {};
+  uint32_t triggers[AUDIO_NUM_VOICES + 1] = {};
+
+  void write(uint32_t word, uint32_t strobe, uint32_t data) {
+    if (word >= SEQ_SPACE) {
+      return;
+    }
+    for (int byte = 0; byte < 4; byte++) {
+      if (strobe & (1 << byte)) {
+        value[word + byte] = data >> (8 * byte);
+      }
+    }
+    if (trigger_strobe(word, strobe, data)) {
+      triggers[(word < (REG_GLOBAL_VOLUME << 2)) ? word / (AUDIO_VOICE_STRIDE * 4) : AUDIO_NUM_VOICES]++;
+    }
+  }
+
+  void write(const Write &write) {
+    uint32_t word, strobe, data;
+    write_lanes(write, &word, &strobe, &data);
+    this->write(word, strobe, data);
+  }
+
+  bool operator==(const Peripheral &other) const {
+    return memcmp(value, other.value, sizeof(value)) == 0 && memcmp(triggers, other.triggers, sizeof(triggers)) == 0;
+  }
+};
+
+// a model of one sequencer track, a tick at a time
+class Track {
+public:
+  explicit Track(const Sequence &sequence) : sequence(sequence) {}
+
+  // the commands up to the next SEQ_WAIT (or the end)
+  void tick(Peripheral &peripheral) {
+    if (wait > 0 && --wait > 0) {
+      return;
+    }
+    for (uint32_t commands = 0; playing; commands++) {
+      if (pc >= sequence.program.size() || commands > sequence.program.size()) {
+        fail("the sequence ran off its end, or loops without waiting");
+      }
+      uint32_t command = sequence.program[pc++];
+      uint32_t addr = (command >> 16) & 0x7ff;
+      switch (command >> 28) {
+        case 0:     // SEQ_END
+          if (sequence.loop >= 0) {
+            pc = sequence.loop;
+          } else {
+            playing = false;
+          }
+          break;
+        case 1:     // SEQ_WAIT
+          wait = command & 0xffff;
+          if (wait > 0) {
+            return;
+          }
+          break;
+        case 2:     // SEQ_WRITE
+          peripheral.write(addr & ~3u, 0xf, sequence.program[pc++]);
+          break;
+        case 3:     // SEQ_WRITE_BYTE
+          peripheral.write(addr & ~3u, 1 << (addr & 3), (command & 0xff) * 0x01010101);
+          break;
+        case 4:     // SEQ_WRITE_HALF
+          peripheral.write(addr & ~3u, 3 << (addr & 2), (command & 0xffff) * 0x00010001);
+          break;
+        default:
+          playing = false;
+          break;
+      }
+    }
+  }
+
+  bool playing = true;
+
+private:
+  const Sequence &sequence;
+  uint32_t pc = 0;
+  uint32_t wait = 0;
+};
+
+static bool check_song(const Sequence &sequence, double seconds) {
+  uint32_t ticks = (uint32_t)(seconds * TICK_HZ);
+  std::vector<Tick> song = record_song(ticks, nullptr);
+  Peripheral expected, played;
+  Track track(sequence);
+  for (uint32_t t = 0; t <= ticks; t++) {
+    for (const Write &write : song[t]) {
+      expected.write(write);
+    }
+    track.tick(played);
+    if (!(expected == played)) {
+      fprintf(stderr, "songseq: %s differs from the song player after %u ticks\n", sequence.name.c_str(), t);
+      return false;
+    }
+  }
+  fprintf(stderr, "songseq: %s matches the song player after every tick, for %u ticks (%.0fs)\n",
+          sequence.name.c_str(), ticks, (double)ticks / TICK_HZ);
+  return true;
+}
+
+static bool check_effect(const Sequence &sequence, uint32_t bar) {
+  std::vector<Tick> effect = record_effect(bar);
+  Peripheral expected, played;
+  Track track(sequence);
+  for (uint32_t t = 0; t < effect.size(); t++) {
+    for (const Write &write : effect[t]) {
+      if (effect_write(write)) {
+        expected.write(write);
+      }
+    }
+    track.tick(played);
+    if (!(expected == played)) {
+      fprintf(stderr, "songseq: %s differs from the song player after %u ticks\n", sequence.name.c_str(), t);
+      return false;
+    }
+  }
+  track.tick(played);
+  if (track.playing) {
+    fprintf(stderr, "songseq: %s doesn't stop when the effect does\n", sequence.name.c_str());
+    return false;
+  }
+  fprintf(stderr, "songseq: %s matches the song player after every tick, for %zu ticks\n",
+          sequence.name.c_str(), effect.size());
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+// Output
+////////////////////////////////////////////////////////////////////
+
+static const char *register_names[AUDIO_VOICE_STRIDE] = {
+  "FREQ", "PULSEWIDTH", "WAVEPARAMS", "VOLUME", "ENVELOPE", "LFO", "MIX", "STATUS"
+};
+static const char *global_names[] = {
+  "GLOBAL_VOLUME", "PCM_START", "PCM_LENGTH", "PCM_LOOP", "PCM_RATE", "PCM_CTRL", "FILTER", "STATUS"
+};
+
+static std::string describe(uint32_t addr) {
+  char name[40];
+  if (addr >= AUDIO_WAVETABLE_OFFSET) {
+    snprintf(name, sizeof(name), "voice %u wavetable", (addr - AUDIO_WAVETABLE_OFFSET) / AUDIO_WAVETABLE_SIZE);
+  } else if (addr >= (REG_GLOBAL_VOLUME << 2)) {
+    snprintf(name, sizeof(name), "%s", global_names[(addr >> 2) & 7]);
+  } else {
+    snprintf(name, sizeof(name), "voice %u %s", addr / (AUDIO_VOICE_STRIDE * 4), register_names[(addr >> 2) & 7]);
+  }
+  return name;
+}
+
+static void print_sequence(const Sequence &sequence) {
+  printf("\n// %s\n", sequence.comment.c_str());
+  printf("// %zu words (%zu bytes of flash), %u writes\n", sequence.program.size(),
+         sequence.program.size() * 4, sequence.writes);
+  printf("static const uint32_t %s_program[] = {\n", sequence.name.c_str());
+  const std::vector<uint32_t> &program = sequence.program;
+  for (size_t pc = 0; pc < program.size(); pc++) {
+    uint32_t command = program[pc];
+    uint32_t addr = (command >> 16) & 0x7ff;
+    if ((int)pc == sequence.loop) {
+      printf("  // loop\n");
+    }
+    switch (command >> 28) {
+      case 0:
+        printf("  SEQ_END,\n");
+        break;
+      case 1:
+        printf("  SEQ_WAIT(%u),\n", command & 0xffff);
+        break;
+      case 2:
+        printf("  SEQ_WRITE(0x%03x), 0x%08x,   // %s\n", addr, program[pc + 1], describe(addr).c_str());
+        pc++;
+        break;
+      case 3:
+        printf("  SEQ_WRITE_BYTE(0x%03x, 0x%02x),   // %s\n", addr, command & 0xff, describe(addr).c_str());
+        break;
+      case 4:
+        printf("  SEQ_WRITE_HALF(0x%03x, 0x%04x),   // %s\n", addr, command & 0xffff, describe(addr).c_str());
+        break;
+    }
+  }
+  printf("};\n\n");
+  printf("const struct audio_sequence_t %s = {\n", sequence.name.c_str());
+  printf("  .program = %s_program,\n", sequence.name.c_str());
+  if (sequence.loop >= 0) {
+    printf("  .loop = %s_program + %d\n", sequence.name.c_str(), sequence.loop);
+  } else {
+    printf("  .loop = NULL\n");
+  }
+  printf("};\n");
+}
+
+static void usage(const char *name) {
+  fprintf(stderr, "usage: %s [-n name] [-e bar]... [-c seconds] > out.c\n", name);
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  std::string name = std::string(TOSTRING(SONG)) + "_sequence";
+  std::vector<uint32_t> effect_bars;
+  double check_seconds = 0;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:e:c:")) != -1) {
+    switch (opt) {
+      case 'n': name = optarg; break;
+      case 'e': effect_bars.push_back(strtoul(optarg, NULL, 0)); break;
+      case 'c': check_seconds = atof(optarg); break;
+      default: usage(argv[0]);
+    }
+  }
+  if (optind != argc || check_seconds < 0) {
+    usage(argv[0]);
+  }
+
+  std::vector<Sequence> sequences;
+  sequences.push_back(convert_song(name));
+  for (uint32_t bar : effect_bars) {
+    sequences.push_back(convert_effect(std::string(TOSTRING(SONG)) + "_effect_" + std::to_string(bar), bar));
+  }
+
+  if (check_seconds > 0) {
+    bool ok = check_song(sequences[0], check_seconds);
+    for (size_t i = 0; i < effect_bars.size(); i++) {
+      ok = check_effect(sequences[i + 1], effect_bars[i]) && ok;
+    }
+    if (!ok) {
+      return 1;
+    }
+  }
+
+  printf("// converted from %s by tools/songseq - do not edit\n", TOSTRING(SONG));
+  printf("#include <stddef.h>\n");
+  printf("#include <audio/audio.h>\n");
+  for (const Sequence &sequence : sequences) {
+    print_sequence(sequence);
+  }
+
+  for (const Sequence &sequence : sequences) {
+    fprintf(stderr, "songseq: %s: %zu words, %u writes\n", sequence.name.c_str(), sequence.program.size(),
+            sequence.writes);
+  }
+  return 0;
+}